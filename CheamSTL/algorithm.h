@@ -0,0 +1,271 @@
+#ifndef CHEAMSTL_ALGORITHM_H_
+#define CHEAMSTL_ALGORITHM_H_
+
+/* 带执行策略的 for_each / transform / count_if / reduce
+ * execution::seq 版本就是普通的循环；execution::par 版本把区间切成若干块，放到 work_stealing_pool 上并行执行。
+ *
+ * 链表没有随机访问，切块只能顺序走一遍：
+ * 1. 传入容器（例如 cheamstl::list）时直接用 size() 得到元素个数，只需要走一遍记下每块的起点
+ * 2. 传入迭代器区间时要先用 distance 数一遍，再走一遍切块，因此迭代器至少是前向迭代器，
+ *    单趟的输入迭代器（例如 istream_iterator）不匹配并行版本
+ * 块的数量是线程数的若干倍，块之间负载不均时由线程池的工作窃取来平衡；
+ * 元素太少（不足两块）时直接退化为串行版本。
+ * 传给并行版本的函数对象会被多个线程同时调用，需要自己保证线程安全；reduce 的 op 必须满足结合律 */
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "execution.h"
+#include "iterator.h"
+#include "thread_pool.h"
+
+namespace cheamstl
+{
+
+    /* 每块至少这么多个元素，太小的块调度开销超过收益 */
+    constexpr size_t parallel_min_chunk = 1024;
+    /* 每个线程平均分到的块数，多切一些让工作窃取有余地 */
+    constexpr size_t parallel_chunks_per_thread = 4;
+
+    /* 已知 [first, first + n) 的长度，走一遍求出各块的起点，结果的最后一个元素是区间末尾 */
+    template <class Iter>
+    std::vector<Iter> split_range(Iter first, size_t n, size_t chunks)
+    {
+        std::vector<Iter> points;
+        points.reserve(chunks + 1);
+        size_t base = n / chunks;
+        size_t extra = n % chunks;
+        points.push_back(first);
+        for (size_t i = 0; i < chunks; ++i)
+        {
+            cheamstl::advance(first, base + (i < extra ? 1 : 0));
+            points.push_back(first);
+        }
+        return points;
+    }
+
+    /* n 个元素切成几块，返回 0 或 1 表示不值得并行 */
+    inline size_t parallel_chunk_count(size_t n, work_stealing_pool &pool)
+    {
+        size_t chunks = n / parallel_min_chunk;
+        size_t limit = pool.size() * parallel_chunks_per_thread;
+        return chunks < limit ? chunks : limit;
+    }
+
+    /* 容器重载的约束：有 size() 成员，且不是迭代器 */
+    template <class Container, class = void>
+    struct is_sized_range : std::false_type
+    {
+    };
+
+    template <class Container>
+    struct is_sized_range<Container, decltype((void)std::declval<Container &>().size(),
+                                              (void)std::declval<Container &>().begin())> : std::true_type
+    {
+    };
+
+    /*****************************************************************************************/
+    // for_each
+
+    template <class Iter, class UnaryFunction>
+    void for_each(execution::sequenced_policy, Iter first, Iter last, UnaryFunction f)
+    {
+        for (; first != last; ++first)
+            f(*first);
+    }
+
+    template <class Iter, class UnaryFunction>
+    void parallel_for_each_n(Iter first, size_t n, UnaryFunction &f)
+    {
+        work_stealing_pool &pool = work_stealing_pool::instance();
+        size_t chunks = parallel_chunk_count(n, pool);
+        if (chunks < 2)
+        {
+            for (; n > 0; --n, ++first)
+                f(*first);
+            return;
+        }
+        std::vector<Iter> points = split_range(first, n, chunks);
+        pool.parallel_for(chunks, [&](size_t i)
+                          {
+            for (Iter it = points[i]; it != points[i + 1]; ++it)
+                f(*it); });
+    }
+
+    template <class Iter, class UnaryFunction,
+              typename std::enable_if<cheamstl::is_forward_iterator<Iter>::value, int>::type = 0>
+    void for_each(execution::parallel_policy, Iter first, Iter last, UnaryFunction f)
+    {
+        parallel_for_each_n(first, static_cast<size_t>(cheamstl::distance(first, last)), f);
+    }
+
+    template <class Container, class UnaryFunction,
+              typename std::enable_if<is_sized_range<Container>::value, int>::type = 0>
+    void for_each(execution::parallel_policy, Container &c, UnaryFunction f)
+    {
+        parallel_for_each_n(c.begin(), c.size(), f);
+    }
+
+    /*****************************************************************************************/
+    // transform：输出区间也要能切块，因此 d_first 至少是前向迭代器，与输入同步前进
+
+    template <class InputIter, class OutputIter, class UnaryOperation>
+    OutputIter transform(execution::sequenced_policy, InputIter first, InputIter last, OutputIter d_first,
+                         UnaryOperation op)
+    {
+        for (; first != last; ++first, ++d_first)
+            *d_first = op(*first);
+        return d_first;
+    }
+
+    template <class InputIter, class OutputIter, class UnaryOperation>
+    OutputIter parallel_transform_n(InputIter first, size_t n, OutputIter d_first, UnaryOperation &op)
+    {
+        work_stealing_pool &pool = work_stealing_pool::instance();
+        size_t chunks = parallel_chunk_count(n, pool);
+        if (chunks < 2)
+        {
+            for (; n > 0; --n, ++first, ++d_first)
+                *d_first = op(*first);
+            return d_first;
+        }
+        std::vector<InputIter> in = split_range(first, n, chunks);
+        std::vector<OutputIter> out = split_range(d_first, n, chunks);
+        pool.parallel_for(chunks, [&](size_t i)
+                          {
+            OutputIter d = out[i];
+            for (InputIter it = in[i]; it != in[i + 1]; ++it, ++d)
+                *d = op(*it); });
+        return out[chunks];
+    }
+
+    template <class ForwardIter, class OutputIter, class UnaryOperation,
+              typename std::enable_if<cheamstl::is_forward_iterator<ForwardIter>::value &&
+                                          cheamstl::is_forward_iterator<OutputIter>::value,
+                                      int>::type = 0>
+    OutputIter transform(execution::parallel_policy, ForwardIter first, ForwardIter last, OutputIter d_first,
+                         UnaryOperation op)
+    {
+        return parallel_transform_n(first, static_cast<size_t>(cheamstl::distance(first, last)), d_first, op);
+    }
+
+    template <class Container, class OutputIter, class UnaryOperation,
+              typename std::enable_if<is_sized_range<Container>::value &&
+                                          cheamstl::is_forward_iterator<OutputIter>::value,
+                                      int>::type = 0>
+    OutputIter transform(execution::parallel_policy, Container &c, OutputIter d_first, UnaryOperation op)
+    {
+        return parallel_transform_n(c.begin(), c.size(), d_first, op);
+    }
+
+    /*****************************************************************************************/
+    // count_if
+
+    template <class Iter, class UnaryPredicate>
+    size_t count_if(execution::sequenced_policy, Iter first, Iter last, UnaryPredicate pred)
+    {
+        size_t n = 0;
+        for (; first != last; ++first)
+            if (pred(*first))
+                ++n;
+        return n;
+    }
+
+    template <class Iter, class UnaryPredicate>
+    size_t parallel_count_if_n(Iter first, size_t n, UnaryPredicate &pred)
+    {
+        work_stealing_pool &pool = work_stealing_pool::instance();
+        size_t chunks = parallel_chunk_count(n, pool);
+        if (chunks < 2)
+        {
+            size_t count = 0;
+            for (; n > 0; --n, ++first)
+                if (pred(*first))
+                    ++count;
+            return count;
+        }
+        std::vector<Iter> points = split_range(first, n, chunks);
+        std::vector<size_t> partial(chunks, 0);
+        pool.parallel_for(chunks, [&](size_t i)
+                          {
+            size_t count = 0;
+            for (Iter it = points[i]; it != points[i + 1]; ++it)
+                if (pred(*it))
+                    ++count;
+            partial[i] = count; });
+        size_t count = 0;
+        for (size_t c : partial)
+            count += c;
+        return count;
+    }
+
+    template <class Iter, class UnaryPredicate,
+              typename std::enable_if<cheamstl::is_forward_iterator<Iter>::value, int>::type = 0>
+    size_t count_if(execution::parallel_policy, Iter first, Iter last, UnaryPredicate pred)
+    {
+        return parallel_count_if_n(first, static_cast<size_t>(cheamstl::distance(first, last)), pred);
+    }
+
+    template <class Container, class UnaryPredicate,
+              typename std::enable_if<is_sized_range<Container>::value, int>::type = 0>
+    size_t count_if(execution::parallel_policy, Container &c, UnaryPredicate pred)
+    {
+        return parallel_count_if_n(c.begin(), c.size(), pred);
+    }
+
+    /*****************************************************************************************/
+    // reduce：每块先各自归约，再按块的顺序与 init 合并；op 需要满足结合律（不要求交换律）
+
+    template <class Iter, class T, class BinaryOperation>
+    T reduce(execution::sequenced_policy, Iter first, Iter last, T init, BinaryOperation op)
+    {
+        for (; first != last; ++first)
+            init = op(std::move(init), *first);
+        return init;
+    }
+
+    template <class Iter, class T, class BinaryOperation>
+    T parallel_reduce_n(Iter first, size_t n, T init, BinaryOperation &op)
+    {
+        work_stealing_pool &pool = work_stealing_pool::instance();
+        size_t chunks = parallel_chunk_count(n, pool);
+        if (chunks < 2)
+        {
+            for (; n > 0; --n, ++first)
+                init = op(std::move(init), *first);
+            return init;
+        }
+        std::vector<Iter> points = split_range(first, n, chunks);
+        /* 每块都不为空，用块内第一个元素作为初值，不需要 op 的单位元 */
+        std::vector<T> partial(chunks, init);
+        pool.parallel_for(chunks, [&](size_t i)
+                          {
+            Iter it = points[i];
+            T acc = *it;
+            for (++it; it != points[i + 1]; ++it)
+                acc = op(std::move(acc), *it);
+            partial[i] = std::move(acc); });
+        for (size_t i = 0; i < chunks; ++i)
+            init = op(std::move(init), std::move(partial[i]));
+        return init;
+    }
+
+    template <class Iter, class T, class BinaryOperation,
+              typename std::enable_if<cheamstl::is_forward_iterator<Iter>::value, int>::type = 0>
+    T reduce(execution::parallel_policy, Iter first, Iter last, T init, BinaryOperation op)
+    {
+        return parallel_reduce_n(first, static_cast<size_t>(cheamstl::distance(first, last)), std::move(init), op);
+    }
+
+    template <class Container, class T, class BinaryOperation,
+              typename std::enable_if<is_sized_range<Container>::value, int>::type = 0>
+    T reduce(execution::parallel_policy, Container &c, T init, BinaryOperation op)
+    {
+        return parallel_reduce_n(c.begin(), c.size(), std::move(init), op);
+    }
+
+} // namespace cheamstl
+
+#endif // !CHEAMSTL_ALGORITHM_H_
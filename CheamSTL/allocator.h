@@ -0,0 +1,2090 @@
+#ifndef CHEAMSTL_ALLOCATOR_H_
+#define CHEAMSTL_ALLOCATOR_H_
+
+/* 这个头文件包含五类分配器：
+ * allocator              : 通用分配器，直接使用 ::operator new / ::operator delete
+ * pool_allocator         : 固定大小的节点分配器（slab + 空闲链表），专门给 list 的节点使用
+ * huge_page_allocator    : 大块内存来自 2MB 大页（可绑定本地 NUMA 节点）的 pool_allocator，给超大链表使用
+ * thread_cache_allocator : 带线程缓存的节点分配器，适合节点在一个线程分配、在另一个线程释放的场景
+ * mapped_allocator       : 从 mmap 映射的共享文件中分配，pointer 是 offset_ptr，容器可以放进共享内存或持久化文件
+ * 它们接口一致，成员函数都是 static 的，容器里直接写 xxx_allocator::allocate(1) 即可
+ *
+ * 另外 pmr::polymorphic_allocator 是有状态的分配器，每个对象指向一个 pmr::memory_resource，
+ * 容器通过 alloc_holder 保存分配器对象（无状态的分配器不占空间），统一用 alloc.allocate(...) 的形式调用
+ *
+ * 编译时定义 CHEAMSTL_ALLOC_STATS=1 可以打开分配统计（见 alloc_stats），默认关闭，关闭时没有任何开销 */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "exceptdef.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+#define CHEAMSTL_HAS_MMAP 1
+#else
+#define CHEAMSTL_HAS_MMAP 0
+#endif
+
+#ifndef CHEAMSTL_ALLOC_STATS
+#define CHEAMSTL_ALLOC_STATS 0
+#endif
+
+namespace cheamstl
+{
+
+    /*****************************************************************************************/
+    /* 分配统计
+     * 按被分配的类型（例如 list_node<T> 与 list_node_base<T> 分开）统计：
+     * 当前占用字节数、峰值字节数、分配 / 释放次数、按申请大小（2 的幂分桶）的直方图。
+     * 此外提供两个对外接口：
+     * 1. set_hook：每次分配 / 释放都会回调，用来把事件导出到外部的指标系统
+     * 2. scope：RAII 标签，作用域内本线程的所有分配事件都带上这个标签，用来把内存增长归到具体的容器上
+     * 计数器全部是 relaxed 原子操作；CHEAMSTL_ALLOC_STATS 为 0 时所有入口都是空函数 */
+
+    static constexpr size_t alloc_histogram_buckets = 32;
+
+    /* 一次分配 / 释放事件 */
+    struct alloc_event
+    {
+        const char *type_name; // 被分配的类型
+        size_t type_size;      // sizeof(T)
+        void *ptr;
+        size_t bytes;          // 本次涉及的字节数
+        size_t count;          // 本次涉及的块数（批量分配时大于 1）
+        bool is_allocate;
+        const char *tag;       // 当前线程的 scope 标签，没有时为 nullptr
+    };
+
+    typedef void (*alloc_hook)(const alloc_event &event, void *user);
+
+    /* 某个类型统计数据的快照 */
+    struct alloc_type_stats
+    {
+        const char *type_name;
+        size_t type_size;
+        size_t live_bytes;
+        size_t peak_bytes;
+        size_t alloc_count;
+        size_t dealloc_count;
+        size_t histogram[alloc_histogram_buckets]; // 第 i 个桶统计大小在 [2^i, 2^(i+1)) 字节内的分配
+    };
+
+    class alloc_stats
+    {
+    public:
+        static constexpr bool enabled = CHEAMSTL_ALLOC_STATS != 0;
+
+    private:
+        /* 每个类型一份计数器，第一次使用时挂到全局链表上，便于遍历 */
+        struct counters
+        {
+            const char *type_name;
+            size_t type_size;
+            std::atomic<size_t> live_bytes;
+            std::atomic<size_t> peak_bytes;
+            std::atomic<size_t> alloc_count;
+            std::atomic<size_t> dealloc_count;
+            std::atomic<size_t> histogram[alloc_histogram_buckets];
+            counters *next;
+        };
+
+        struct hook_state
+        {
+            std::atomic<alloc_hook> fn;
+            std::atomic<void *> user;
+        };
+
+    public:
+        /* 作用域标签：标签字符串的生命周期需要覆盖整个作用域 */
+        class scope
+        {
+        public:
+            explicit scope(const char *tag) noexcept : prev_(current_tag())
+            {
+                current_tag() = tag;
+            }
+            ~scope() { current_tag() = prev_; }
+
+            scope(const scope &) = delete;
+            scope &operator=(const scope &) = delete;
+
+        private:
+            const char *prev_;
+        };
+
+        template <class T>
+        static void on_allocate(void *ptr, size_t bytes, size_t count = 1) noexcept
+        {
+            if (!enabled || ptr == nullptr)
+                return;
+            counters &c = counters_of<T>();
+            c.alloc_count.fetch_add(count, std::memory_order_relaxed);
+            c.histogram[bucket_of(bytes / count)].fetch_add(count, std::memory_order_relaxed);
+            size_t live = c.live_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+            size_t peak = c.peak_bytes.load(std::memory_order_relaxed);
+            while (live > peak && !c.peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+            {
+            }
+            notify(c, ptr, bytes, count, true);
+        }
+
+        template <class T>
+        static void on_deallocate(void *ptr, size_t bytes, size_t count = 1) noexcept
+        {
+            if (!enabled || ptr == nullptr)
+                return;
+            counters &c = counters_of<T>();
+            c.dealloc_count.fetch_add(count, std::memory_order_relaxed);
+            c.live_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+            notify(c, ptr, bytes, count, false);
+        }
+
+        /* 设置回调，传入 nullptr 取消；回调可能在任意线程上被并发调用，且不能再分配被统计的类型 */
+        static void set_hook(alloc_hook fn, void *user = nullptr) noexcept
+        {
+            hook().user.store(user, std::memory_order_relaxed);
+            hook().fn.store(fn, std::memory_order_release);
+        }
+
+        template <class T>
+        static alloc_type_stats get() noexcept
+        {
+            return snapshot(counters_of<T>());
+        }
+
+        /* 遍历所有出现过的类型，f 的参数为 const alloc_type_stats& */
+        template <class Fn>
+        static void for_each(Fn f)
+        {
+            for (counters *c = registry().load(std::memory_order_acquire); c != nullptr; c = c->next)
+                f(snapshot(*c));
+        }
+
+        static const char *tag() noexcept { return current_tag(); }
+
+    private:
+        static size_t bucket_of(size_t bytes) noexcept
+        {
+            size_t b = 0;
+            while (bytes > 1 && b + 1 < alloc_histogram_buckets)
+            {
+                bytes >>= 1;
+                ++b;
+            }
+            return b;
+        }
+
+        static const char *&current_tag() noexcept
+        {
+            static thread_local const char *t = nullptr;
+            return t;
+        }
+
+        static hook_state &hook() noexcept
+        {
+            static hook_state h = {{nullptr}, {nullptr}};
+            return h;
+        }
+
+        static std::atomic<counters *> &registry() noexcept
+        {
+            static std::atomic<counters *> head(nullptr);
+            return head;
+        }
+
+        template <class T>
+        static counters &counters_of() noexcept
+        {
+            static counters *c = make_counters(type_name<T>(), sizeof(T));
+            return *c;
+        }
+
+        /* 故意泄漏：静态析构阶段仍可能有释放事件 */
+        static counters *make_counters(const char *name, size_t size) noexcept
+        {
+            counters *c = new counters();
+            c->type_name = name;
+            c->type_size = size;
+            c->next = registry().load(std::memory_order_relaxed);
+            while (!registry().compare_exchange_weak(c->next, c, std::memory_order_release, std::memory_order_relaxed))
+            {
+            }
+            return c;
+        }
+
+        static alloc_type_stats snapshot(const counters &c) noexcept
+        {
+            alloc_type_stats s;
+            s.type_name = c.type_name;
+            s.type_size = c.type_size;
+            s.live_bytes = c.live_bytes.load(std::memory_order_relaxed);
+            s.peak_bytes = c.peak_bytes.load(std::memory_order_relaxed);
+            s.alloc_count = c.alloc_count.load(std::memory_order_relaxed);
+            s.dealloc_count = c.dealloc_count.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < alloc_histogram_buckets; ++i)
+                s.histogram[i] = c.histogram[i].load(std::memory_order_relaxed);
+            return s;
+        }
+
+        static void notify(const counters &c, void *ptr, size_t bytes, size_t count, bool is_allocate) noexcept
+        {
+            alloc_hook fn = hook().fn.load(std::memory_order_acquire);
+            if (fn == nullptr)
+                return;
+            alloc_event e = {c.type_name, c.type_size, ptr, bytes, count, is_allocate, current_tag()};
+            fn(e, hook().user.load(std::memory_order_relaxed));
+        }
+
+        /* 不依赖 RTTI 取得类型名：从函数签名字符串中截取 "T = ..." 的部分，结果缓存在静态存储中 */
+        template <class T>
+        static const char *type_name() noexcept
+        {
+#if defined(_MSC_VER)
+            static const char *sig = __FUNCSIG__;
+            return sig;
+#else
+            static char buf[256];
+            static bool once = extract_type_name(__PRETTY_FUNCTION__, buf, sizeof(buf));
+            (void)once;
+            return buf;
+#endif
+        }
+
+        static bool extract_type_name(const char *sig, char *buf, size_t size) noexcept
+        {
+            const char *b = std::strstr(sig, "T = ");
+            if (b == nullptr)
+            {
+                std::strncpy(buf, sig, size - 1);
+                buf[size - 1] = '\0';
+                return true;
+            }
+            b += 4;
+            size_t n = 0;
+            int depth = 0;
+            for (; b[n] != '\0' && n + 1 < size; ++n)
+            {
+                if (b[n] == '<' || b[n] == '(')
+                    ++depth;
+                else if (b[n] == '>' || b[n] == ')')
+                    --depth;
+                else if (depth == 0 && (b[n] == ';' || b[n] == ']'))
+                    break;
+            }
+            std::memcpy(buf, b, n);
+            buf[n] = '\0';
+            return true;
+        }
+    };
+
+    /* 通用分配器：只负责把内存的申请/释放与对象的构造/析构拆开 */
+    template <class T>
+    class allocator
+    {
+    public:
+        typedef T value_type;
+        typedef T *pointer;
+        typedef const T *const_pointer;
+        typedef T &reference;
+        typedef const T &const_reference;
+        typedef size_t size_type;
+        typedef ptrdiff_t difference_type;
+
+        /* 容器通过 rebind 得到同一种分配器、但针对节点类型的版本 */
+        template <class U>
+        struct rebind
+        {
+            typedef allocator<U> other;
+        };
+
+    public:
+        static T *allocate();
+        static T *allocate(size_type n);
+
+        static void deallocate(T *ptr);
+        static void deallocate(T *ptr, size_type n);
+
+        /* 批量申请 n 个对象的空间，以单链表串起来返回（每块开头存放下一块的地址），
+         * 每一块之后用 deallocate(p) 单独释放；sizeof(T) 至少要能放下一个指针 */
+        static T *allocate_chain(size_type n);
+        static T *chain_next(T *ptr) noexcept { return *reinterpret_cast<T **>(ptr); }
+
+        static void construct(T *ptr);
+        static void construct(T *ptr, const T &value);
+        static void construct(T *ptr, T &&value);
+
+        template <class... Args>
+        static void construct(T *ptr, Args &&...args);
+
+        static void destroy(T *ptr);
+        static void destroy(T *first, T *last);
+    };
+
+    template <class T>
+    T *allocator<T>::allocate()
+    {
+        T *p = static_cast<T *>(::operator new(sizeof(T)));
+        alloc_stats::on_allocate<T>(p, sizeof(T));
+        return p;
+    }
+
+    template <class T>
+    T *allocator<T>::allocate(size_type n)
+    {
+        if (n == 0)
+            return nullptr;
+        T *p = static_cast<T *>(::operator new(n * sizeof(T)));
+        alloc_stats::on_allocate<T>(p, n * sizeof(T));
+        return p;
+    }
+
+    template <class T>
+    void allocator<T>::deallocate(T *ptr)
+    {
+        if (ptr == nullptr)
+            return;
+        alloc_stats::on_deallocate<T>(ptr, sizeof(T));
+        ::operator delete(ptr);
+    }
+
+    template <class T>
+    void allocator<T>::deallocate(T *ptr, size_type n)
+    {
+        if (ptr == nullptr)
+            return;
+        alloc_stats::on_deallocate<T>(ptr, n * sizeof(T));
+        ::operator delete(ptr);
+    }
+
+    template <class T>
+    T *allocator<T>::allocate_chain(size_type n)
+    {
+        static_assert(sizeof(T) >= sizeof(T *), "allocate_chain needs room for a link pointer");
+        T *head = nullptr;
+        try
+        {
+            for (; n > 0; --n)
+            {
+                T *p = allocate();
+                *reinterpret_cast<T **>(p) = head;
+                head = p;
+            }
+        }
+        catch (...)
+        {
+            while (head != nullptr)
+            {
+                T *next = chain_next(head);
+                deallocate(head);
+                head = next;
+            }
+            throw;
+        }
+        return head;
+    }
+
+    template <class T>
+    void allocator<T>::construct(T *ptr)
+    {
+        ::new ((void *)ptr) T();
+    }
+
+    template <class T>
+    void allocator<T>::construct(T *ptr, const T &value)
+    {
+        ::new ((void *)ptr) T(value);
+    }
+
+    template <class T>
+    void allocator<T>::construct(T *ptr, T &&value)
+    {
+        ::new ((void *)ptr) T(std::move(value));
+    }
+
+    template <class T>
+    template <class... Args>
+    void allocator<T>::construct(T *ptr, Args &&...args)
+    {
+        ::new ((void *)ptr) T(std::forward<Args>(args)...);
+    }
+
+    template <class T>
+    void allocator<T>::destroy(T *ptr)
+    {
+        ptr->~T();
+    }
+
+    template <class T>
+    void allocator<T>::destroy(T *first, T *last)
+    {
+        for (; first != last; ++first)
+            first->~T();
+    }
+
+    /*****************************************************************************************/
+    /* chunk 的来源：node_pool 向它申请大块内存，申请到的内存在进程生命周期内不归还。
+     * round_up 给出实际会拿到的字节数，node_pool 据此把整块都切成节点 */
+
+    /* 默认来源：::operator new */
+    struct heap_chunk_source
+    {
+        static constexpr size_t chunk_bytes = 64 * 1024;
+
+        static size_t round_up(size_t bytes) noexcept { return bytes; }
+        static void *allocate(size_t bytes) { return ::operator new(bytes); }
+    };
+
+    /* 实际拿到的页面类型，由 huge_page_chunk_source::report() 汇报 */
+    enum class page_backing
+    {
+        normal_pages,           // 普通 4KB 页（不支持大页，或者所有大页方式都失败了）
+        transparent_huge_pages, // 按 2MB 对齐映射并 madvise(MADV_HUGEPAGE)，由内核的透明大页合并
+        explicit_huge_pages     // mmap(MAP_HUGETLB)，来自预留的 2MB 大页池
+    };
+
+    /* huge_page_chunk_source：以 2MB 为单位、优先使用大页的 chunk 来源，减少遍历超大链表时的 TLB 缺失
+     * 1. 依次尝试 MAP_HUGETLB（需要系统预留大页）、2MB 对齐的匿名映射 + MADV_HUGEPAGE、普通的 ::operator new，
+     *    前一种失败就退到后一种；可以用 set_explicit_huge_pages(false) 跳过第一种
+     * 2. numa_local 打开时（默认），每个 chunk 在第一次写入之前用 mbind(MPOL_PREFERRED) 绑定到申请线程所在的
+     *    NUMA 节点。node_pool 的空闲链表是线程本地的，所以哪个线程建的链表，节点就在哪个线程的节点上；
+     *    系统不支持 mbind（或没有权限）时保持内核默认的首次访问策略
+     * 3. report() 汇总各种页面类型实际拿到的字节数以及 NUMA 绑定是否成功，透明大页只表示已经请求，
+     *    是否真正合并以 /proc/self/smaps 中的 AnonHugePages 为准 */
+    class huge_page_chunk_source
+    {
+    public:
+        static constexpr size_t chunk_bytes = 2 * 1024 * 1024;
+
+        struct backing_report
+        {
+            size_t explicit_huge_bytes;
+            size_t transparent_huge_bytes;
+            size_t normal_bytes;
+            size_t numa_bound_bytes; // 其中成功绑定到申请线程所在 NUMA 节点的字节数
+            int last_numa_node;      // 最近一次绑定的节点，从未绑定时为 -1
+
+            /* 拿到的主要页面类型：有显式大页就是显式大页，其次是透明大页 */
+            page_backing backing() const noexcept
+            {
+                if (explicit_huge_bytes != 0)
+                    return page_backing::explicit_huge_pages;
+                if (transparent_huge_bytes != 0)
+                    return page_backing::transparent_huge_pages;
+                return page_backing::normal_pages;
+            }
+        };
+
+        static size_t round_up(size_t bytes) noexcept { return (bytes + chunk_bytes - 1) & ~(chunk_bytes - 1); }
+
+        static void *allocate(size_t bytes)
+        {
+            bytes = round_up(bytes);
+            state &st = get_state();
+#if CHEAMSTL_HAS_MMAP
+            void *p = nullptr;
+#ifdef MAP_HUGETLB
+            if (st.explicit_huge.load(std::memory_order_relaxed))
+            {
+                p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+                if (p != MAP_FAILED)
+                {
+                    bind_local(p, bytes);
+                    st.explicit_huge_bytes.fetch_add(bytes, std::memory_order_relaxed);
+                    return p;
+                }
+            }
+#endif
+            p = map_aligned(bytes);
+            if (p != nullptr)
+            {
+                bool huge = false;
+#ifdef MADV_HUGEPAGE
+                huge = ::madvise(p, bytes, MADV_HUGEPAGE) == 0;
+#endif
+                bind_local(p, bytes);
+                (huge ? st.transparent_huge_bytes : st.normal_bytes).fetch_add(bytes, std::memory_order_relaxed);
+                return p;
+            }
+#endif
+            void *q = ::operator new(bytes);
+            st.normal_bytes.fetch_add(bytes, std::memory_order_relaxed);
+            return q;
+        }
+
+        static backing_report report() noexcept
+        {
+            state &st = get_state();
+            backing_report r;
+            r.explicit_huge_bytes = st.explicit_huge_bytes.load(std::memory_order_relaxed);
+            r.transparent_huge_bytes = st.transparent_huge_bytes.load(std::memory_order_relaxed);
+            r.normal_bytes = st.normal_bytes.load(std::memory_order_relaxed);
+            r.numa_bound_bytes = st.numa_bound_bytes.load(std::memory_order_relaxed);
+            r.last_numa_node = st.last_numa_node.load(std::memory_order_relaxed);
+            return r;
+        }
+
+        static void set_explicit_huge_pages(bool on) noexcept { get_state().explicit_huge.store(on, std::memory_order_relaxed); }
+        static void set_numa_local(bool on) noexcept { get_state().numa_local.store(on, std::memory_order_relaxed); }
+
+    private:
+        struct state
+        {
+            std::atomic<bool> explicit_huge{true};
+            std::atomic<bool> numa_local{true};
+            std::atomic<size_t> explicit_huge_bytes{0};
+            std::atomic<size_t> transparent_huge_bytes{0};
+            std::atomic<size_t> normal_bytes{0};
+            std::atomic<size_t> numa_bound_bytes{0};
+            std::atomic<int> last_numa_node{-1};
+        };
+
+        static state &get_state() noexcept
+        {
+            static state st;
+            return st;
+        }
+
+#if CHEAMSTL_HAS_MMAP
+        /* 多映射 chunk_bytes 再裁掉首尾，得到 2MB 对齐的区域，透明大页只能合并对齐的 2MB */
+        static void *map_aligned(size_t bytes) noexcept
+        {
+            size_t span = bytes + chunk_bytes;
+            void *raw = ::mmap(nullptr, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (raw == MAP_FAILED)
+                return nullptr;
+            uintptr_t base = reinterpret_cast<uintptr_t>(raw);
+            uintptr_t aligned = (base + chunk_bytes - 1) & ~(uintptr_t)(chunk_bytes - 1);
+            if (aligned > base)
+                ::munmap(raw, aligned - base);
+            size_t tail = base + span - (aligned + bytes);
+            if (tail != 0)
+                ::munmap(reinterpret_cast<void *>(aligned + bytes), tail);
+            return reinterpret_cast<void *>(aligned);
+        }
+#endif
+
+        /* 把 [p, p + bytes) 优先放在当前线程所在的 NUMA 节点上，必须在第一次写入之前调用 */
+        static void bind_local(void *p, size_t bytes) noexcept
+        {
+#if defined(__linux__) && defined(SYS_mbind) && defined(SYS_getcpu)
+            state &st = get_state();
+            if (!st.numa_local.load(std::memory_order_relaxed))
+                return;
+            unsigned cpu = 0, node = 0;
+            if (::syscall(SYS_getcpu, &cpu, &node, nullptr) != 0)
+                return;
+            const unsigned long bits = 8 * sizeof(unsigned long);
+            unsigned long mask[16] = {};
+            if (node >= bits * 16)
+                return;
+            mask[node / bits] = 1UL << (node % bits);
+            const int mpol_preferred = 1;
+            if (::syscall(SYS_mbind, p, bytes, mpol_preferred, mask, bits * 16, 0) == 0)
+            {
+                st.numa_bound_bytes.fetch_add(bytes, std::memory_order_relaxed);
+                st.last_numa_node.store(static_cast<int>(node), std::memory_order_relaxed);
+            }
+#else
+            (void)p;
+            (void)bytes;
+#endif
+        }
+    };
+
+    /*****************************************************************************************/
+    /* node_pool：按固定块大小切分大块内存（chunk）的 slab 分配器
+     * 1. 每次向系统申请一个较大的 chunk（约 64KB），再把它切成 BlockSize 大小的小块，
+     *    这样连续分配出去的节点在内存中也是相邻的，遍历链表时局部性更好
+     * 2. 释放的小块不还给系统，而是挂到一个侵入式空闲链表上（直接复用小块自身的前 8 字节存 next），
+     *    下次分配时直接从链表头取，分配和释放都只是几条指令
+     * 3. 空闲链表是 thread_local 的，所以快路径上不需要加锁；
+     *    线程退出时把自己手上剩余的空闲块交还给全局的 orphan 链表，供其他线程补货时复用
+     * 4. chunk 一旦申请就在进程生命周期内保留（与 SGI STL 的二级配置器相同），
+     *    这样即使某个节点在 A 线程分配、B 线程释放，也不会出现悬空内存
+     * 5. chunk 从 ChunkSource 申请，默认是 ::operator new，也可以换成 huge_page_chunk_source；
+     *    不同来源的池子互相独立 */
+    template <size_t BlockSize, class ChunkSource = heap_chunk_source>
+    class node_pool
+    {
+    public:
+        /* 小块至少要能放下一个指针，并按指针大小对齐 */
+        static constexpr size_t block_size =
+            BlockSize < sizeof(void *) ? sizeof(void *)
+                                       : (BlockSize + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+        static constexpr size_t chunk_bytes = ChunkSource::chunk_bytes;
+        static constexpr size_t blocks_per_chunk =
+            chunk_bytes / block_size < 16 ? 16 : chunk_bytes / block_size;
+
+    private:
+        struct free_block
+        {
+            free_block *next;
+        };
+
+        /* 线程本地的缓存：只有平凡类型的成员，线程内任何时刻（包括 thread_local 析构之后）访问都是安全的 */
+        struct local_cache
+        {
+            free_block *head;
+            bool registered;
+        };
+
+        /* 全局共享的部分：orphan 链表和 chunk 的申请都在锁内完成，只在慢路径上出现 */
+        struct global_state
+        {
+            std::mutex mtx;
+            free_block *orphans = nullptr;
+        };
+
+        /* 线程退出时把剩余空闲块挂回全局 orphan 链表 */
+        struct cache_guard
+        {
+            ~cache_guard()
+            {
+                local_cache &c = cache();
+                if (c.head == nullptr)
+                    return;
+                free_block *tail = c.head;
+                while (tail->next)
+                    tail = tail->next;
+                global_state &g = global();
+                std::lock_guard<std::mutex> lock(g.mtx);
+                tail->next = g.orphans;
+                g.orphans = c.head;
+                c.head = nullptr;
+            }
+        };
+
+    public:
+        static void *allocate()
+        {
+            local_cache &c = cache();
+            free_block *p = c.head;
+            if (p == nullptr)
+                p = refill(c);
+            c.head = p->next;
+            return p;
+        }
+
+        static void deallocate(void *ptr) noexcept
+        {
+            local_cache &c = cache();
+            free_block *p = static_cast<free_block *>(ptr);
+            p->next = c.head;
+            c.head = p;
+        }
+
+        /* 一次取出 n 个块，以单链表的形式返回（每块开头存放下一块的地址，最后一块为 nullptr）
+         * 先用本线程空闲链表中的块，不够的部分从一个新 chunk 中连续切出，剩余的块挂回空闲链表 */
+        static void *allocate_chain(size_t n)
+        {
+            local_cache &c = cache();
+            free_block *head = nullptr;
+            free_block **tail = &head;
+            for (; n > 0 && c.head != nullptr; --n)
+            {
+                free_block *p = c.head;
+                c.head = p->next;
+                *tail = p;
+                tail = &p->next;
+            }
+            *tail = n == 0 ? nullptr : carve_chain(c, n);
+            return head;
+        }
+
+        /* 与 allocate_chain 相同，但不使用空闲链表：n 个块全部从一个新 chunk 中按地址递增的顺序连续切出，
+         * 供需要把节点重新排布到连续内存中的场合（例如 list::compact）使用 */
+        static void *allocate_fresh_chain(size_t n)
+        {
+            return n == 0 ? nullptr : carve_chain(cache(), n);
+        }
+
+    private:
+        /* 申请一个至少能容纳 n 块的新 chunk，前 n 块串成以 nullptr 结尾的单链表返回，剩余的块挂到空闲链表上 */
+        static free_block *carve_chain(local_cache &c, size_t n)
+        {
+            register_cache(c);
+            size_t blocks = n > blocks_per_chunk ? n : blocks_per_chunk;
+            blocks = ChunkSource::round_up(block_size * blocks) / block_size;
+            char *chunk = static_cast<char *>(ChunkSource::allocate(block_size * blocks));
+            for (size_t i = 0; i + 1 < blocks; ++i)
+            {
+                reinterpret_cast<free_block *>(chunk + i * block_size)->next =
+                    reinterpret_cast<free_block *>(chunk + (i + 1) * block_size);
+            }
+            free_block *last = reinterpret_cast<free_block *>(chunk + (n - 1) * block_size);
+            if (blocks > n)
+            {
+                reinterpret_cast<free_block *>(chunk + (blocks - 1) * block_size)->next = c.head;
+                c.head = last->next;
+            }
+            last->next = nullptr;
+            return reinterpret_cast<free_block *>(chunk);
+        }
+
+        static local_cache &cache() noexcept
+        {
+            static thread_local local_cache c = {nullptr, false};
+            return c;
+        }
+
+        /* 故意泄漏：保证静态析构阶段仍有对象归还节点时，全局状态依然可用 */
+        static global_state &global()
+        {
+            static global_state *g = new global_state;
+            return *g;
+        }
+
+        /* 第一次进入慢路径时注册线程退出的回调 */
+        static void register_cache(local_cache &c)
+        {
+            if (!c.registered)
+            {
+                static thread_local cache_guard guard;
+                (void)guard;
+                c.registered = true;
+            }
+        }
+
+        /* 慢路径：先尝试接收其他线程退出时留下的空闲块，没有再切一个新的 chunk */
+        static free_block *refill(local_cache &c)
+        {
+            register_cache(c);
+            global_state &g = global();
+            {
+                std::lock_guard<std::mutex> lock(g.mtx);
+                if (g.orphans)
+                {
+                    free_block *p = g.orphans;
+                    g.orphans = nullptr;
+                    return p;
+                }
+            }
+            char *chunk = static_cast<char *>(ChunkSource::allocate(block_size * blocks_per_chunk));
+            /* 按地址递增的顺序串起来，保证先分配出去的节点地址在前 */
+            for (size_t i = 0; i + 1 < blocks_per_chunk; ++i)
+            {
+                reinterpret_cast<free_block *>(chunk + i * block_size)->next =
+                    reinterpret_cast<free_block *>(chunk + (i + 1) * block_size);
+            }
+            reinterpret_cast<free_block *>(chunk + (blocks_per_chunk - 1) * block_size)->next = nullptr;
+            return reinterpret_cast<free_block *>(chunk);
+        }
+    };
+
+    /* pool_allocator：接口与 allocator 完全一致，单个对象走 node_pool，
+     * 一次申请多个（n > 1）或对齐要求超过 max_align_t 的类型则退回到 ::operator new。
+     * ChunkSource 决定 node_pool 的大块内存从哪里来，rebind 时保持不变 */
+    template <class T, class ChunkSource = heap_chunk_source>
+    class pool_allocator
+    {
+    public:
+        typedef T value_type;
+        typedef T *pointer;
+        typedef const T *const_pointer;
+        typedef T &reference;
+        typedef const T &const_reference;
+        typedef size_t size_type;
+        typedef ptrdiff_t difference_type;
+
+        typedef node_pool<sizeof(T), ChunkSource> pool_type;
+
+        template <class U>
+        struct rebind
+        {
+            typedef pool_allocator<U, ChunkSource> other;
+        };
+
+        /* 块是按指针大小对齐切出来的，只有 alignof(T) 不超过它时才能放进池子 */
+        static constexpr bool use_pool = alignof(T) <= sizeof(void *);
+
+    public:
+        static T *allocate() { return allocate(1); }
+
+        static T *allocate(size_type n)
+        {
+            if (n == 0)
+                return nullptr;
+            T *p = use_pool && n == 1 ? static_cast<T *>(pool_type::allocate())
+                                      : static_cast<T *>(::operator new(n * sizeof(T)));
+            alloc_stats::on_allocate<T>(p, n * sizeof(T));
+            return p;
+        }
+
+        static void deallocate(T *ptr) { deallocate(ptr, 1); }
+
+        /* 批量申请 n 个对象的空间：一次调用拿到 n 块，块与块之间用单链表串起来，
+         * 通过 chain_next 取得下一块；每一块之后仍然用 deallocate(p) 单独释放 */
+        static T *allocate_chain(size_type n)
+        {
+            if (n == 0)
+                return nullptr;
+            if (!use_pool)
+                return allocator<T>::allocate_chain(n); // 逐块经过 allocator，统计已在其中完成
+            T *p = static_cast<T *>(pool_type::allocate_chain(n));
+            alloc_stats::on_allocate<T>(p, n * sizeof(T), n);
+            return p;
+        }
+
+        /* 与 allocate_chain 相同，但 n 块一定来自新申请的连续内存，且按地址递增排列 */
+        static T *allocate_fresh_chain(size_type n)
+        {
+            if (n == 0)
+                return nullptr;
+            if (!use_pool)
+                return allocator<T>::allocate_chain(n);
+            T *p = static_cast<T *>(pool_type::allocate_fresh_chain(n));
+            alloc_stats::on_allocate<T>(p, n * sizeof(T), n);
+            return p;
+        }
+
+        static T *chain_next(T *p) noexcept { return allocator<T>::chain_next(p); }
+
+        static void deallocate(T *ptr, size_type n)
+        {
+            if (ptr == nullptr)
+                return;
+            alloc_stats::on_deallocate<T>(ptr, n * sizeof(T));
+            if (use_pool && n == 1)
+                pool_type::deallocate(ptr);
+            else
+                ::operator delete(ptr);
+        }
+
+        static void construct(T *ptr) { allocator<T>::construct(ptr); }
+        static void construct(T *ptr, const T &value) { allocator<T>::construct(ptr, value); }
+        static void construct(T *ptr, T &&value) { allocator<T>::construct(ptr, std::move(value)); }
+
+        template <class... Args>
+        static void construct(T *ptr, Args &&...args)
+        {
+            allocator<T>::construct(ptr, std::forward<Args>(args)...);
+        }
+
+        static void destroy(T *ptr) { allocator<T>::destroy(ptr); }
+        static void destroy(T *first, T *last) { allocator<T>::destroy(first, last); }
+    };
+
+    /* huge_page_allocator：节点放在 2MB 大页上（可绑定到申请线程所在的 NUMA 节点），适合几十 GB 的超大链表。
+     * list<T, huge_page_allocator<T>> 即可选用，实际拿到的页面类型见 huge_page_chunk_source::report() */
+    template <class T>
+    using huge_page_allocator = pool_allocator<T, huge_page_chunk_source>;
+
+    /*****************************************************************************************/
+    /* thread_cache_pool：带线程缓存、支持跨线程释放的固定大小块分配器
+     * 1. 每个线程有一个 heap，chunk 由哪个 heap 切出来就归哪个 heap 所有。
+     *    chunk 按自身大小对齐，块地址向下取整就能找到 chunk 头部记录的所有者
+     * 2. 本线程释放自己的块：直接放回本地空闲链表（magazine），没有任何原子操作
+     * 3. 释放别的线程的块：先攒在本线程的“待归还批次”里，攒满一批（或换了所有者）时，
+     *    用一次 CAS 整批挂到所有者 heap 的 remote 栈上；所有者在本地链表用完时一次性收回
+     * 4. 本地空闲块超过上限时，把多出的部分整批交还全局池，其他线程补货时可以直接拿走；
+     *    trim() 可以让空闲的线程主动把缓存全部还给全局池
+     * 5. 线程退出时 heap 被标记为空闲，由之后新建的线程接手，chunk 不会被释放，
+     *    因此在途的跨线程释放永远有一个合法的去处；没有线程接手时，其他线程在切新 chunk 之前
+     *    会把空闲 heap 的 remote 栈收进全局池，内存总量受峰值使用量约束 */
+    template <size_t BlockSize>
+    class thread_cache_pool
+    {
+    public:
+        static constexpr size_t block_size =
+            BlockSize < sizeof(void *) ? sizeof(void *)
+                                       : (BlockSize + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+        static constexpr size_t chunk_bytes = 64 * 1024;
+        static constexpr size_t magazine_size = 64;               // 交还全局池 / 跨线程归还的批量大小
+        static constexpr size_t local_limit = 4 * magazine_size;  // 本地最多缓存的空闲块数
+
+    private:
+        struct free_block
+        {
+            free_block *next;
+        };
+
+        struct heap;
+
+        /* chunk 头部，占用 chunk 开头的若干个块 */
+        struct chunk_header
+        {
+            heap *owner;
+        };
+
+        static constexpr size_t header_blocks = (sizeof(chunk_header) + block_size - 1) / block_size;
+        static constexpr size_t blocks_per_chunk = chunk_bytes / block_size - header_blocks;
+        static_assert(chunk_bytes / block_size > header_blocks + 1, "block too large for thread_cache_pool");
+
+        struct heap
+        {
+            // 只有所属线程访问
+            free_block *local = nullptr;
+            size_t local_count = 0;
+            heap *out_owner = nullptr; // 待归还批次的目标
+            free_block *out_head = nullptr;
+            free_block *out_tail = nullptr;
+            size_t out_count = 0;
+            // 其他线程会访问
+            std::atomic<free_block *> remote{nullptr};
+            std::atomic<bool> in_use{true};
+            heap *next_heap = nullptr;
+        };
+
+        struct magazine
+        {
+            free_block *head;
+            size_t count;
+        };
+
+        struct global_state
+        {
+            std::mutex mtx;
+            std::vector<magazine> magazines; // 全局池
+            std::atomic<heap *> heaps{nullptr};
+        };
+
+        struct local_state
+        {
+            heap *h;
+            bool registered;
+        };
+
+        struct thread_guard
+        {
+            ~thread_guard() { release_heap(); }
+        };
+
+    public:
+        static void *allocate()
+        {
+            heap *h = current_heap();
+            free_block *p = h->local;
+            if (p == nullptr)
+                p = refill(h);
+            h->local = p->next;
+            --h->local_count;
+            return p;
+        }
+
+        static void deallocate(void *ptr)
+        {
+            heap *h = current_heap();
+            free_block *p = static_cast<free_block *>(ptr);
+            heap *owner = chunk_of(p)->owner;
+            if (owner == h)
+            {
+                p->next = h->local;
+                h->local = p;
+                if (++h->local_count > local_limit)
+                    give_back(h, h->local_count - local_limit / 2);
+                return;
+            }
+            /* 跨线程释放：攒批 */
+            if (h->out_owner != owner)
+            {
+                flush_remote(h);
+                h->out_owner = owner;
+            }
+            p->next = h->out_head;
+            if (h->out_head == nullptr)
+                h->out_tail = p;
+            h->out_head = p;
+            if (++h->out_count >= magazine_size)
+                flush_remote(h);
+        }
+
+        /* 把本线程缓存的空闲块全部还给全局池，并送出待归还的批次，适合在线程空闲时调用 */
+        static void trim()
+        {
+            local_state &l = local();
+            if (l.h == nullptr)
+                return;
+            heap *h = l.h;
+            flush_remote(h);
+            collect_remote(h);
+            give_back(h, h->local_count);
+        }
+
+    private:
+        static local_state &local() noexcept
+        {
+            static thread_local local_state l = {nullptr, false};
+            return l;
+        }
+
+        /* 故意泄漏：chunk 与 heap 在进程生命周期内一直有效 */
+        static global_state &global()
+        {
+            static global_state *g = new global_state;
+            return *g;
+        }
+
+        static chunk_header *chunk_of(void *p) noexcept
+        {
+            return reinterpret_cast<chunk_header *>(reinterpret_cast<uintptr_t>(p) & ~(uintptr_t)(chunk_bytes - 1));
+        }
+
+        static heap *current_heap()
+        {
+            local_state &l = local();
+            if (l.h != nullptr)
+                return l.h;
+            if (!l.registered)
+            {
+                static thread_local thread_guard guard;
+                (void)guard;
+                l.registered = true;
+            }
+            global_state &g = global();
+            /* 优先接手已退出线程留下的 heap */
+            for (heap *h = g.heaps.load(std::memory_order_acquire); h != nullptr; h = h->next_heap)
+            {
+                bool expected = false;
+                if (!h->in_use.load(std::memory_order_relaxed) &&
+                    h->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire))
+                {
+                    l.h = h;
+                    return h;
+                }
+            }
+            heap *h = new heap;
+            h->next_heap = g.heaps.load(std::memory_order_relaxed);
+            while (!g.heaps.compare_exchange_weak(h->next_heap, h, std::memory_order_release, std::memory_order_relaxed))
+            {
+            }
+            l.h = h;
+            return h;
+        }
+
+        static void release_heap()
+        {
+            local_state &l = local();
+            heap *h = l.h;
+            if (h == nullptr)
+                return;
+            flush_remote(h);
+            collect_remote(h);
+            give_back(h, h->local_count);
+            l.h = nullptr;
+            h->in_use.store(false, std::memory_order_release);
+        }
+
+        /* 把 [head, tail] 整段挂到 owner 的 remote 栈上 */
+        static void push_remote(heap *owner, free_block *head, free_block *tail) noexcept
+        {
+            free_block *old = owner->remote.load(std::memory_order_relaxed);
+            do
+            {
+                tail->next = old;
+            } while (!owner->remote.compare_exchange_weak(old, head, std::memory_order_release,
+                                                          std::memory_order_relaxed));
+        }
+
+        /* 把待归还批次整批挂到所有者的 remote 栈上 */
+        static void flush_remote(heap *h) noexcept
+        {
+            if (h->out_head == nullptr)
+                return;
+            push_remote(h->out_owner, h->out_head, h->out_tail);
+            h->out_head = h->out_tail = nullptr;
+            h->out_count = 0;
+        }
+
+        /* 线程退出后它的 heap 没有人收 remote 栈，而它的块还会经全局池流到其他线程、再被跨线程释放回来，
+         * 不处理的话这些块会一直堆在那里，其他线程只能不断切新的 chunk。
+         * 这里把空闲 heap 的 remote 栈整个摘下，按 magazine_size 分批放进全局池，返回是否收回了任何块 */
+        static bool drain_idle_heaps()
+        {
+            global_state &g = global();
+            bool drained = false;
+            for (heap *o = g.heaps.load(std::memory_order_acquire); o != nullptr; o = o->next_heap)
+            {
+                if (o->in_use.load(std::memory_order_relaxed) || o->remote.load(std::memory_order_relaxed) == nullptr)
+                    continue;
+                free_block *r = o->remote.exchange(nullptr, std::memory_order_acquire);
+                while (r != nullptr)
+                {
+                    free_block *tail = r;
+                    size_t n = 1;
+                    for (; n < magazine_size && tail->next != nullptr; ++n)
+                        tail = tail->next;
+                    free_block *rest = tail->next;
+                    tail->next = nullptr;
+                    try
+                    {
+                        std::lock_guard<std::mutex> lock(g.mtx);
+                        g.magazines.push_back(magazine{r, n});
+                    }
+                    catch (...)
+                    {
+                        /* 全局池扩容失败，把还没放进去的块原样挂回 */
+                        tail->next = rest;
+                        while (tail->next != nullptr)
+                            tail = tail->next;
+                        push_remote(o, r, tail);
+                        return drained;
+                    }
+                    drained = true;
+                    r = rest;
+                }
+            }
+            return drained;
+        }
+
+        /* 收回其他线程归还给自己的块 */
+        static bool collect_remote(heap *h) noexcept
+        {
+            free_block *r = h->remote.exchange(nullptr, std::memory_order_acquire);
+            if (r == nullptr)
+                return false;
+            free_block *tail = r;
+            size_t n = 1;
+            for (; tail->next != nullptr; tail = tail->next)
+                ++n;
+            tail->next = h->local;
+            h->local = r;
+            h->local_count += n;
+            return true;
+        }
+
+        /* 从本地空闲链表中取出 n 块交还全局池 */
+        static void give_back(heap *h, size_t n)
+        {
+            if (n == 0 || h->local == nullptr)
+                return;
+            free_block *head = h->local;
+            free_block *tail = head;
+            size_t taken = 1;
+            for (; taken < n && tail->next != nullptr; ++taken)
+                tail = tail->next;
+            h->local = tail->next;
+            h->local_count -= taken;
+            tail->next = nullptr;
+            global_state &g = global();
+            std::lock_guard<std::mutex> lock(g.mtx);
+            g.magazines.push_back(magazine{head, taken});
+        }
+
+        /* 从全局池拿一批，全局池为空时返回 false */
+        static bool take_magazine(heap *h)
+        {
+            global_state &g = global();
+            std::lock_guard<std::mutex> lock(g.mtx);
+            if (g.magazines.empty())
+                return false;
+            magazine m = g.magazines.back();
+            g.magazines.pop_back();
+            h->local = m.head;
+            h->local_count = m.count;
+            return true;
+        }
+
+        /* 慢路径：依次尝试收回跨线程释放的块、从全局池拿一批、收回已退出线程的 heap 上堆积的块、切一个新的 chunk */
+        static free_block *refill(heap *h)
+        {
+            if (collect_remote(h) || take_magazine(h))
+                return h->local;
+            if (drain_idle_heaps() && take_magazine(h))
+                return h->local;
+            char *chunk = static_cast<char *>(aligned_chunk());
+            reinterpret_cast<chunk_header *>(chunk)->owner = h;
+            char *first = chunk + header_blocks * block_size;
+            for (size_t i = 0; i + 1 < blocks_per_chunk; ++i)
+            {
+                reinterpret_cast<free_block *>(first + i * block_size)->next =
+                    reinterpret_cast<free_block *>(first + (i + 1) * block_size);
+            }
+            reinterpret_cast<free_block *>(first + (blocks_per_chunk - 1) * block_size)->next = nullptr;
+            h->local = reinterpret_cast<free_block *>(first);
+            h->local_count = blocks_per_chunk;
+            return h->local;
+        }
+
+        /* 按 chunk_bytes 对齐的大块内存 */
+        static void *aligned_chunk()
+        {
+            void *p = nullptr;
+#if defined(_WIN32)
+            p = _aligned_malloc(chunk_bytes, chunk_bytes);
+#else
+            if (posix_memalign(&p, chunk_bytes, chunk_bytes) != 0)
+                p = nullptr;
+#endif
+            if (p == nullptr)
+                throw std::bad_alloc();
+            return p;
+        }
+    };
+
+    /* thread_cache_allocator：接口与 pool_allocator 一致，单个对象走 thread_cache_pool，
+     * list<T, thread_cache_allocator<T>> 即可选用 */
+    template <class T>
+    class thread_cache_allocator
+    {
+    public:
+        typedef T value_type;
+        typedef T *pointer;
+        typedef const T *const_pointer;
+        typedef T &reference;
+        typedef const T &const_reference;
+        typedef size_t size_type;
+        typedef ptrdiff_t difference_type;
+
+        typedef thread_cache_pool<sizeof(T)> pool_type;
+
+        template <class U>
+        struct rebind
+        {
+            typedef thread_cache_allocator<U> other;
+        };
+
+        static constexpr bool use_pool = alignof(T) <= sizeof(void *);
+
+    public:
+        static T *allocate() { return allocate(1); }
+
+        static T *allocate(size_type n)
+        {
+            if (n == 0)
+                return nullptr;
+            T *p = use_pool && n == 1 ? static_cast<T *>(pool_type::allocate())
+                                      : static_cast<T *>(::operator new(n * sizeof(T)));
+            alloc_stats::on_allocate<T>(p, n * sizeof(T));
+            return p;
+        }
+
+        static void deallocate(T *ptr) { deallocate(ptr, 1); }
+
+        static void deallocate(T *ptr, size_type n)
+        {
+            if (ptr == nullptr)
+                return;
+            alloc_stats::on_deallocate<T>(ptr, n * sizeof(T));
+            if (use_pool && n == 1)
+                pool_type::deallocate(ptr);
+            else
+                ::operator delete(ptr);
+        }
+
+        /* 中途申请失败时把已经串好的块全部还回去，再抛出异常 */
+        static T *allocate_chain(size_type n)
+        {
+            T *head = nullptr;
+            try
+            {
+                for (; n > 0; --n)
+                {
+                    T *p = allocate(1);
+                    *reinterpret_cast<T **>(p) = head;
+                    head = p;
+                }
+            }
+            catch (...)
+            {
+                while (head != nullptr)
+                {
+                    T *next = chain_next(head);
+                    deallocate(head, 1);
+                    head = next;
+                }
+                throw;
+            }
+            return head;
+        }
+
+        static T *chain_next(T *p) noexcept { return allocator<T>::chain_next(p); }
+
+        /* 把当前线程缓存的空闲节点还给全局池 */
+        static void trim() { pool_type::trim(); }
+
+        static void construct(T *ptr) { allocator<T>::construct(ptr); }
+        static void construct(T *ptr, const T &value) { allocator<T>::construct(ptr, value); }
+        static void construct(T *ptr, T &&value) { allocator<T>::construct(ptr, std::move(value)); }
+
+        template <class... Args>
+        static void construct(T *ptr, Args &&...args)
+        {
+            allocator<T>::construct(ptr, std::forward<Args>(args)...);
+        }
+
+        static void destroy(T *ptr) { allocator<T>::destroy(ptr); }
+        static void destroy(T *first, T *last) { allocator<T>::destroy(first, last); }
+    };
+
+    /*****************************************************************************************/
+    /* rebind_pointer：把指针类型 Ptr 换成指向 U 的同类指针
+     * T* -> U*，offset_ptr<T> -> offset_ptr<U>，容器据此从分配器的 pointer 推出节点指针的类型 */
+    template <class Ptr, class U>
+    struct rebind_pointer;
+
+    template <class T, class U>
+    struct rebind_pointer<T *, U>
+    {
+        typedef U *type;
+    };
+
+    template <template <class> class Ptr, class T, class U>
+    struct rebind_pointer<Ptr<T>, U>
+    {
+        typedef Ptr<U> type;
+    };
+
+    /* offset_ptr：保存“目标地址 - 自身地址”的偏移量，而不是绝对地址
+     * 只要指针本身和它指向的对象在同一块映射内存里，这块内存被映射到任何地址上，指针都依然有效，
+     * 因此可以用在不同进程映射地址不同的共享内存中，或者重新映射的持久化文件中。
+     * 偏移量 1 表示空指针（偏移量 0 是合法的：节点的第一个成员指向节点自身时就是 0）；
+     * 复制时按新的位置重新计算偏移量 */
+    template <class T>
+    class offset_ptr
+    {
+    public:
+        typedef T element_type;
+        typedef ptrdiff_t difference_type;
+        typedef typename std::add_lvalue_reference<T>::type reference;
+
+    private:
+        static constexpr intptr_t null_offset = 1;
+
+        intptr_t offset_;
+
+        void set(const volatile void *p) noexcept
+        {
+            offset_ = p == nullptr ? null_offset
+                                   : reinterpret_cast<intptr_t>(p) - reinterpret_cast<intptr_t>(this);
+        }
+
+    public:
+        offset_ptr() noexcept : offset_(null_offset) {}
+        offset_ptr(std::nullptr_t) noexcept : offset_(null_offset) {}
+        offset_ptr(T *p) noexcept { set(p); }
+        offset_ptr(const offset_ptr &rhs) noexcept { set(rhs.get()); }
+
+        /* 向上转换（派生类 -> 基类、T -> const T 等）是隐式的 */
+        template <class U, typename std::enable_if<std::is_convertible<U *, T *>::value, int>::type = 0>
+        offset_ptr(const offset_ptr<U> &rhs) noexcept { set(static_cast<T *>(rhs.get())); }
+
+        /* 向下转换只能显式进行，与 static_cast<Derived*>(base) 对应 */
+        template <class U, typename std::enable_if<!std::is_convertible<U *, T *>::value &&
+                                                       std::is_base_of<U, T>::value,
+                                                   int>::type = 0>
+        explicit offset_ptr(const offset_ptr<U> &rhs) noexcept { set(static_cast<T *>(rhs.get())); }
+
+        offset_ptr &operator=(const offset_ptr &rhs) noexcept
+        {
+            set(rhs.get());
+            return *this;
+        }
+
+        offset_ptr &operator=(T *p) noexcept
+        {
+            set(p);
+            return *this;
+        }
+
+        offset_ptr &operator=(std::nullptr_t) noexcept
+        {
+            offset_ = null_offset;
+            return *this;
+        }
+
+        T *get() const noexcept
+        {
+            return offset_ == null_offset
+                       ? nullptr
+                       : reinterpret_cast<T *>(reinterpret_cast<intptr_t>(this) + offset_);
+        }
+
+        reference operator*() const noexcept { return *get(); }
+        T *operator->() const noexcept { return get(); }
+        explicit operator bool() const noexcept { return offset_ != null_offset; }
+        bool operator!() const noexcept { return offset_ == null_offset; }
+
+        friend bool operator==(const offset_ptr &a, const offset_ptr &b) noexcept { return a.get() == b.get(); }
+        friend bool operator!=(const offset_ptr &a, const offset_ptr &b) noexcept { return a.get() != b.get(); }
+        friend bool operator<(const offset_ptr &a, const offset_ptr &b) noexcept { return a.get() < b.get(); }
+        friend bool operator==(const offset_ptr &a, std::nullptr_t) noexcept { return !a; }
+        friend bool operator!=(const offset_ptr &a, std::nullptr_t) noexcept { return !!a; }
+        friend bool operator==(std::nullptr_t, const offset_ptr &a) noexcept { return !a; }
+        friend bool operator!=(std::nullptr_t, const offset_ptr &a) noexcept { return !!a; }
+    };
+
+#if CHEAMSTL_HAS_MMAP
+    /* mapped_segment：一个通过 mmap(MAP_SHARED) 映射进来的文件，作为 mapped_allocator 的内存来源
+     * 1. 文件开头是 header：魔数、总大小、已切出的位置、根对象的位置，以及按大小分级的空闲链表。
+     *    header 里只保存相对于映射起点的偏移量，因此不同进程、不同次运行映射到不同地址时依然有效
+     * 2. 分配按 16 字节对齐：1024 字节以内按 16 字节分级，更大的按 2 的幂分级；
+     *    先从对应级别的空闲链表取，没有再从未使用的区域切出，释放的块挂回对应级别的空闲链表
+     * 3. header 中的自旋锁放在共享内存里（无锁的 std::atomic 是地址无关的），多个进程可以同时分配/释放；
+     *    容器本身的操作仍需要使用者自己加锁
+     * 4. 每个 Tag 对应一个独立的段，进程内同一时刻只映射一个文件 */
+    template <class Tag = void>
+    class mapped_segment
+    {
+    public:
+        static constexpr size_t alignment = 16;
+        static constexpr size_t small_limit = 1024;
+        static constexpr size_t class_count = small_limit / alignment + 48;
+
+    private:
+        static constexpr uint64_t magic_value = 0x43484d4150534547ULL; // "CHMAPSEG"
+
+        struct header
+        {
+            uint64_t magic;
+            uint64_t size;
+            uint64_t top;  // 尚未使用区域的起点
+            uint64_t root; // 根对象的偏移量，0 表示还没有
+            std::atomic<uint32_t> lock;
+            uint64_t free_lists[class_count];
+        };
+
+        static constexpr size_t data_begin = (sizeof(header) + alignment - 1) & ~(alignment - 1);
+
+        struct state
+        {
+            char *base = nullptr;
+            size_t size = 0;
+        };
+
+        /* 持有 header 中的自旋锁 */
+        struct spin_guard
+        {
+            header *h;
+            explicit spin_guard(header *hd) : h(hd)
+            {
+                while (h->lock.exchange(1, std::memory_order_acquire) != 0)
+                    std::this_thread::yield();
+            }
+            ~spin_guard() { h->lock.store(0, std::memory_order_release); }
+        };
+
+    public:
+        /* 映射 path 指向的文件，文件不存在或为空时创建并初始化为 bytes 大小；
+         * 已经初始化过的文件按它原来的大小映射，其中的数据（包括根对象）保持不变。
+         * 返回 true 表示这次新建了段 */
+        static bool open(const char *path, size_t bytes)
+        {
+            THROW_RUNTIME_ERROR_IF(st().base != nullptr, "mapped_segment is already open");
+            int fd = ::open(path, O_RDWR | O_CREAT, 0600);
+            THROW_RUNTIME_ERROR_IF(fd < 0, "mapped_segment: cannot open file");
+            /* 用文件锁防止两个进程同时初始化同一个文件 */
+            ::flock(fd, LOCK_EX);
+            struct stat sb;
+            if (::fstat(fd, &sb) != 0)
+            {
+                ::flock(fd, LOCK_UN);
+                ::close(fd);
+                THROW_RUNTIME_ERROR_IF(true, "mapped_segment: cannot stat file");
+            }
+            bool created = sb.st_size == 0;
+            size_t size = created ? bytes : static_cast<size_t>(sb.st_size);
+            if (created && (size < data_begin || ::ftruncate(fd, static_cast<off_t>(size)) != 0))
+            {
+                ::flock(fd, LOCK_UN);
+                ::close(fd);
+                THROW_RUNTIME_ERROR_IF(true, "mapped_segment: cannot size file");
+            }
+            void *p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (p == MAP_FAILED)
+            {
+                ::flock(fd, LOCK_UN);
+                ::close(fd);
+                THROW_RUNTIME_ERROR_IF(true, "mapped_segment: mmap failed");
+            }
+            header *h = static_cast<header *>(p);
+            if (created)
+            {
+                /* 新文件的内容全部为 0，锁和空闲链表已经处于初始状态 */
+                h->size = size;
+                h->top = data_begin;
+                h->root = 0;
+                h->magic = magic_value;
+            }
+            else if (h->magic != magic_value || h->size != size)
+            {
+                ::munmap(p, size);
+                ::flock(fd, LOCK_UN);
+                ::close(fd);
+                THROW_RUNTIME_ERROR_IF(true, "mapped_segment: file is not a mapped segment");
+            }
+            ::flock(fd, LOCK_UN);
+            ::close(fd); // 映射建立之后文件描述符就不再需要了
+            st().base = static_cast<char *>(p);
+            st().size = size;
+            return created;
+        }
+
+        /* 解除映射，数据由操作系统写回文件；段内的对象在下次 open 之后可以继续使用 */
+        static void close() noexcept
+        {
+            state &s = st();
+            if (s.base == nullptr)
+                return;
+            ::munmap(s.base, s.size);
+            s.base = nullptr;
+            s.size = 0;
+        }
+
+        static bool is_open() noexcept { return st().base != nullptr; }
+        static void *base() noexcept { return st().base; }
+        static size_t size() noexcept { return st().size; }
+
+        /* 段内剩余的、从未切出过的字节数 */
+        static size_t available() noexcept
+        {
+            header *h = head();
+            return h == nullptr ? 0 : static_cast<size_t>(h->size - h->top);
+        }
+
+        static void *allocate(size_t bytes)
+        {
+            header *h = head();
+            if (h == nullptr)
+                throw std::bad_alloc();
+            size_t cls = class_of(bytes);
+            spin_guard lock(h);
+            uint64_t off = h->free_lists[cls];
+            if (off != 0)
+            {
+                h->free_lists[cls] = *reinterpret_cast<uint64_t *>(st().base + off);
+                return st().base + off;
+            }
+            size_t n = class_bytes(cls);
+            if (n > h->size - h->top)
+                throw std::bad_alloc();
+            off = h->top;
+            h->top += n;
+            return st().base + off;
+        }
+
+        static void deallocate(void *p, size_t bytes) noexcept
+        {
+            if (p == nullptr)
+                return;
+            header *h = head();
+            size_t cls = class_of(bytes);
+            uint64_t off = static_cast<uint64_t>(static_cast<char *>(p) - st().base);
+            spin_guard lock(h);
+            *reinterpret_cast<uint64_t *>(p) = h->free_lists[cls];
+            h->free_lists[cls] = off;
+        }
+
+        /* 段的根对象：各进程通过它找到放在段里的容器。
+         * 第一次调用时用 args 在段内构造一个 U，之后的调用（包括其他进程、下一次运行）直接返回同一个对象 */
+        template <class U, class... Args>
+        static U *find_or_construct_root(Args &&...args)
+        {
+            header *h = head();
+            THROW_RUNTIME_ERROR_IF(h == nullptr, "mapped_segment is not open");
+            {
+                spin_guard lock(h);
+                if (h->root != 0)
+                    return reinterpret_cast<U *>(st().base + h->root);
+            }
+            void *p = allocate(sizeof(U));
+            U *obj;
+            try
+            {
+                obj = ::new (p) U(std::forward<Args>(args)...);
+            }
+            catch (...)
+            {
+                deallocate(p, sizeof(U));
+                throw;
+            }
+            spin_guard lock(h);
+            if (h->root != 0)
+            {
+                /* 其他进程抢先构造了根对象，使用它的 */
+                obj->~U();
+                *reinterpret_cast<uint64_t *>(p) = h->free_lists[class_of(sizeof(U))];
+                h->free_lists[class_of(sizeof(U))] = static_cast<uint64_t>(static_cast<char *>(p) - st().base);
+                return reinterpret_cast<U *>(st().base + h->root);
+            }
+            h->root = static_cast<uint64_t>(reinterpret_cast<char *>(obj) - st().base);
+            return obj;
+        }
+
+    private:
+        static state &st() noexcept
+        {
+            static state s;
+            return s;
+        }
+
+        static header *head() noexcept { return reinterpret_cast<header *>(st().base); }
+
+        static size_t class_of(size_t bytes) noexcept
+        {
+            if (bytes == 0)
+                bytes = 1;
+            if (bytes <= small_limit)
+                return (bytes + alignment - 1) / alignment - 1;
+            size_t cls = small_limit / alignment;
+            for (size_t n = small_limit * 2; n < bytes; n *= 2)
+                ++cls;
+            return cls;
+        }
+
+        static size_t class_bytes(size_t cls) noexcept
+        {
+            if (cls < small_limit / alignment)
+                return (cls + 1) * alignment;
+            return small_limit << (cls - small_limit / alignment + 1);
+        }
+    };
+
+    /* mapped_allocator：从 mapped_segment<Tag> 中分配，pointer 为 offset_ptr<T>
+     * 使用前先调用 mapped_segment<Tag>::open。list<T, mapped_allocator<T>> 的节点指针也会是 offset_ptr，
+     * 整个链表（包括通过 find_or_construct_root 放进段里的 list 对象本身）都可以被多个进程共享，或在重启后重新映射直接使用。
+     * 元素类型 T 自身也必须不含绝对地址（例如不能是 std::string） */
+    template <class T, class Tag = void>
+    class mapped_allocator
+    {
+    public:
+        typedef T value_type;
+        typedef offset_ptr<T> pointer;
+        typedef offset_ptr<const T> const_pointer;
+        typedef T &reference;
+        typedef const T &const_reference;
+        typedef size_t size_type;
+        typedef ptrdiff_t difference_type;
+
+        typedef mapped_segment<Tag> segment_type;
+
+        template <class U>
+        struct rebind
+        {
+            typedef mapped_allocator<U, Tag> other;
+        };
+
+    public:
+        static pointer allocate() { return allocate(1); }
+
+        static pointer allocate(size_type n)
+        {
+            if (n == 0)
+                return nullptr;
+            T *p = static_cast<T *>(segment_type::allocate(n * sizeof(T)));
+            alloc_stats::on_allocate<T>(p, n * sizeof(T));
+            return pointer(p);
+        }
+
+        static void deallocate(pointer ptr) { deallocate(ptr, 1); }
+
+        static void deallocate(pointer ptr, size_type n)
+        {
+            if (!ptr)
+                return;
+            alloc_stats::on_deallocate<T>(ptr.get(), n * sizeof(T));
+            segment_type::deallocate(ptr.get(), n * sizeof(T));
+        }
+
+        /* 链只在当前进程内短暂存在，块之间用普通指针串起来即可 */
+        static pointer allocate_chain(size_type n)
+        {
+            T *head = nullptr;
+            try
+            {
+                for (; n > 0; --n)
+                {
+                    T *p = allocate(1).get();
+                    *reinterpret_cast<T **>(p) = head;
+                    head = p;
+                }
+            }
+            catch (...)
+            {
+                while (head != nullptr)
+                {
+                    T *next = *reinterpret_cast<T **>(head);
+                    deallocate(pointer(head));
+                    head = next;
+                }
+                throw;
+            }
+            return pointer(head);
+        }
+
+        static pointer chain_next(pointer p) noexcept { return pointer(*reinterpret_cast<T **>(p.get())); }
+
+        static void construct(T *ptr) { allocator<T>::construct(ptr); }
+        static void construct(T *ptr, const T &value) { allocator<T>::construct(ptr, value); }
+        static void construct(T *ptr, T &&value) { allocator<T>::construct(ptr, std::move(value)); }
+
+        template <class... Args>
+        static void construct(T *ptr, Args &&...args)
+        {
+            allocator<T>::construct(ptr, std::forward<Args>(args)...);
+        }
+
+        static void destroy(T *ptr) { allocator<T>::destroy(ptr); }
+        static void destroy(T *first, T *last) { allocator<T>::destroy(first, last); }
+    };
+#endif // CHEAMSTL_HAS_MMAP
+
+    /*****************************************************************************************/
+    /* alloc_holder：容器保存分配器对象的地方
+     * 无状态的分配器（空类）不保存任何东西，容器以私有继承的方式使用它，不增加容器的大小；
+     * 有状态的分配器（例如 pmr::polymorphic_allocator）保存一份副本 */
+    template <class A, bool = std::is_empty<A>::value>
+    class alloc_holder
+    {
+    public:
+        static constexpr bool stateful = false;
+
+        alloc_holder() noexcept {}
+        template <class U>
+        explicit alloc_holder(const U &) noexcept {}
+
+        A alloc() const noexcept { return A(); }
+        template <class U>
+        U alloc_as() const { return U(); }
+        bool same_alloc(const alloc_holder &) const noexcept { return true; }
+        void swap_alloc(alloc_holder &) noexcept {}
+        bool deallocate_is_noop() const noexcept { return false; }
+    };
+
+    template <class A>
+    class alloc_holder<A, false>
+    {
+        A a_;
+
+        template <class B>
+        static auto noop(const B &b, int) -> decltype(b.deallocate_is_noop()) { return b.deallocate_is_noop(); }
+        template <class B>
+        static bool noop(const B &, long) { return false; }
+
+    public:
+        static constexpr bool stateful = true;
+
+        alloc_holder() : a_() {}
+        template <class U>
+        explicit alloc_holder(const U &u) : a_(u) {}
+
+        A &alloc() noexcept { return a_; }
+        const A &alloc() const noexcept { return a_; }
+        template <class U>
+        U alloc_as() const { return U(a_); }
+        bool same_alloc(const alloc_holder &rhs) const noexcept { return a_ == rhs.a_; }
+        void swap_alloc(alloc_holder &rhs) noexcept
+        {
+            A tmp(a_);
+            a_ = rhs.a_;
+            rhs.a_ = tmp;
+        }
+        /* 分配器的 deallocate 什么也不做时（例如单调增长的内存资源），容器可以跳过逐个节点的释放 */
+        bool deallocate_is_noop() const noexcept { return noop(a_, 0); }
+    };
+
+    namespace pmr
+    {
+        /* memory_resource：多态的内存资源，接口与 std::pmr::memory_resource 相同，
+         * 另外多了一个 is_monotonic()：返回 true 表示 deallocate 不会回收任何内存，只有整体释放时才回收 */
+        class memory_resource
+        {
+        public:
+            static constexpr size_t max_align = alignof(std::max_align_t);
+
+            virtual ~memory_resource() = default;
+
+            void *allocate(size_t bytes, size_t alignment = max_align) { return do_allocate(bytes, alignment); }
+            void deallocate(void *p, size_t bytes, size_t alignment = max_align)
+            {
+                do_deallocate(p, bytes, alignment);
+            }
+            bool is_equal(const memory_resource &other) const noexcept { return do_is_equal(other); }
+            bool is_monotonic() const noexcept { return do_is_monotonic(); }
+
+        private:
+            virtual void *do_allocate(size_t bytes, size_t alignment) = 0;
+            virtual void do_deallocate(void *p, size_t bytes, size_t alignment) = 0;
+            virtual bool do_is_equal(const memory_resource &other) const noexcept { return this == &other; }
+            virtual bool do_is_monotonic() const noexcept { return false; }
+        };
+
+        inline bool operator==(const memory_resource &a, const memory_resource &b) noexcept
+        {
+            return &a == &b || a.is_equal(b);
+        }
+
+        inline bool operator!=(const memory_resource &a, const memory_resource &b) noexcept { return !(a == b); }
+
+        /* 直接使用 ::operator new / ::operator delete 的资源 */
+        class new_delete_resource_type : public memory_resource
+        {
+        private:
+            void *do_allocate(size_t bytes, size_t alignment) override
+            {
+                if (alignment <= max_align)
+                    return ::operator new(bytes);
+                void *p = nullptr;
+#if defined(_WIN32)
+                p = _aligned_malloc(bytes, alignment);
+#else
+                if (posix_memalign(&p, alignment, bytes) != 0)
+                    p = nullptr;
+#endif
+                if (p == nullptr)
+                    throw std::bad_alloc();
+                return p;
+            }
+            void do_deallocate(void *p, size_t, size_t alignment) override
+            {
+                if (alignment <= max_align)
+                    ::operator delete(p);
+                else
+#if defined(_WIN32)
+                    _aligned_free(p);
+#else
+                    free(p);
+#endif
+            }
+        };
+
+        inline memory_resource *new_delete_resource() noexcept
+        {
+            static new_delete_resource_type r;
+            return &r;
+        }
+
+        inline std::atomic<memory_resource *> &default_resource_slot() noexcept
+        {
+            static std::atomic<memory_resource *> slot(new_delete_resource());
+            return slot;
+        }
+
+        inline memory_resource *get_default_resource() noexcept
+        {
+            return default_resource_slot().load(std::memory_order_acquire);
+        }
+
+        /* 设置默认资源，传入 nullptr 时恢复为 new_delete_resource()，返回之前的默认资源 */
+        inline memory_resource *set_default_resource(memory_resource *r) noexcept
+        {
+            return default_resource_slot().exchange(r ? r : new_delete_resource(), std::memory_order_acq_rel);
+        }
+
+        /* monotonic_buffer_resource：只增不减的内存资源
+         * 1. 分配只是移动当前块中的指针；当前块用完时向上游申请一个更大的块（每次翻倍）
+         * 2. deallocate 什么也不做，内存只在 release() 或析构时整体还给上游，
+         *    所需时间只与块的个数有关，与分配过多少对象无关
+         * 3. 可以先给它一段外部缓冲区（例如栈上的数组），用完之后才会向上游申请
+         * 不是线程安全的，一个请求 / 一个线程使用一个即可 */
+        class monotonic_buffer_resource : public memory_resource
+        {
+        private:
+            /* 从上游申请的块以链表的形式记录下来，块头放在块的开头 */
+            struct chunk
+            {
+                chunk *next;
+                size_t bytes;
+            };
+
+            static constexpr size_t default_initial_size = 1024;
+
+            memory_resource *upstream_;
+            char *cur_;
+            size_t left_;
+            size_t next_size_;
+            chunk *chunks_;
+            void *initial_buffer_;
+            size_t initial_size_;
+
+        public:
+            explicit monotonic_buffer_resource(memory_resource *upstream = get_default_resource()) noexcept
+                : upstream_(upstream), cur_(nullptr), left_(0), next_size_(default_initial_size), chunks_(nullptr),
+                  initial_buffer_(nullptr), initial_size_(0)
+            {
+            }
+
+            explicit monotonic_buffer_resource(size_t initial_size,
+                                               memory_resource *upstream = get_default_resource()) noexcept
+                : upstream_(upstream), cur_(nullptr), left_(0),
+                  next_size_(initial_size ? initial_size : default_initial_size), chunks_(nullptr),
+                  initial_buffer_(nullptr), initial_size_(0)
+            {
+            }
+
+            monotonic_buffer_resource(void *buffer, size_t size,
+                                      memory_resource *upstream = get_default_resource()) noexcept
+                : upstream_(upstream), cur_(static_cast<char *>(buffer)), left_(size),
+                  next_size_(size ? size * 2 : default_initial_size), chunks_(nullptr), initial_buffer_(buffer),
+                  initial_size_(size)
+            {
+            }
+
+            monotonic_buffer_resource(const monotonic_buffer_resource &) = delete;
+            monotonic_buffer_resource &operator=(const monotonic_buffer_resource &) = delete;
+
+            ~monotonic_buffer_resource() override { release(); }
+
+            /* 把所有块还给上游，之前从这里分配的对象全部失效；之后可以继续使用 */
+            void release() noexcept
+            {
+                while (chunks_ != nullptr)
+                {
+                    chunk *next = chunks_->next;
+                    upstream_->deallocate(chunks_, chunks_->bytes, alignof(chunk));
+                    chunks_ = next;
+                }
+                cur_ = static_cast<char *>(initial_buffer_);
+                left_ = initial_size_;
+            }
+
+            memory_resource *upstream_resource() const noexcept { return upstream_; }
+
+        private:
+            void *do_allocate(size_t bytes, size_t alignment) override
+            {
+                if (alignment == 0)
+                    alignment = 1;
+                void *p = take(bytes, alignment);
+                if (p != nullptr)
+                    return p;
+                size_t need = sizeof(chunk) + bytes + alignment;
+                size_t size = next_size_ > need ? next_size_ : need;
+                chunk *c = static_cast<chunk *>(upstream_->allocate(size, alignof(chunk)));
+                c->next = chunks_;
+                c->bytes = size;
+                chunks_ = c;
+                cur_ = reinterpret_cast<char *>(c + 1);
+                left_ = size - sizeof(chunk);
+                next_size_ = size * 2;
+                return take(bytes, alignment);
+            }
+
+            void do_deallocate(void *, size_t, size_t) override {}
+
+            bool do_is_monotonic() const noexcept override { return true; }
+
+            /* 在当前块中按 alignment 对齐切出 bytes 字节，不够时返回 nullptr */
+            void *take(size_t bytes, size_t alignment) noexcept
+            {
+                if (cur_ == nullptr)
+                    return nullptr;
+                uintptr_t p = reinterpret_cast<uintptr_t>(cur_);
+                size_t pad = (alignment - p % alignment) % alignment;
+                if (pad + bytes > left_)
+                    return nullptr;
+                cur_ += pad + bytes;
+                left_ -= pad + bytes;
+                return reinterpret_cast<void *>(p + pad);
+            }
+        };
+
+        /* polymorphic_allocator：通过所指向的 memory_resource 分配，接口与其他分配器相同，
+         * 但 allocate / deallocate 是普通成员函数，需要容器保存分配器对象（见 alloc_holder） */
+        template <class T>
+        class polymorphic_allocator
+        {
+        public:
+            typedef T value_type;
+            typedef T *pointer;
+            typedef const T *const_pointer;
+            typedef T &reference;
+            typedef const T &const_reference;
+            typedef size_t size_type;
+            typedef ptrdiff_t difference_type;
+
+            template <class U>
+            struct rebind
+            {
+                typedef polymorphic_allocator<U> other;
+            };
+
+        private:
+            memory_resource *resource_;
+
+        public:
+            polymorphic_allocator() noexcept : resource_(get_default_resource()) {}
+            polymorphic_allocator(memory_resource *r) noexcept : resource_(r ? r : get_default_resource()) {}
+            template <class U>
+            polymorphic_allocator(const polymorphic_allocator<U> &rhs) noexcept : resource_(rhs.resource())
+            {
+            }
+
+            memory_resource *resource() const noexcept { return resource_; }
+
+            T *allocate(size_type n = 1)
+            {
+                return static_cast<T *>(resource_->allocate(n * sizeof(T), alignof(T)));
+            }
+
+            void deallocate(T *ptr, size_type n = 1)
+            {
+                if (ptr != nullptr)
+                    resource_->deallocate(ptr, n * sizeof(T), alignof(T));
+            }
+
+            T *allocate_chain(size_type n)
+            {
+                T *head = nullptr;
+                try
+                {
+                    for (; n > 0; --n)
+                    {
+                        T *p = allocate(1);
+                        *reinterpret_cast<T **>(p) = head;
+                        head = p;
+                    }
+                }
+                catch (...)
+                {
+                    while (head != nullptr)
+                    {
+                        T *next = chain_next(head);
+                        deallocate(head);
+                        head = next;
+                    }
+                    throw;
+                }
+                return head;
+            }
+
+            static T *chain_next(T *p) noexcept { return allocator<T>::chain_next(p); }
+
+            bool deallocate_is_noop() const noexcept { return resource_->is_monotonic(); }
+
+            static void construct(T *ptr) { allocator<T>::construct(ptr); }
+            static void construct(T *ptr, const T &value) { allocator<T>::construct(ptr, value); }
+            static void construct(T *ptr, T &&value) { allocator<T>::construct(ptr, std::move(value)); }
+
+            template <class... Args>
+            static void construct(T *ptr, Args &&...args)
+            {
+                allocator<T>::construct(ptr, std::forward<Args>(args)...);
+            }
+
+            static void destroy(T *ptr) { allocator<T>::destroy(ptr); }
+            static void destroy(T *first, T *last) { allocator<T>::destroy(first, last); }
+        };
+
+        template <class T, class U>
+        bool operator==(const polymorphic_allocator<T> &a, const polymorphic_allocator<U> &b) noexcept
+        {
+            return *a.resource() == *b.resource();
+        }
+
+        template <class T, class U>
+        bool operator!=(const polymorphic_allocator<T> &a, const polymorphic_allocator<U> &b) noexcept
+        {
+            return !(a == b);
+        }
+    } // namespace pmr
+
+} // namespace cheamstl
+
+#endif // !CHEAMSTL_ALLOCATOR_H_
@@ -0,0 +1,747 @@
+#ifndef CHEAMSTL_COMPACT_LIST_H_
+#define CHEAMSTL_COMPACT_LIST_H_
+
+/* compact_list：用下标代替指针的双向链表
+ * 64 位下 list_node<int> 的 prev/next 要 16 字节，节点共 24 字节，只为了存 4 字节的数据。
+ * compact_list 把所有元素放在一块连续、可增长的槽数组里，槽之间用 IndexT（默认 32 位）下标相连：
+ * 1. 每个元素只多出 2 * sizeof(IndexT) 字节，int 的槽是 12 字节。与默认的 pool_allocator（没有块头，
+ *    每个节点 24 字节）相比正好省一半，与每个节点单独 malloc（glibc 下实际占 32 字节）相比省得更多
+ * 2. 删除的槽挂进内部的空闲链表，下一次插入优先复用；槽数组用完时整体扩容为两倍，
+ *    因此最多有一半的槽空着：list_benchmark 的 memory 用例中，逐个插入 1000 万个 int 约 20 字节/元素，
+ *    reserve 或 compact() 之后才是 12 字节/元素
+ * 3. 元素都在同一块内存里，遍历的局部性比散落在堆上的节点好得多；compact() 可以按链表顺序重新排列
+ * 4. 元素个数上限是 IndexT 能表示的最大值（uint32_t 约 42 亿）
+ *
+ * 迭代器保存的是“槽数组的所有者 + 下标”，因此与 list 一样，插入不会使任何迭代器失效，
+ * 删除只使指向被删元素的迭代器失效；但扩容会搬移元素，指向元素的指针和引用会失效（可以先 reserve）。
+ * 与 list 的不同之处：
+ * 1. 迭代器属于当前对象，swap / 移动之后不再指向原来的元素
+ * 2. 同一链表内的 splice 只改下标，是 O(1) 的；跨链表的 splice 要把元素移动到本链表的槽里，
+ *    是 O(k) 的，被移动元素的迭代器失效 */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "allocator.h"
+#include "exceptdef.h"
+#include "iterator.h"
+
+namespace cheamstl
+{
+
+    /* 槽：两个下标 + 未构造的元素存储。0 号槽是哨兵，不存放元素 */
+    template <class T, class IndexT>
+    struct compact_list_slot
+    {
+        IndexT prev;
+        IndexT next;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type data;
+
+        T *value() noexcept { return reinterpret_cast<T *>(&data); }
+    };
+
+    /* 槽数组：[1, used) 的槽都分配出去过，其中已删除的挂在 free 开头的空闲链表上（用 next 相连，0 表示结束）；
+     * [used, capacity) 是从未使用过的槽。slots 为空时链表一定为空，第一次插入时才申请内存 */
+    template <class T, class IndexT>
+    struct compact_list_pool
+    {
+        typedef compact_list_slot<T, IndexT> slot_type;
+
+        slot_type *slots;
+        size_t capacity;
+        size_t used;
+        IndexT free;
+    };
+
+    template <class T, class IndexT, bool IsConst>
+    struct compact_list_iterator
+    {
+        typedef cheamstl::bidirectional_iterator_tag iterator_category;
+        typedef ptrdiff_t difference_type;
+        typedef T value_type;
+        typedef typename std::conditional<IsConst, const T *, T *>::type pointer;
+        typedef typename std::conditional<IsConst, const T &, T &>::type reference;
+        typedef compact_list_pool<T, IndexT> pool_type;
+        typedef compact_list_iterator self;
+
+        pool_type *pool_; // 所属链表的槽数组，扩容后依然有效
+        IndexT idx_;      // 槽下标，end() 时为 0
+
+        compact_list_iterator() = default;
+        compact_list_iterator(pool_type *p, IndexT i) : pool_(p), idx_(i) {}
+        /* 普通迭代器可以隐式转换成常量迭代器 */
+        template <bool C, typename std::enable_if<IsConst && !C, int>::type = 0>
+        compact_list_iterator(const compact_list_iterator<T, IndexT, C> &rhs) : pool_(rhs.pool_), idx_(rhs.idx_) {}
+
+        reference operator*() const { return *pool_->slots[idx_].value(); }
+        pointer operator->() const { return &(operator*()); }
+
+        self &operator++()
+        {
+            idx_ = pool_->slots[idx_].next;
+            return *this;
+        }
+        self operator++(int)
+        {
+            self tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        self &operator--()
+        {
+            idx_ = pool_->slots[idx_].prev;
+            return *this;
+        }
+        self operator--(int)
+        {
+            self tmp = *this;
+            --*this;
+            return tmp;
+        }
+
+        bool operator==(const self &rhs) const { return idx_ == rhs.idx_ && pool_ == rhs.pool_; }
+        bool operator!=(const self &rhs) const { return !(*this == rhs); }
+    };
+
+    template <class T, class IndexT = uint32_t>
+    class compact_list
+    {
+        static_assert(std::is_unsigned<IndexT>::value, "compact_list needs an unsigned index type");
+
+    public:
+        typedef cheamstl::allocator<T> allocator_type;
+        typedef cheamstl::allocator<T> data_allocator;
+        typedef compact_list_slot<T, IndexT> slot_type;
+        typedef cheamstl::allocator<slot_type> slot_allocator;
+        typedef compact_list_pool<T, IndexT> pool_type;
+        typedef IndexT index_type;
+
+        typedef T value_type;
+        typedef T *pointer;
+        typedef const T *const_pointer;
+        typedef T &reference;
+        typedef const T &const_reference;
+        typedef size_t size_type;
+        typedef ptrdiff_t difference_type;
+
+        typedef compact_list_iterator<T, IndexT, false> iterator;
+        typedef compact_list_iterator<T, IndexT, true> const_iterator;
+        typedef cheamstl::reverse_iterator<iterator> reverse_iterator;
+        typedef cheamstl::reverse_iterator<const_iterator> const_reverse_iterator;
+
+        /* 第一次申请槽数组时的槽数 */
+        static constexpr size_type initial_capacity = 16;
+
+    private:
+        pool_type pool_;
+        size_type size_;
+
+    public:
+        compact_list() noexcept : size_(0) { reset_pool(); }
+
+        explicit compact_list(size_type n) : size_(0)
+        {
+            reset_pool();
+            fill_init(n, value_type());
+        }
+
+        compact_list(size_type n, const T &value) : size_(0)
+        {
+            reset_pool();
+            fill_init(n, value);
+        }
+
+        template <class Iter, typename std::enable_if<cheamstl::is_input_iterator<Iter>::value, int>::type = 0>
+        compact_list(Iter first, Iter last) : size_(0)
+        {
+            reset_pool();
+            copy_init(first, last);
+        }
+
+        compact_list(std::initializer_list<T> ilist) : size_(0)
+        {
+            reset_pool();
+            reserve(ilist.size());
+            copy_init(ilist.begin(), ilist.end());
+        }
+
+        /* 元素可以平凡复制时直接复制整个槽数组（连同空闲链表），否则按顺序逐个复制，得到的副本是紧凑的 */
+        compact_list(const compact_list &rhs) : size_(0)
+        {
+            reset_pool();
+            copy_from(rhs, std::integral_constant<bool, std::is_trivially_copyable<T>::value>());
+        }
+
+        compact_list(compact_list &&rhs) noexcept : pool_(rhs.pool_), size_(rhs.size_)
+        {
+            rhs.reset_pool();
+            rhs.size_ = 0;
+        }
+
+        compact_list &operator=(const compact_list &rhs)
+        {
+            if (this != &rhs)
+            {
+                compact_list tmp(rhs);
+                swap(tmp);
+            }
+            return *this;
+        }
+
+        compact_list &operator=(compact_list &&rhs) noexcept
+        {
+            if (this != &rhs)
+            {
+                compact_list tmp(std::move(rhs));
+                swap(tmp);
+            }
+            return *this;
+        }
+
+        compact_list &operator=(std::initializer_list<T> ilist)
+        {
+            compact_list tmp(ilist);
+            swap(tmp);
+            return *this;
+        }
+
+        ~compact_list()
+        {
+            clear();
+            if (pool_.slots != nullptr)
+                slot_allocator::deallocate(pool_.slots, pool_.capacity);
+        }
+
+    public:
+        // 迭代器相关操作
+        iterator begin() noexcept { return iterator(pool(), first_index()); }
+        const_iterator begin() const noexcept { return const_iterator(pool(), first_index()); }
+        iterator end() noexcept { return iterator(pool(), 0); }
+        const_iterator end() const noexcept { return const_iterator(pool(), 0); }
+
+        reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+        const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+        reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+        const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+
+        const_iterator cbegin() const noexcept { return begin(); }
+        const_iterator cend() const noexcept { return end(); }
+        const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+        const_reverse_iterator crend() const noexcept { return rend(); }
+
+        // 容量相关操作
+        bool empty() const noexcept { return size_ == 0; }
+        size_type size() const noexcept { return size_; }
+        /* 下标不能超出 IndexT 的范围，槽数组的字节数也不能超出 size_t；
+         * IndexT 与 size_t 一样宽时由后者决定，这样 max_size() + 1（含哨兵的槽数）不会回绕 */
+        size_type max_size() const noexcept
+        {
+            return static_cast<size_type>(std::numeric_limits<IndexT>::max()) <
+                           std::numeric_limits<size_type>::max() / sizeof(slot_type)
+                       ? static_cast<size_type>(std::numeric_limits<IndexT>::max())
+                       : std::numeric_limits<size_type>::max() / sizeof(slot_type) - 1;
+        }
+
+        /* 不扩容就能容纳的元素个数（哨兵占用一个槽） */
+        size_type capacity() const noexcept { return pool_.capacity == 0 ? 0 : pool_.capacity - 1; }
+
+        /* 预留 n 个元素的槽，之后的插入不会扩容，元素的地址保持不变 */
+        void reserve(size_type n)
+        {
+            THROW_LENGTH_ERROR_IF(n > max_size(), "compact_list<T>'s size too big");
+            if (n != 0 && n + 1 > pool_.capacity)
+                grow(n + 1);
+        }
+
+        // 访问元素相关操作
+        reference front()
+        {
+            CHEAMSTL_DEBUG(!empty());
+            return *begin();
+        }
+        const_reference front() const
+        {
+            CHEAMSTL_DEBUG(!empty());
+            return *begin();
+        }
+        reference back()
+        {
+            CHEAMSTL_DEBUG(!empty());
+            return *pool_.slots[pool_.slots[0].prev].value();
+        }
+        const_reference back() const
+        {
+            CHEAMSTL_DEBUG(!empty());
+            return *pool_.slots[pool_.slots[0].prev].value();
+        }
+
+        // assign
+        void assign(size_type n, const value_type &value)
+        {
+            compact_list tmp(n, value);
+            swap(tmp);
+        }
+
+        template <class Iter, typename std::enable_if<cheamstl::is_input_iterator<Iter>::value, int>::type = 0>
+        void assign(Iter first, Iter last)
+        {
+            compact_list tmp(first, last);
+            swap(tmp);
+        }
+
+        void assign(std::initializer_list<T> ilist) { assign(ilist.begin(), ilist.end()); }
+
+        // emplace_front / emplace_back / emplace
+        template <class... Args>
+        void emplace_front(Args &&...args)
+        {
+            link_before(first_index(), create_slot(std::forward<Args>(args)...));
+        }
+
+        template <class... Args>
+        void emplace_back(Args &&...args)
+        {
+            link_before(0, create_slot(std::forward<Args>(args)...));
+        }
+
+        template <class... Args>
+        iterator emplace(const_iterator pos, Args &&...args)
+        {
+            IndexT i = create_slot(std::forward<Args>(args)...);
+            link_before(pos.idx_, i);
+            return iterator(pool(), i);
+        }
+
+        // insert
+        iterator insert(const_iterator pos, const value_type &value) { return emplace(pos, value); }
+        iterator insert(const_iterator pos, value_type &&value) { return emplace(pos, std::move(value)); }
+
+        iterator insert(const_iterator pos, size_type n, const value_type &value)
+        {
+            compact_list tmp(n, value);
+            return splice_from(pos, tmp, tmp.cbegin(), tmp.cend(), n);
+        }
+
+        template <class Iter, typename std::enable_if<cheamstl::is_input_iterator<Iter>::value, int>::type = 0>
+        iterator insert(const_iterator pos, Iter first, Iter last)
+        {
+            compact_list tmp(first, last);
+            return splice_from(pos, tmp, tmp.cbegin(), tmp.cend(), tmp.size_);
+        }
+
+        iterator insert(const_iterator pos, std::initializer_list<T> ilist) { return insert(pos, ilist.begin(), ilist.end()); }
+
+        // push_front / push_back
+        void push_front(const value_type &value) { emplace_front(value); }
+        void push_front(value_type &&value) { emplace_front(std::move(value)); }
+        void push_back(const value_type &value) { emplace_back(value); }
+        void push_back(value_type &&value) { emplace_back(std::move(value)); }
+
+        // pop_front / pop_back
+        void pop_front() noexcept
+        {
+            CHEAMSTL_DEBUG(!empty());
+            erase(cbegin());
+        }
+
+        void pop_back() noexcept
+        {
+            CHEAMSTL_DEBUG(!empty());
+            erase(const_iterator(pool(), pool_.slots[0].prev));
+        }
+
+        // erase / clear
+        iterator erase(const_iterator pos) noexcept;
+        iterator erase(const_iterator first, const_iterator last) noexcept;
+
+        /* 清空元素但保留槽数组，之后的插入不需要重新申请内存 */
+        void clear() noexcept;
+
+        void swap(compact_list &rhs) noexcept
+        {
+            std::swap(pool_, rhs.pool_);
+            std::swap(size_, rhs.size_);
+        }
+
+        /* 链表特有的操作 */
+        void splice(const_iterator pos, compact_list &other);
+        void splice(const_iterator pos, compact_list &other, const_iterator it);
+        void splice(const_iterator pos, compact_list &other, const_iterator first, const_iterator last);
+
+        void sort() { sort(std::less<T>()); }
+        template <class Compared>
+        void sort(Compared comp);
+
+        /* 按链表顺序把元素搬到一块大小正好的新槽数组里：之后的遍历是顺序访存，并且释放多余的槽。
+         * 所有迭代器、指针和引用都会失效 */
+        void compact();
+
+    private:
+        pool_type *pool() const noexcept { return const_cast<pool_type *>(&pool_); }
+        IndexT first_index() const noexcept { return pool_.slots == nullptr ? 0 : pool_.slots[0].next; }
+
+        void reset_pool() noexcept
+        {
+            pool_.slots = nullptr;
+            pool_.capacity = 0;
+            pool_.used = 0;
+            pool_.free = 0;
+        }
+
+        // 槽的分配与释放
+        template <class... Args>
+        IndexT create_slot(Args &&...args);
+        void destroy_slot(IndexT i) noexcept;
+        void grow(size_type slots);
+        size_type next_capacity() const;
+
+        // 在 pos 之前连接一个槽 / [first, last] 一段槽；断开 [first, last] 一段槽
+        void link_before(IndexT pos, IndexT i) noexcept;
+        void link_range_before(IndexT pos, IndexT first, IndexT last) noexcept;
+        void unlink_range(IndexT first, IndexT last) noexcept;
+
+        void fill_init(size_type n, const value_type &value);
+        template <class Iter>
+        void copy_init(Iter first, Iter last);
+        void copy_from(const compact_list &rhs, std::true_type);
+        void copy_from(const compact_list &rhs, std::false_type);
+
+        iterator splice_from(const_iterator pos, compact_list &other, const_iterator first, const_iterator last,
+                             size_type n);
+    };
+
+    /*****************************************************************************************/
+
+    /* 取一个空槽并在其中构造元素：优先复用空闲链表，其次用从未使用过的槽，都没有时扩容。
+     * 扩容会搬移元素，而参数可能引用链表中的元素，所以扩容前先构造一个临时对象 */
+    template <class T, class IndexT>
+    template <class... Args>
+    IndexT compact_list<T, IndexT>::create_slot(Args &&...args)
+    {
+        if (pool_.free == 0 && pool_.used == pool_.capacity)
+        {
+            THROW_LENGTH_ERROR_IF(size_ >= max_size(), "compact_list<T>'s size too big");
+            value_type tmp(std::forward<Args>(args)...);
+            grow(next_capacity());
+            return create_slot(std::move(tmp));
+        }
+        IndexT i = pool_.free != 0 ? pool_.free : static_cast<IndexT>(pool_.used);
+        data_allocator::construct(pool_.slots[i].value(), std::forward<Args>(args)...);
+        if (i == pool_.free)
+            pool_.free = pool_.slots[i].next;
+        else
+            ++pool_.used;
+        ++size_;
+        return i;
+    }
+
+    // 析构元素并把槽挂回空闲链表，调用前槽已经从链表中断开
+    template <class T, class IndexT>
+    void compact_list<T, IndexT>::destroy_slot(IndexT i) noexcept
+    {
+        data_allocator::destroy(pool_.slots[i].value());
+        pool_.slots[i].next = pool_.free;
+        pool_.free = i;
+        --size_;
+    }
+
+    template <class T, class IndexT>
+    typename compact_list<T, IndexT>::size_type compact_list<T, IndexT>::next_capacity() const
+    {
+        size_type limit = max_size() + 1;
+        if (pool_.capacity == 0)
+            return initial_capacity < limit ? initial_capacity : limit;
+        return pool_.capacity > limit / 2 ? limit : pool_.capacity * 2;
+    }
+
+    /* 把槽数组扩大到 slots 个槽，每个元素留在原来的下标上，因此迭代器依然有效。
+     * 元素的移动构造可能抛出异常时改用复制，出错时原数组保持不变 */
+    template <class T, class IndexT>
+    void compact_list<T, IndexT>::grow(size_type slots)
+    {
+        slot_type *fresh = slot_allocator::allocate(slots);
+        if (pool_.slots == nullptr)
+        {
+            fresh[0].prev = fresh[0].next = 0;
+            pool_.used = 1;
+        }
+        else if (std::is_trivially_copyable<T>::value)
+        {
+            std::memcpy(static_cast<void *>(fresh), pool_.slots, pool_.used * sizeof(slot_type));
+        }
+        else
+        {
+            /* 空闲槽里没有元素，只复制下标；有元素的槽沿链表找到 */
+            for (size_type i = 0; i < pool_.used; ++i)
+            {
+                fresh[i].prev = pool_.slots[i].prev;
+                fresh[i].next = pool_.slots[i].next;
+            }
+            IndexT i = pool_.slots[0].next;
+            try
+            {
+                for (; i != 0; i = pool_.slots[i].next)
+                    data_allocator::construct(fresh[i].value(), std::move_if_noexcept(*pool_.slots[i].value()));
+            }
+            catch (...)
+            {
+                for (IndexT j = pool_.slots[0].next; j != i; j = pool_.slots[j].next)
+                    data_allocator::destroy(fresh[j].value());
+                slot_allocator::deallocate(fresh, slots);
+                throw;
+            }
+            for (i = pool_.slots[0].next; i != 0; i = pool_.slots[i].next)
+                data_allocator::destroy(pool_.slots[i].value());
+        }
+        if (pool_.slots != nullptr)
+            slot_allocator::deallocate(pool_.slots, pool_.capacity);
+        pool_.slots = fresh;
+        pool_.capacity = slots;
+    }
+
+    template <class T, class IndexT>
+    void compact_list<T, IndexT>::link_before(IndexT pos, IndexT i) noexcept
+    {
+        link_range_before(pos, i, i);
+    }
+
+    template <class T, class IndexT>
+    void compact_list<T, IndexT>::link_range_before(IndexT pos, IndexT first, IndexT last) noexcept
+    {
+        slot_type *s = pool_.slots;
+        IndexT prev = s[pos].prev;
+        s[first].prev = prev;
+        s[prev].next = first;
+        s[last].next = pos;
+        s[pos].prev = last;
+    }
+
+    template <class T, class IndexT>
+    void compact_list<T, IndexT>::unlink_range(IndexT first, IndexT last) noexcept
+    {
+        slot_type *s = pool_.slots;
+        s[s[first].prev].next = s[last].next;
+        s[s[last].next].prev = s[first].prev;
+    }
+
+    // 删除 pos 处的元素
+    template <class T, class IndexT>
+    typename compact_list<T, IndexT>::iterator compact_list<T, IndexT>::erase(const_iterator pos) noexcept
+    {
+        CHEAMSTL_DEBUG(pos != cend());
+        IndexT i = pos.idx_;
+        IndexT next = pool_.slots[i].next;
+        unlink_range(i, i);
+        destroy_slot(i);
+        return iterator(pool(), next);
+    }
+
+    // 删除 [first, last) 内的元素
+    template <class T, class IndexT>
+    typename compact_list<T, IndexT>::iterator
+    compact_list<T, IndexT>::erase(const_iterator first, const_iterator last) noexcept
+    {
+        while (first != last)
+            first = erase(first);
+        return iterator(pool(), last.idx_);
+    }
+
+    template <class T, class IndexT>
+    void compact_list<T, IndexT>::clear() noexcept
+    {
+        if (pool_.slots == nullptr)
+            return;
+        if (!std::is_trivially_destructible<T>::value)
+        {
+            for (IndexT i = pool_.slots[0].next; i != 0; i = pool_.slots[i].next)
+                data_allocator::destroy(pool_.slots[i].value());
+        }
+        pool_.slots[0].prev = pool_.slots[0].next = 0;
+        pool_.used = 1;
+        pool_.free = 0;
+        size_ = 0;
+    }
+
+    // 将 other 整体接合于 pos 之前
+    template <class T, class IndexT>
+    void compact_list<T, IndexT>::splice(const_iterator pos, compact_list &other)
+    {
+        CHEAMSTL_DEBUG(this != &other);
+        splice_from(pos, other, other.cbegin(), other.cend(), other.size_);
+    }
+
+    // 将 it 所指的元素接合于 pos 之前
+    template <class T, class IndexT>
+    void compact_list<T, IndexT>::splice(const_iterator pos, compact_list &other, const_iterator it)
+    {
+        if (this == &other)
+        {
+            if (pos.idx_ != it.idx_ && pos.idx_ != pool_.slots[it.idx_].next)
+            {
+                unlink_range(it.idx_, it.idx_);
+                link_before(pos.idx_, it.idx_);
+            }
+            return;
+        }
+        const_iterator next = it;
+        splice_from(pos, other, it, ++next, 1);
+    }
+
+    // 将 other 的 [first, last) 内的元素接合于 pos 之前
+    template <class T, class IndexT>
+    void compact_list<T, IndexT>::splice(const_iterator pos, compact_list &other, const_iterator first,
+                                         const_iterator last)
+    {
+        if (first == last)
+            return;
+        if (this == &other)
+        {
+            if (pos == first || pos == last)
+                return;
+            IndexT l = pool_.slots[last.idx_].prev;
+            unlink_range(first.idx_, l);
+            link_range_before(pos.idx_, first.idx_, l);
+            return;
+        }
+        splice_from(pos, other, first, last, static_cast<size_type>(cheamstl::distance(first, last)));
+    }
+
+    /* 跨链表接合：两个链表的槽数组不同，只能把 n 个元素逐个移动到本链表的槽里再从 other 中删除。
+     * 先一次预留够槽，避免中途多次扩容；返回第一个移入的元素 */
+    template <class T, class IndexT>
+    typename compact_list<T, IndexT>::iterator
+    compact_list<T, IndexT>::splice_from(const_iterator pos, compact_list &other, const_iterator first,
+                                         const_iterator last, size_type n)
+    {
+        if (n == 0)
+            return iterator(pool(), pos.idx_);
+        THROW_LENGTH_ERROR_IF(size_ > max_size() - n, "compact_list<T>'s size too big");
+        /* 与逐个插入一样按倍数扩容，否则逐个元素地跨链表接合时每次都要搬移整个槽数组 */
+        if (size_ + n + 1 > pool_.capacity)
+        {
+            size_type want = next_capacity();
+            grow(want > size_ + n + 1 ? want : size_ + n + 1);
+        }
+        IndexT head = 0;
+        while (first != last)
+        {
+            IndexT i = create_slot(std::move(*other.pool_.slots[first.idx_].value()));
+            link_before(pos.idx_, i);
+            if (head == 0)
+                head = i;
+            first = other.erase(first);
+        }
+        return iterator(pool(), head);
+    }
+
+    /* 排序：把下标收集到数组里稳定排序，再按顺序重新连接，元素本身不移动，迭代器依然有效 */
+    template <class T, class IndexT>
+    template <class Compared>
+    void compact_list<T, IndexT>::sort(Compared comp)
+    {
+        if (size_ < 2)
+            return;
+        slot_type *s = pool_.slots;
+        std::vector<IndexT> order;
+        order.reserve(size_);
+        for (IndexT i = s[0].next; i != 0; i = s[i].next)
+            order.push_back(i);
+        std::stable_sort(order.begin(), order.end(), [s, &comp](IndexT a, IndexT b)
+                         { return comp(*s[a].value(), *s[b].value()); });
+        IndexT prev = 0;
+        for (IndexT i : order)
+        {
+            s[i].prev = prev;
+            s[prev].next = i;
+            prev = i;
+        }
+        s[prev].next = 0;
+        s[0].prev = prev;
+    }
+
+    template <class T, class IndexT>
+    void compact_list<T, IndexT>::compact()
+    {
+        compact_list tmp;
+        if (!empty())
+        {
+            tmp.reserve(size_);
+            for (IndexT i = pool_.slots[0].next; i != 0; i = pool_.slots[i].next)
+                tmp.emplace_back(std::move_if_noexcept(*pool_.slots[i].value()));
+        }
+        swap(tmp);
+    }
+
+    /*****************************************************************************************/
+    // helper function
+
+    template <class T, class IndexT>
+    void compact_list<T, IndexT>::fill_init(size_type n, const value_type &value)
+    {
+        reserve(n);
+        try
+        {
+            for (; n > 0; --n)
+                emplace_back(value);
+        }
+        catch (...)
+        {
+            clear();
+            throw;
+        }
+    }
+
+    template <class T, class IndexT>
+    template <class Iter>
+    void compact_list<T, IndexT>::copy_init(Iter first, Iter last)
+    {
+        try
+        {
+            for (; first != last; ++first)
+                emplace_back(*first);
+        }
+        catch (...)
+        {
+            clear();
+            throw;
+        }
+    }
+
+    template <class T, class IndexT>
+    void compact_list<T, IndexT>::copy_from(const compact_list &rhs, std::true_type)
+    {
+        if (rhs.pool_.slots == nullptr)
+            return;
+        pool_.slots = slot_allocator::allocate(rhs.pool_.capacity);
+        std::memcpy(static_cast<void *>(pool_.slots), rhs.pool_.slots, rhs.pool_.used * sizeof(slot_type));
+        pool_.capacity = rhs.pool_.capacity;
+        pool_.used = rhs.pool_.used;
+        pool_.free = rhs.pool_.free;
+        size_ = rhs.size_;
+    }
+
+    template <class T, class IndexT>
+    void compact_list<T, IndexT>::copy_from(const compact_list &rhs, std::false_type)
+    {
+        reserve(rhs.size_);
+        copy_init(rhs.begin(), rhs.end());
+    }
+
+    template <class T, class IndexT>
+    void swap(compact_list<T, IndexT> &lhs, compact_list<T, IndexT> &rhs) noexcept
+    {
+        lhs.swap(rhs);
+    }
+
+} // namespace cheamstl
+
+#endif // !CHEAMSTL_COMPACT_LIST_H_
@@ -0,0 +1,276 @@
+#ifndef CHEAMSTL_CONCURRENT_QUEUE_H_
+#define CHEAMSTL_CONCURRENT_QUEUE_H_
+
+/* 无锁队列，用来替代“list + mutex”的生产者 / 消费者交接：
+ * mpsc_queue<T>       : 多生产者单消费者，Vyukov 算法，入队是无等待的（一次 exchange + 一次 store）
+ * concurrent_queue<T> : 多生产者多消费者，Michael-Scott 算法，入队 / 出队都是无锁的，
+ *                       出队后的节点通过 hazard pointer 延迟回收，避免 ABA 和释放后访问
+ *
+ * 节点沿用 list_node<T> 的布局：两个指针槽 + 元素。
+ * 第二个槽是队列的 next（原子指针）；第一个槽在 list 中是 prev，这里用来串起等待回收的节点，
+ * 因此回收链表本身不需要额外分配内存
+ *
+ * 注意：pool_allocator 的空闲链表是线程本地的，节点在生产者线程分配、在消费者线程释放时，
+ * 内存会不断迁移到消费者线程，所以这里默认使用通用的 allocator；
+ * 需要节点池时可以选 thread_cache_allocator，跨线程释放的节点会成批还给生产者线程 */
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "allocator.h"
+#include "hazard_pointer.h"
+#include "list.h"
+
+namespace cheamstl
+{
+
+    template <class T>
+    struct concurrent_queue_node
+    {
+        concurrent_queue_node *retire_next;             // 对应 list_node 的 prev：等待回收时的链接
+        std::atomic<concurrent_queue_node *> next;      // 对应 list_node 的 next
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage; // 哨兵节点中没有元素
+
+        T *value() noexcept { return reinterpret_cast<T *>(&storage); }
+    };
+
+    /*****************************************************************************************/
+    /* 多生产者单消费者队列
+     * back_ 是生产者一侧，front_ 是消费者一侧，front_ 始终指向一个不含元素的哨兵。
+     * 入队：exchange 抢到 back_ 的位置，再把前一个节点的 next 指向自己，两步都不会失败；
+     * 出队：只有一个消费者，直接读 front_->next。生产者处于两步之间时，消费者暂时看不到这个元素 */
+    template <class T, class Alloc = cheamstl::allocator<T>>
+    class mpsc_queue
+    {
+    public:
+        typedef T value_type;
+        typedef size_t size_type;
+        typedef concurrent_queue_node<T> node_type;
+        typedef typename Alloc::template rebind<node_type>::other node_allocator;
+        typedef Alloc data_allocator;
+
+    private:
+        alignas(64) std::atomic<node_type *> back_;
+        alignas(64) node_type *front_;
+
+    public:
+        mpsc_queue() : back_(nullptr), front_(nullptr)
+        {
+            node_type *stub = new_node();
+            back_.store(stub, std::memory_order_relaxed);
+            front_ = stub;
+        }
+
+        mpsc_queue(const mpsc_queue &) = delete;
+        mpsc_queue &operator=(const mpsc_queue &) = delete;
+
+        ~mpsc_queue()
+        {
+            node_type *cur = front_->next.load(std::memory_order_acquire);
+            node_allocator::deallocate(front_);
+            while (cur != nullptr)
+            {
+                node_type *next = cur->next.load(std::memory_order_acquire);
+                data_allocator::destroy(cur->value());
+                node_allocator::deallocate(cur);
+                cur = next;
+            }
+        }
+
+        // 任意线程都可以调用
+        void push(const value_type &value) { emplace(value); }
+        void push(value_type &&value) { emplace(std::move(value)); }
+
+        template <class... Args>
+        void emplace(Args &&...args)
+        {
+            node_type *n = new_node();
+            try
+            {
+                data_allocator::construct(n->value(), std::forward<Args>(args)...);
+            }
+            catch (...)
+            {
+                node_allocator::deallocate(n);
+                throw;
+            }
+            node_type *prev = back_.exchange(n, std::memory_order_acq_rel);
+            prev->next.store(n, std::memory_order_release);
+        }
+
+        // 只能由唯一的消费者线程调用
+        bool try_pop(value_type &out)
+        {
+            node_type *next = front_->next.load(std::memory_order_acquire);
+            if (next == nullptr)
+                return false;
+            out = std::move(*next->value());
+            data_allocator::destroy(next->value());
+            node_allocator::deallocate(front_);
+            front_ = next; // next 成为新的哨兵
+            return true;
+        }
+
+        // 只能由消费者线程调用
+        bool empty() const noexcept
+        {
+            return front_->next.load(std::memory_order_acquire) == nullptr;
+        }
+
+    private:
+        static node_type *new_node()
+        {
+            node_type *n = node_allocator::allocate(1);
+            n->retire_next = nullptr;
+            ::new ((void *)&n->next) std::atomic<node_type *>(nullptr);
+            return n;
+        }
+    };
+
+    /*****************************************************************************************/
+    /* 多生产者多消费者队列（Michael-Scott）
+     * head_ 指向哨兵，tail_ 指向最后一个节点（可能暂时落后一步，由其他线程帮忙推进）。
+     * 出队的线程 CAS 成功把 head_ 推进到 next 之后，才从 next 中取出元素，next 成为新的哨兵；
+     * 旧的哨兵交给 hazard_domain 延迟回收 */
+    template <class T, class Alloc = cheamstl::allocator<T>>
+    class concurrent_queue
+    {
+    public:
+        typedef T value_type;
+        typedef size_t size_type;
+        typedef concurrent_queue_node<T> node_type;
+        typedef typename Alloc::template rebind<node_type>::other node_allocator;
+        typedef Alloc data_allocator;
+        typedef hazard_domain<node_type, node_allocator> domain;
+
+        static_assert(sizeof(node_type) == sizeof(list_node<T>), "concurrent_queue_node should match list_node<T>");
+
+    private:
+        alignas(64) std::atomic<node_type *> head_;
+        alignas(64) std::atomic<node_type *> tail_;
+
+    public:
+        concurrent_queue() : head_(nullptr), tail_(nullptr)
+        {
+            node_type *stub = new_node();
+            head_.store(stub, std::memory_order_relaxed);
+            tail_.store(stub, std::memory_order_relaxed);
+        }
+
+        concurrent_queue(const concurrent_queue &) = delete;
+        concurrent_queue &operator=(const concurrent_queue &) = delete;
+
+        /* 析构时不能再有其他线程访问队列 */
+        ~concurrent_queue()
+        {
+            node_type *h = head_.load(std::memory_order_acquire);
+            node_type *cur = h->next.load(std::memory_order_acquire);
+            node_allocator::deallocate(h);
+            while (cur != nullptr)
+            {
+                node_type *next = cur->next.load(std::memory_order_acquire);
+                data_allocator::destroy(cur->value());
+                node_allocator::deallocate(cur);
+                cur = next;
+            }
+            domain::flush();
+        }
+
+        void push(const value_type &value) { emplace(value); }
+        void push(value_type &&value) { emplace(std::move(value)); }
+
+        template <class... Args>
+        void emplace(Args &&...args)
+        {
+            node_type *n = new_node();
+            try
+            {
+                data_allocator::construct(n->value(), std::forward<Args>(args)...);
+            }
+            catch (...)
+            {
+                node_allocator::deallocate(n);
+                throw;
+            }
+            typename domain::record *r = domain::acquire();
+            for (;;)
+            {
+                node_type *t = domain::protect(r, 0, tail_);
+                node_type *next = t->next.load(std::memory_order_acquire);
+                if (t != tail_.load(std::memory_order_acquire))
+                    continue;
+                if (next != nullptr)
+                {
+                    /* tail_ 落后了，帮忙推进 */
+                    tail_.compare_exchange_weak(t, next, std::memory_order_release, std::memory_order_relaxed);
+                    continue;
+                }
+                node_type *expected = nullptr;
+                if (t->next.compare_exchange_weak(expected, n, std::memory_order_release, std::memory_order_relaxed))
+                {
+                    tail_.compare_exchange_strong(t, n, std::memory_order_release, std::memory_order_relaxed);
+                    break;
+                }
+            }
+            domain::clear(r);
+        }
+
+        bool try_pop(value_type &out)
+        {
+            typename domain::record *r = domain::acquire();
+            for (;;)
+            {
+                node_type *h = domain::protect(r, 0, head_);
+                node_type *t = tail_.load(std::memory_order_acquire);
+                node_type *next = domain::protect(r, 1, h->next);
+                if (h != head_.load(std::memory_order_acquire))
+                    continue;
+                if (next == nullptr)
+                {
+                    domain::clear(r);
+                    return false;
+                }
+                if (h == t)
+                {
+                    tail_.compare_exchange_weak(t, next, std::memory_order_release, std::memory_order_relaxed);
+                    continue;
+                }
+                if (head_.compare_exchange_weak(h, next, std::memory_order_acq_rel, std::memory_order_relaxed))
+                {
+                    /* 只有 CAS 成功的线程会访问 next 中的元素，槽 1 保证 next 在此期间不会被回收 */
+                    out = std::move(*next->value());
+                    data_allocator::destroy(next->value());
+                    domain::clear(r);
+                    domain::retire(h);
+                    return true;
+                }
+            }
+        }
+
+        /* 并发情况下只是一个瞬时的判断。
+         * 读 head_->next 需要先用 hazard pointer 保护 head_，线程第一次使用时要申请记录，可能抛出 bad_alloc */
+        bool empty() const
+        {
+            typename domain::record *r = domain::acquire();
+            node_type *h = domain::protect(r, 0, head_);
+            bool result = h->next.load(std::memory_order_acquire) == nullptr;
+            domain::clear(r);
+            return result;
+        }
+
+    private:
+        static node_type *new_node()
+        {
+            node_type *n = node_allocator::allocate(1);
+            n->retire_next = nullptr;
+            ::new ((void *)&n->next) std::atomic<node_type *>(nullptr);
+            return n;
+        }
+    };
+
+} // namespace cheamstl
+
+#endif // !CHEAMSTL_CONCURRENT_QUEUE_H_
@@ -0,0 +1,28 @@
+#ifndef CHEAMSTL_EXCEPTDEF_H_
+#define CHEAMSTL_EXCEPTDEF_H_
+
+/* 统一的断言与异常宏，容器里只使用这里的宏，便于以后统一修改 */
+
+#include <cassert>
+#include <stdexcept>
+
+namespace cheamstl
+{
+
+#define CHEAMSTL_DEBUG(expr) assert(expr)
+
+#define THROW_LENGTH_ERROR_IF(expr, what) \
+    if ((expr))                           \
+    throw std::length_error(what)
+
+#define THROW_OUT_OF_RANGE_IF(expr, what) \
+    if ((expr))                           \
+    throw std::out_of_range(what)
+
+#define THROW_RUNTIME_ERROR_IF(expr, what) \
+    if ((expr))                            \
+    throw std::runtime_error(what)
+
+} // namespace cheamstl
+
+#endif // !CHEAMSTL_EXCEPTDEF_H_
@@ -0,0 +1,26 @@
+#ifndef CHEAMSTL_EXECUTION_H_
+#define CHEAMSTL_EXECUTION_H_
+
+/* 执行策略标签：作为重载的第一个参数，用来显式选择串行或并行的版本
+ * 用法与 C++17 的 std::execution 相同，例如 l.sort(cheamstl::execution::par) */
+
+namespace cheamstl
+{
+    namespace execution
+    {
+
+        struct sequenced_policy
+        {
+        };
+
+        struct parallel_policy
+        {
+        };
+
+        constexpr sequenced_policy seq{};
+        constexpr parallel_policy par{};
+
+    } // namespace execution
+} // namespace cheamstl
+
+#endif // !CHEAMSTL_EXECUTION_H_
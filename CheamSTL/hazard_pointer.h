@@ -0,0 +1,235 @@
+#ifndef CHEAMSTL_HAZARD_POINTER_H_
+#define CHEAMSTL_HAZARD_POINTER_H_
+
+/* hazard_domain：无锁数据结构的延迟回收，concurrent_queue 和 persistent_list_cell 共用 */
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace cheamstl
+{
+
+    /* hazard pointer：每个线程有一条记录，里面有两个槽，声明“我正在访问这个节点”。
+     * 节点从共享结构中摘下后不会立刻释放，而是挂到本线程的回收链表上，攒够一定数量后扫描所有线程的槽，
+     * 只释放没有被任何槽引用的节点。每种节点类型一个独立的域。
+     * Node 需要一个 Node *retire_next 成员用来串起回收链表；回收时调用 NodeAlloc::deallocate(n)，
+     * 需要在回收前做别的事（例如析构节点里的对象）时，可以传入一个自定义的 NodeAlloc */
+    template <class Node, class NodeAlloc>
+    class hazard_domain
+    {
+    public:
+        static constexpr size_t slots = 2;
+
+        struct record
+        {
+            std::atomic<Node *> hp[slots];
+            std::atomic<bool> active;
+            record *next;
+        };
+
+    private:
+        /* 线程本地部分只包含平凡类型，thread_local 析构之后访问也是安全的 */
+        struct local_state
+        {
+            record *rec;
+            Node *retired;
+            size_t retired_count;
+            bool registered;
+        };
+
+        struct global_state
+        {
+            std::atomic<record *> records{nullptr};
+            std::atomic<size_t> record_count{0};
+            std::mutex mtx;
+            Node *orphans = nullptr; // 已退出线程留下、当时仍被引用的节点
+        };
+
+        /* 线程退出时归还记录，尚不能释放的节点交给全局的 orphan 链表 */
+        struct thread_guard
+        {
+            ~thread_guard()
+            {
+                local_state &l = local();
+                if (l.rec == nullptr)
+                    return;
+                for (size_t i = 0; i < slots; ++i)
+                    l.rec->hp[i].store(nullptr, std::memory_order_release);
+                scan(l);
+                if (l.retired != nullptr)
+                {
+                    global_state &g = global();
+                    std::lock_guard<std::mutex> lock(g.mtx);
+                    Node *tail = l.retired;
+                    while (tail->retire_next != nullptr)
+                        tail = tail->retire_next;
+                    tail->retire_next = g.orphans;
+                    g.orphans = l.retired;
+                    l.retired = nullptr;
+                    l.retired_count = 0;
+                }
+                l.rec->active.store(false, std::memory_order_release);
+                l.rec = nullptr;
+            }
+        };
+
+    public:
+        /* 当前线程的记录，第一次使用时申请（优先复用已退出线程留下的记录） */
+        static record *acquire()
+        {
+            local_state &l = local();
+            if (l.rec != nullptr)
+                return l.rec;
+            if (!l.registered)
+            {
+                static thread_local thread_guard guard;
+                (void)guard;
+                l.registered = true;
+            }
+            global_state &g = global();
+            for (record *r = g.records.load(std::memory_order_acquire); r != nullptr; r = r->next)
+            {
+                bool expected = false;
+                if (!r->active.load(std::memory_order_relaxed) &&
+                    r->active.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+                {
+                    l.rec = r;
+                    return r;
+                }
+            }
+            record *r = new record();
+            r->active.store(true, std::memory_order_relaxed);
+            r->next = g.records.load(std::memory_order_relaxed);
+            while (!g.records.compare_exchange_weak(r->next, r, std::memory_order_release, std::memory_order_relaxed))
+            {
+            }
+            g.record_count.fetch_add(1, std::memory_order_relaxed);
+            l.rec = r;
+            return r;
+        }
+
+        /* 读取 src 并登记到第 slot 个槽中；登记之后再读一次，确认在登记期间 src 没有变化 */
+        static Node *protect(record *r, size_t slot, const std::atomic<Node *> &src) noexcept
+        {
+            Node *p = src.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                r->hp[slot].store(p, std::memory_order_seq_cst);
+                Node *q = src.load(std::memory_order_seq_cst);
+                if (q == p)
+                    return p;
+                p = q;
+            }
+        }
+
+        static void clear(record *r) noexcept
+        {
+            for (size_t i = 0; i < slots; ++i)
+                r->hp[i].store(nullptr, std::memory_order_release);
+        }
+
+        /* 节点已经从共享结构中摘下，等到没有线程引用时再释放 */
+        static void retire(Node *n)
+        {
+            local_state &l = local();
+            n->retire_next = l.retired;
+            l.retired = n;
+            if (++l.retired_count >= threshold())
+            {
+                /* 扫描要申请一个临时数组；失败时节点仍在回收链表上，留到下次扫描，
+                 * 调用者已经把节点摘下（或换下），不应该因此收到异常 */
+                try
+                {
+                    scan(l);
+                }
+                catch (const std::bad_alloc &)
+                {
+                }
+            }
+        }
+
+        /* 立即尝试回收本线程的节点，例如在队列析构时调用 */
+        static void flush() { scan(local()); }
+
+    private:
+        static local_state &local() noexcept
+        {
+            static thread_local local_state l = {nullptr, nullptr, 0, false};
+            return l;
+        }
+
+        /* 故意泄漏：保证静态析构阶段仍然可用 */
+        static global_state &global()
+        {
+            static global_state *g = new global_state;
+            return *g;
+        }
+
+        static size_t threshold() noexcept
+        {
+            return 2 * slots * global().record_count.load(std::memory_order_relaxed) + 64;
+        }
+
+        static void scan(local_state &l)
+        {
+            global_state &g = global();
+            {
+                /* 顺便接手 orphan 链表 */
+                std::lock_guard<std::mutex> lock(g.mtx);
+                if (g.orphans != nullptr)
+                {
+                    Node *tail = g.orphans;
+                    size_t n = 1;
+                    for (; tail->retire_next != nullptr; tail = tail->retire_next)
+                        ++n;
+                    tail->retire_next = l.retired;
+                    l.retired = g.orphans;
+                    l.retired_count += n;
+                    g.orphans = nullptr;
+                }
+            }
+            if (l.retired == nullptr)
+                return;
+
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            std::vector<Node *> hazards;
+            for (record *r = g.records.load(std::memory_order_acquire); r != nullptr; r = r->next)
+            {
+                for (size_t i = 0; i < slots; ++i)
+                {
+                    Node *p = r->hp[i].load(std::memory_order_seq_cst);
+                    if (p != nullptr)
+                        hazards.push_back(p);
+                }
+            }
+            std::sort(hazards.begin(), hazards.end());
+
+            Node *keep = nullptr;
+            size_t kept = 0;
+            for (Node *n = l.retired; n != nullptr;)
+            {
+                Node *next = n->retire_next;
+                if (std::binary_search(hazards.begin(), hazards.end(), n))
+                {
+                    n->retire_next = keep;
+                    keep = n;
+                    ++kept;
+                }
+                else
+                {
+                    NodeAlloc::deallocate(n);
+                }
+                n = next;
+            }
+            l.retired = keep;
+            l.retired_count = kept;
+        }
+    };
+
+} // namespace cheamstl
+
+#endif // !CHEAMSTL_HAZARD_POINTER_H_
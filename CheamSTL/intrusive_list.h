@@ -0,0 +1,435 @@
+#ifndef CHEAMSTL_INTRUSIVE_LIST_H_
+#define CHEAMSTL_INTRUSIVE_LIST_H_
+
+/* intrusive_list：侵入式双向链表
+ * 普通的 list 会为每个元素额外分配一个 list_node<T>，而侵入式链表要求用户在自己的类型里
+ * 嵌入一个钩子（hook），链表直接把这些对象串起来：
+ * 1. 插入 / 删除不做任何内存分配，对象的生命周期完全由用户（对象池、arena 等）管理
+ * 2. 只要拿到对象的引用，就能 O(1) 找到它在链表中的位置并删除
+ * 3. 钩子可以选择 auto_unlink，对象析构时自动从所在的链表中摘除
+ * 钩子直接继承自 list_node_base<T>，与 list 共用同一套 prev/next 结构和 unlink() 语义 */
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "exceptdef.h"
+#include "iterator.h"
+#include "list.h"
+
+namespace cheamstl
+{
+
+    /* 钩子：prev/next 指向自身表示“未链接”，这正是 list_node_base::unlink() 的约定
+     * T 只用来区分不同类型的钩子，Tag 用于同一个类型同时挂在多个链表上的情况 */
+    template <class T, bool AutoUnlink = false, class Tag = void>
+    struct intrusive_list_hook : public list_node_base<T>
+    {
+        typedef typename list_node_base<T>::base_ptr base_ptr;
+
+        static constexpr bool auto_unlink = AutoUnlink;
+
+        intrusive_list_hook() noexcept { this->unlink(); }
+
+        /* 拷贝一个对象不应该把它的链接关系也拷贝过去，新对象总是处于未链接状态 */
+        intrusive_list_hook(const intrusive_list_hook &) noexcept { this->unlink(); }
+        intrusive_list_hook &operator=(const intrusive_list_hook &) noexcept { return *this; }
+
+        ~intrusive_list_hook()
+        {
+            if (AutoUnlink)
+                unlink_self();
+        }
+
+        bool is_linked() const noexcept
+        {
+            return this->next != static_cast<const list_node_base<T> *>(this);
+        }
+
+        /* 直接把自己从所在的链表中摘除（不经过链表对象），只有 auto_unlink 钩子可以安全使用，
+         * 因为这样的链表不缓存 size */
+        void unlink_self() noexcept
+        {
+            if (is_linked())
+            {
+                this->prev->next = this->next;
+                this->next->prev = this->prev;
+                this->unlink();
+            }
+        }
+    };
+
+    /* 钩子萃取：负责在“钩子指针”和“用户对象指针”之间互相转换 */
+
+    // 用户类型继承钩子的情况
+    template <class T, class Hook = intrusive_list_hook<T>>
+    struct base_hook_traits
+    {
+        typedef T value_type;
+        typedef Hook hook_type;
+        typedef typename Hook::base_ptr base_ptr;
+
+        static base_ptr to_node(T &value) noexcept
+        {
+            return static_cast<hook_type &>(value).self();
+        }
+
+        static T *to_value(base_ptr p) noexcept
+        {
+            return static_cast<T *>(static_cast<hook_type *>(p));
+        }
+    };
+
+    // 钩子作为用户类型的成员变量的情况
+    template <class T, class Hook, Hook T::*Member>
+    struct member_hook_traits
+    {
+        typedef T value_type;
+        typedef Hook hook_type;
+        typedef typename Hook::base_ptr base_ptr;
+
+        static base_ptr to_node(T &value) noexcept
+        {
+            return (value.*Member).self();
+        }
+
+        static T *to_value(base_ptr p) noexcept
+        {
+            char *hook = reinterpret_cast<char *>(static_cast<hook_type *>(p));
+            return reinterpret_cast<T *>(hook - member_offset());
+        }
+
+    private:
+        /* 成员钩子在对象中的偏移，编译器会把它折叠成常量 */
+        static ptrdiff_t member_offset() noexcept
+        {
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type buf;
+            const T *obj = reinterpret_cast<const T *>(&buf);
+            return reinterpret_cast<const char *>(&(obj->*Member)) - reinterpret_cast<const char *>(obj);
+        }
+    };
+
+    /* 迭代器：与 list_iterator 完全相同的模型，只是解引用时通过钩子萃取得到用户对象 */
+    template <class T, class Traits>
+    struct intrusive_list_iterator
+    {
+        typedef cheamstl::bidirectional_iterator_tag iterator_category;
+        typedef ptrdiff_t difference_type;
+        typedef typename std::remove_const<T>::type value_type;
+        typedef T *pointer;
+        typedef T &reference;
+        typedef typename Traits::base_ptr base_ptr;
+        typedef intrusive_list_iterator self;
+
+        base_ptr node_;
+
+        intrusive_list_iterator() = default;
+        intrusive_list_iterator(base_ptr x) : node_(x) {}
+        /* 普通迭代器可以隐式转换成常量迭代器 */
+        template <class U, typename std::enable_if<std::is_same<const U, T>::value &&
+                                                       !std::is_same<U, T>::value,
+                                                   int>::type = 0>
+        intrusive_list_iterator(const intrusive_list_iterator<U, Traits> &rhs) : node_(rhs.node_) {}
+
+        reference operator*() const { return *Traits::to_value(node_); }
+        pointer operator->() const { return &(operator*()); }
+
+        self &operator++()
+        {
+            node_ = node_->next;
+            return *this;
+        }
+        self operator++(int)
+        {
+            self tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        self &operator--()
+        {
+            node_ = node_->prev;
+            return *this;
+        }
+        self operator--(int)
+        {
+            self tmp = *this;
+            --*this;
+            return tmp;
+        }
+
+        bool operator==(const self &rhs) const { return node_ == rhs.node_; }
+        bool operator!=(const self &rhs) const { return node_ != rhs.node_; }
+    };
+
+    /* 模板参数 Traits 决定钩子的位置，默认是用户类型继承 intrusive_list_hook<T> */
+    template <class T, class Traits = base_hook_traits<T>>
+    class intrusive_list
+    {
+    public:
+        typedef T value_type;
+        typedef T *pointer;
+        typedef const T *const_pointer;
+        typedef T &reference;
+        typedef const T &const_reference;
+        typedef size_t size_type;
+        typedef ptrdiff_t difference_type;
+
+        typedef Traits value_traits;
+        typedef typename Traits::hook_type hook_type;
+        typedef typename Traits::base_ptr base_ptr;
+
+        typedef intrusive_list_iterator<T, Traits> iterator;
+        typedef intrusive_list_iterator<const T, Traits> const_iterator;
+        typedef cheamstl::reverse_iterator<iterator> reverse_iterator;
+        typedef cheamstl::reverse_iterator<const_iterator> const_reverse_iterator;
+
+        /* auto_unlink 的对象可能在链表不知情的情况下离开链表，此时无法维护 size_，size() 退化为 O(n) */
+        static constexpr bool constant_time_size = !hook_type::auto_unlink;
+
+    private:
+        /* 与 list 一样，哨兵直接放在对象内部 */
+        list_node_base<T> head_;
+        size_type size_;
+
+    public:
+        intrusive_list() noexcept : size_(0) { head_.unlink(); }
+
+        template <class Iter, typename std::enable_if<cheamstl::is_input_iterator<Iter>::value, int>::type = 0>
+        intrusive_list(Iter first, Iter last) : size_(0)
+        {
+            head_.unlink();
+            for (; first != last; ++first)
+                push_back(*first);
+        }
+
+        /* 链表不拥有元素，拷贝没有意义 */
+        intrusive_list(const intrusive_list &) = delete;
+        intrusive_list &operator=(const intrusive_list &) = delete;
+
+        intrusive_list(intrusive_list &&rhs) noexcept : size_(0)
+        {
+            head_.unlink();
+            take_nodes(rhs);
+        }
+
+        intrusive_list &operator=(intrusive_list &&rhs) noexcept
+        {
+            if (this != &rhs)
+            {
+                clear();
+                take_nodes(rhs);
+            }
+            return *this;
+        }
+
+        /* 析构只是把所有钩子恢复到未链接状态，不会销毁元素 */
+        ~intrusive_list() { clear(); }
+
+    public:
+        // 迭代器相关操作
+        iterator begin() noexcept { return node()->next; }
+        const_iterator begin() const noexcept { return node()->next; }
+        iterator end() noexcept { return node(); }
+        const_iterator end() const noexcept { return node(); }
+
+        reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+        const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+        reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+        const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+
+        const_iterator cbegin() const noexcept { return begin(); }
+        const_iterator cend() const noexcept { return end(); }
+
+        // 容量相关操作
+        bool empty() const noexcept { return head_.next == node(); }
+
+        size_type size() const noexcept
+        {
+            if (constant_time_size)
+                return size_;
+            size_type n = 0;
+            for (auto p = head_.next; p != node(); p = p->next)
+                ++n;
+            return n;
+        }
+
+        // 访问元素相关操作
+        reference front()
+        {
+            CHEAMSTL_DEBUG(!empty());
+            return *begin();
+        }
+        const_reference front() const
+        {
+            CHEAMSTL_DEBUG(!empty());
+            return *begin();
+        }
+        reference back()
+        {
+            CHEAMSTL_DEBUG(!empty());
+            return *(--end());
+        }
+        const_reference back() const
+        {
+            CHEAMSTL_DEBUG(!empty());
+            return *(--end());
+        }
+
+        /* 由对象引用直接得到迭代器，O(1) */
+        iterator iterator_to(reference value) noexcept { return Traits::to_node(value); }
+        const_iterator iterator_to(const_reference value) const noexcept
+        {
+            return Traits::to_node(const_cast<reference>(value));
+        }
+
+        // 插入 / 删除，都不涉及内存分配
+        iterator insert(const_iterator pos, reference value) noexcept
+        {
+            auto n = Traits::to_node(value);
+            CHEAMSTL_DEBUG(n->next == n);
+            link_nodes(pos.node_, n, n);
+            ++size_;
+            return iterator(n);
+        }
+
+        void push_front(reference value) noexcept { insert(begin(), value); }
+        void push_back(reference value) noexcept { insert(end(), value); }
+
+        void pop_front() noexcept
+        {
+            CHEAMSTL_DEBUG(!empty());
+            erase(begin());
+        }
+        void pop_back() noexcept
+        {
+            CHEAMSTL_DEBUG(!empty());
+            erase(--end());
+        }
+
+        iterator erase(const_iterator pos) noexcept
+        {
+            CHEAMSTL_DEBUG(pos != cend());
+            auto n = pos.node_;
+            auto next = n->next;
+            unlink_nodes(n, n);
+            n->unlink();
+            --size_;
+            return iterator(next);
+        }
+
+        iterator erase(const_iterator first, const_iterator last) noexcept
+        {
+            while (first != last)
+                first = erase(first);
+            return iterator(last.node_);
+        }
+
+        /* 只给出对象的引用即可删除 */
+        void erase(reference value) noexcept { erase(iterator_to(value)); }
+
+        void clear() noexcept
+        {
+            auto cur = head_.next;
+            while (cur != node())
+            {
+                auto next = cur->next;
+                cur->unlink();
+                cur = next;
+            }
+            head_.unlink();
+            size_ = 0;
+        }
+
+        void swap(intrusive_list &rhs) noexcept
+        {
+            if (this == &rhs)
+                return;
+            intrusive_list tmp(std::move(rhs));
+            rhs.take_nodes(*this);
+            take_nodes(tmp);
+        }
+
+        // 链表特有的操作
+        void splice(const_iterator pos, intrusive_list &other) noexcept
+        {
+            CHEAMSTL_DEBUG(this != &other);
+            if (!other.empty())
+            {
+                auto f = other.head_.next;
+                auto l = other.head_.prev;
+                other.unlink_nodes(f, l);
+                link_nodes(pos.node_, f, l);
+                size_ += other.size_;
+                other.size_ = 0;
+            }
+        }
+
+        void splice(const_iterator pos, intrusive_list &other, const_iterator it) noexcept
+        {
+            if (pos.node_ != it.node_ && pos.node_ != it.node_->next)
+            {
+                auto f = it.node_;
+                other.unlink_nodes(f, f);
+                link_nodes(pos.node_, f, f);
+                ++size_;
+                --other.size_;
+            }
+        }
+
+        void splice(const_iterator pos, intrusive_list &other, const_iterator first, const_iterator last) noexcept
+        {
+            if (first == last)
+                return;
+            size_type n = this == &other ? 0 : static_cast<size_type>(cheamstl::distance(first, last));
+            auto f = first.node_;
+            auto l = last.node_->prev;
+            other.unlink_nodes(f, l);
+            link_nodes(pos.node_, f, l);
+            size_ += n;
+            other.size_ -= n;
+        }
+
+    private:
+        base_ptr node() const noexcept
+        {
+            return const_cast<list_node_base<T> &>(head_).self();
+        }
+
+        void link_nodes(base_ptr pos, base_ptr first, base_ptr last) noexcept
+        {
+            pos->prev->next = first;
+            first->prev = pos->prev;
+            pos->prev = last;
+            last->next = pos;
+        }
+
+        void unlink_nodes(base_ptr first, base_ptr last) noexcept
+        {
+            first->prev->next = last->next;
+            last->next->prev = first->prev;
+        }
+
+        void take_nodes(intrusive_list &rhs) noexcept
+        {
+            if (rhs.empty())
+                return;
+            head_.next = rhs.head_.next;
+            head_.prev = rhs.head_.prev;
+            head_.next->prev = node();
+            head_.prev->next = node();
+            size_ = rhs.size_;
+            rhs.head_.unlink();
+            rhs.size_ = 0;
+        }
+    };
+
+    template <class T, class Traits>
+    void swap(intrusive_list<T, Traits> &lhs, intrusive_list<T, Traits> &rhs) noexcept
+    {
+        lhs.swap(rhs);
+    }
+
+} // namespace cheamstl
+
+#endif // !CHEAMSTL_INTRUSIVE_LIST_H_
@@ -0,0 +1,98 @@
+#ifndef CHEAMSTL_ITERATOR_H_
+#define CHEAMSTL_ITERATOR_H_
+
+/* 迭代器相关的工具：迭代器类型判断、distance、advance 和反向迭代器
+ * 迭代器标签直接沿用标准库的 tag，这样 cheamstl 的迭代器也能直接交给 <algorithm> 使用 */
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+
+namespace cheamstl
+{
+
+    typedef std::input_iterator_tag input_iterator_tag;
+    typedef std::output_iterator_tag output_iterator_tag;
+    typedef std::forward_iterator_tag forward_iterator_tag;
+    typedef std::bidirectional_iterator_tag bidirectional_iterator_tag;
+    typedef std::random_access_iterator_tag random_access_iterator_tag;
+
+    template <class Iterator>
+    struct iterator_traits : public std::iterator_traits<Iterator>
+    {
+    };
+
+    /* 判断一个类型是否定义了 iterator_category，用来区分迭代器和整数之类的普通类型
+     * 例如 list(5, 1) 不能匹配到 list(Iter first, Iter last) 上 */
+    template <class T>
+    struct has_iterator_cat
+    {
+    private:
+        struct two
+        {
+            char a;
+            char b;
+        };
+        template <class U>
+        static two test(...);
+        template <class U>
+        static char test(typename U::iterator_category * = 0);
+
+    public:
+        static const bool value = sizeof(test<T>(0)) == sizeof(char);
+    };
+
+    template <class Iter, bool = has_iterator_cat<std::iterator_traits<Iter>>::value>
+    struct is_input_iterator : public std::false_type
+    {
+    };
+
+    template <class Iter>
+    struct is_input_iterator<Iter, true>
+        : public std::integral_constant<bool, std::is_convertible<typename std::iterator_traits<Iter>::iterator_category,
+                                                                  input_iterator_tag>::value>
+    {
+    };
+
+    template <class Iter, bool = has_iterator_cat<std::iterator_traits<Iter>>::value>
+    struct is_forward_iterator : public std::false_type
+    {
+    };
+
+    template <class Iter>
+    struct is_forward_iterator<Iter, true>
+        : public std::integral_constant<bool, std::is_convertible<typename std::iterator_traits<Iter>::iterator_category,
+                                                                  forward_iterator_tag>::value>
+    {
+    };
+
+    template <class Iter, bool = has_iterator_cat<std::iterator_traits<Iter>>::value>
+    struct is_random_access_iterator : public std::false_type
+    {
+    };
+
+    template <class Iter>
+    struct is_random_access_iterator<Iter, true>
+        : public std::integral_constant<bool, std::is_convertible<typename std::iterator_traits<Iter>::iterator_category,
+                                                                  random_access_iterator_tag>::value>
+    {
+    };
+
+    template <class InputIter>
+    typename iterator_traits<InputIter>::difference_type distance(InputIter first, InputIter last)
+    {
+        return std::distance(first, last);
+    }
+
+    template <class InputIter, class Distance>
+    void advance(InputIter &i, Distance n)
+    {
+        std::advance(i, n);
+    }
+
+    template <class Iterator>
+    using reverse_iterator = std::reverse_iterator<Iterator>;
+
+} // namespace cheamstl
+
+#endif // !CHEAMSTL_ITERATOR_H_
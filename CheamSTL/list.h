@@ -1,15 +1,32 @@
 #ifndef CHEAMSTL_LIST_H_
 #define CHEAMSTL_LIST_H_
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "allocator.h"
+#include "exceptdef.h"
+#include "execution.h"
+#include "iterator.h"
+#include "thread_pool.h"
+
 namespace cheamstl
 {
 
     /* 前置声明， 告诉编译器在后面会有一个模板结构体 list_node_base和 list_node
      * 的定义，但是暂时不需要知道其具体细节, 因为 list_node_base
      * list_node与node_traits互相使用，需要有一个入口*/
-    template <class T>
+    template <class T, class VoidPtr = void *>
     struct list_node_base;
-    template <class T>
+    template <class T, class VoidPtr = void *>
     struct list_node;
 
     /* 使用模板，是因为需要用到一个代表所有类的class T或typename T,
@@ -20,12 +37,14 @@ namespace cheamstl
     node_traits，可以轻松地将 list_node_base 和 list_node
     的指针类型统一起来，而无需关心具体的节点类型。 就是类型萃取，提高通用性
     base_ptr 和 node_ptr都是指针类型别名,因为这里只需要萃取出指针，所以只是类型别名
+    VoidPtr 是分配器 pointer 对应的 void 指针：普通分配器就是 void*，得到的是普通指针；
+    mapped_allocator 则是 offset_ptr<void>，节点之间用 offset_ptr 相连，链表可以放进共享内存或映射文件
     */
-    template <class T>
+    template <class T, class VoidPtr = void *>
     struct node_traits
     {
-        typedef list_node_base<T> *base_ptr;
-        typedef list_node<T> *node_ptr;
+        typedef typename rebind_pointer<VoidPtr, list_node_base<T, VoidPtr>>::type base_ptr;
+        typedef typename rebind_pointer<VoidPtr, list_node<T, VoidPtr>>::type node_ptr;
     };
 
     /* 在 C++ 中，使用 typedef 定义类型别名时，不需要使用 typename
@@ -38,12 +57,12 @@ namespace cheamstl
     判断是否要使用嵌套类型取决于是否需要在某个类或结构体内部直接使用另一个类或结构体中定义的类型。如果需要在内部使用，那么可以使用嵌套类型来简化代码。如果只是需要定义一些类型别名，而不需要在类或结构体内部使用另一个类或结构体中定义的类型，那么可以使用类型别名来实现。使用哪种方式更适合取决于具体的情况和编码风格。。
     */
     /* 定义抽象节点结构 */
-    template <class T>
+    template <class T, class VoidPtr>
     struct list_node_base
     {
         /* node_traits<T> 这里的T是为了传递模板参数 */
-        typedef typename node_traits<T>::base_ptr base_ptr;
-        typedef typename node_traits<T>::node_ptr node_ptr;
+        typedef typename node_traits<T, VoidPtr>::base_ptr base_ptr;
+        typedef typename node_traits<T, VoidPtr>::node_ptr node_ptr;
 
         /* 这里只需要用基类节点指针 */
         base_ptr prev;
@@ -90,7 +109,7 @@ namespace cheamstl
 
         /*  获取当前节点自身的指针，即将当前节点转换为
          * base_ptr，方便在链表操作中使用。 */
-        base_ptr self() { return static_cast<base_ptr>(&*this) }
+        base_ptr self() { return static_cast<base_ptr>(&*this); }
     };
 
     /* 继承关系
@@ -110,16 +129,16 @@ namespace cheamstl
     继承用于实现实现细节的隐藏。
     */
     /* 定义具体节点结构 */
-    template <class T>
-    struct list_node : public list_node_base<T>
+    template <class T, class VoidPtr>
+    struct list_node : public list_node_base<T, VoidPtr>
     {
         /* 派生类 list_node 重新定义 base_ptr 和 node_ptr
         类型别名是为了更方便地使用它们， 并且与基类 list_node_base
         中的类型别名保持一致。虽然你可以直接使用 list_node_base::base_ptr 和
         list_node_base::node_ptr， 但是使用派生类 list_node
         中重新定义的类型别名可以使代码更加清晰和易读。 */
-        typedef typename node_traits<T>::base_ptr base_ptr;
-        typedef typename node_traits<T>::node_ptr node_ptr;
+        typedef typename node_traits<T, VoidPtr>::base_ptr base_ptr;
+        typedef typename node_traits<T, VoidPtr>::node_ptr node_ptr;
 
         T value; // 数据域
 
@@ -142,23 +161,25 @@ namespace cheamstl
         综上所述，通过同时定义两个构造函数，并分别使用常量引用和右值引用作为参数，可以支持更广泛的输入类型，并在处理右值时提供更高的效率。这种技巧被称为
         "完美转发"，可以在不损失性能的情况下，更好地处理不同类型的输入参数。 */
         list_node(const T &v) : value(v) {}
-        list_node(T &&v) : value(v) {}
+        list_node(T &&v) : value(std::move(v)) {}
 
         /* &*self() 表示首先通过 self() 获取指向当前对象的指针，然后用 *
          * 解引用该指针，得到当前对象本身。最后，再通过 & 获取当前对象本身的地址。 */
         base_ptr as_base() { return static_cast<base_ptr>(&*self()); }
-        node_ptr self() { return static_cast<node_ptr>(&*self()); }
+        node_ptr self() { return static_cast<node_ptr>(&*this); }
     };
 
-    template <class T>
+    template <class T, class VoidPtr = void *>
     struct list_iterator
     {
         /* 规定迭代器内可能用到的所有关于实例的变量类型，便于阅读 */
+        typedef cheamstl::bidirectional_iterator_tag iterator_category;
+        typedef ptrdiff_t difference_type;
         typedef T value_type;
         typedef T *pointer;
         typedef T &reference;
-        typedef typename node_traits<T>::base_ptr base_ptr;
-        typedef typename node_traits<T>::node_ptr node_ptr;
+        typedef typename node_traits<T, VoidPtr>::base_ptr base_ptr;
+        typedef typename node_traits<T, VoidPtr>::node_ptr node_ptr;
         typedef list_iterator self;
 
         base_ptr node_;
@@ -168,6 +189,7 @@ namespace cheamstl
         list_iterator(base_ptr x) : node_(x) {}
         list_iterator(node_ptr x) : node_(x->as_base()) {}
         list_iterator(const list_iterator &rhs) : node_(rhs.node_) {}
+        list_iterator &operator=(const list_iterator &rhs) = default;
 
         /* 重载运算符 */
         /* 在这段代码中，reference operator*() const 是一个重载了解引用操作符 *
@@ -204,13 +226,13 @@ namespace cheamstl
 
         self &operator--()
         {
-            /////////////////////////////
-            node_ = node_->next;
+            node_ = node_->prev;
             return *this;
         }
         self operator--(int)
         {
-            self tmp = *this --*this;
+            self tmp = *this;
+            --*this;
             return tmp;
         }
 
@@ -219,25 +241,30 @@ namespace cheamstl
         bool operator!=(const self &rhs) const { return node_ != rhs.node_; }
     };
 
-    template <class T>
+    template <class T, class VoidPtr = void *>
     struct list_const_iterator
     {
         /* 规定迭代器内可能用到的所有关于实例的变量类型，便于阅读 */
+        typedef cheamstl::bidirectional_iterator_tag iterator_category;
+        typedef ptrdiff_t difference_type;
         typedef T value_type;
-        typedef T *pointer;
-        typedef T &reference;
-        typedef typename node_traits<T>::base_ptr base_ptr;
-        typedef typename node_traits<T>::node_ptr node_ptr;
-        typedef list_iterator self;
+        typedef const T *pointer;
+        typedef const T &reference;
+        typedef typename node_traits<T, VoidPtr>::base_ptr base_ptr;
+        typedef typename node_traits<T, VoidPtr>::node_ptr node_ptr;
+        typedef list_const_iterator self;
 
         base_ptr node_;
 
         /* 构造函数 */
-        list_iterator() = default;
-        list_iterator(base_ptr x) : node_(x) {}
-        list_iterator(node_ptr x) : node_(x->as_base()) {}
+        list_const_iterator() = default;
+        list_const_iterator(base_ptr x) : node_(x) {}
+        list_const_iterator(node_ptr x) : node_(x->as_base()) {}
+        /* 普通迭代器可以隐式转换成常量迭代器，反之不行 */
+        list_const_iterator(const list_iterator<T, VoidPtr> &rhs) : node_(rhs.node_) {}
 
         list_const_iterator(const list_const_iterator &rhs) : node_(rhs.node_) {}
+        list_const_iterator &operator=(const list_const_iterator &rhs) = default;
 
         /* 重载运算符 */
         /* 在这段代码中，reference operator*() const 是一个重载了解引用操作符 *
@@ -274,13 +301,13 @@ namespace cheamstl
 
         self &operator--()
         {
-            /////////////////////////////
-            node_ = node_->next;
+            node_ = node_->prev;
             return *this;
         }
         self operator--(int)
         {
-            self tmp = *this --*this;
+            self tmp = *this;
+            --*this;
             return tmp;
         }
 
@@ -289,15 +316,160 @@ namespace cheamstl
         bool operator!=(const self &rhs) const { return node_ != rhs.node_; }
     };
 
-    template <class T>
-    class list
+    template <class T, class Alloc>
+    class list;
+
+    template <class T, size_t N, class Alloc>
+    class small_list;
+
+    /* 软件预取：提示 CPU 提前把 p 所在的缓存行读进来，不支持的编译器上什么也不做 */
+    inline void prefetch_read(const void *p) noexcept
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(p, 0, 3);
+#else
+        (void)p;
+#endif
+    }
+
+    /* 分配器是否提供 allocate_fresh_chain（一次从新内存中连续切出 n 块），list::compact 用它来重新排布节点 */
+    template <class Alloc, class = void>
+    struct has_fresh_chain : std::false_type
+    {
+    };
+
+    template <class Alloc>
+    struct has_fresh_chain<Alloc, decltype((void)Alloc::allocate_fresh_chain(0))> : std::true_type
+    {
+    };
+
+    /* 节点句柄：持有一个已经从链表中摘下的节点（连同其中的元素）
+     * 1. list::extract 返回它，list::insert(pos, node_type&&) 把节点重新接回，整个过程不分配内存，也不移动元素
+     * 2. 节点来自 NodeAlloc，所以只要节点分配器相同，不同的 list 对象之间就可以直接互相转移节点
+     * 3. 只能移动，不能复制；句柄析构时如果仍持有节点，就销毁元素并归还节点内存 */
+    template <class T, class NodeAlloc>
+    class list_node_handle : private alloc_holder<NodeAlloc>
+    {
+    public:
+        typedef T value_type;
+        typedef NodeAlloc allocator_type;
+
+    private:
+        typedef typename NodeAlloc::pointer node_ptr;
+        typedef alloc_holder<NodeAlloc> holder_type;
+
+        node_ptr node_;
+
+        template <class, class>
+        friend class list;
+
+        /* 有状态的分配器随节点一起保存，句柄析构时才能把节点还给正确的地方 */
+        list_node_handle(node_ptr p, const NodeAlloc &a) : holder_type(a), node_(p) {}
+
+        /* 交出节点的所有权，句柄随后为空 */
+        node_ptr release() noexcept
+        {
+            node_ptr p = node_;
+            node_ = nullptr;
+            return p;
+        }
+
+    public:
+        list_node_handle() noexcept : node_(nullptr) {}
+
+        list_node_handle(list_node_handle &&rhs) noexcept
+            : holder_type(static_cast<const holder_type &>(rhs)), node_(rhs.release())
+        {
+        }
+
+        list_node_handle &operator=(list_node_handle &&rhs) noexcept
+        {
+            if (this != &rhs)
+            {
+                reset();
+                holder_type::operator=(static_cast<const holder_type &>(rhs));
+                node_ = rhs.release();
+            }
+            return *this;
+        }
+
+        list_node_handle(const list_node_handle &) = delete;
+        list_node_handle &operator=(const list_node_handle &) = delete;
+
+        ~list_node_handle() { reset(); }
+
+        bool empty() const noexcept { return node_ == nullptr; }
+        explicit operator bool() const noexcept { return node_ != nullptr; }
+
+        value_type &value() const
+        {
+            CHEAMSTL_DEBUG(!empty());
+            return node_->value;
+        }
+
+        void swap(list_node_handle &rhs) noexcept
+        {
+            node_ptr tmp = node_;
+            node_ = rhs.node_;
+            rhs.node_ = tmp;
+            this->swap_alloc(rhs);
+        }
+
+    private:
+        void reset() noexcept
+        {
+            if (node_ == nullptr)
+                return;
+            cheamstl::allocator<T>::destroy(&node_->value);
+            this->alloc().deallocate(node_);
+            node_ = nullptr;
+        }
+    };
+
+    template <class T, class NodeAlloc>
+    void swap(list_node_handle<T, NodeAlloc> &lhs, list_node_handle<T, NodeAlloc> &rhs) noexcept
+    {
+        lhs.swap(rhs);
+    }
+
+    /* list 节点的分配器：Alloc rebind 到 list_node，节点之间的指针与 Alloc::pointer 同类（普通指针或 offset_ptr） */
+    template <class T, class Alloc>
+    struct list_node_allocator
+    {
+        typedef typename rebind_pointer<typename Alloc::pointer, void>::type void_pointer;
+        typedef typename Alloc::template rebind<list_node<T, void_pointer>>::other type;
+    };
+
+    /* list::save / load 的文件头，其后紧跟 count 个元素的原始字节，从 payload_offset 开始连续存放。
+     * 元素大小、对齐或字节序与当前程序不一致的文件拒绝读入 */
+    struct list_snapshot_header
+    {
+        static constexpr uint32_t magic_value = 0x54534c43; // "CLST"
+        static constexpr uint32_t current_version = 1;
+        static constexpr uint32_t byte_order_mark = 0x01020304;
+        static constexpr uint32_t payload_offset = 64;
+
+        uint32_t magic;
+        uint32_t version;
+        uint32_t byte_order;
+        uint32_t elem_size;
+        uint32_t elem_align;
+        uint32_t reserved;
+        uint64_t count;
+    };
+
+    /* Alloc 决定节点从哪里分配，通过 rebind 换成 list_node<T> 的分配器。
+     * 节点数量多、生命周期短，默认使用固定大小的 slab 节点池，分配/释放都只是一次空闲链表的 pop/push。
+     * 分配器对象保存在私有基类 alloc_holder 中：无状态的分配器不占空间，有状态的（pmr）保存一份副本 */
+    template <class T, class Alloc = cheamstl::pool_allocator<T>>
+    class list : private alloc_holder<typename list_node_allocator<T, Alloc>::type>
     {
     public:
         // 需要用到的类型名
-        typedef cheamstl::allocator<T> allocator_type;
-        typedef cheamstl::allocator<T> data_allocator;
-        typedef cheamstl::allocator<list_node_base<T>> base_allocator;
-        typedef cheamstl::allocator<list_node<T>> node_allocator;
+        typedef Alloc allocator_type;
+        typedef Alloc data_allocator;
+        typedef typename list_node_allocator<T, Alloc>::void_pointer void_pointer;
+        typedef typename list_node_allocator<T, Alloc>::type node_allocator;
 
         typedef typename allocator_type::value_type value_type;
         typedef typename allocator_type::pointer pointer;
@@ -305,27 +477,98 @@ namespace cheamstl
         typedef typename allocator_type::reference reference;
         typedef typename allocator_type::const_reference const_reference;
         typedef typename allocator_type::size_type size_type;
-        typedef typename allocator_type::difference_type defference_type;
+        typedef typename allocator_type::difference_type difference_type;
 
-        typedef list_iterator<T> iterator;
-        typedef list_const_iterator<T> const_iterator;
+        typedef list_iterator<T, void_pointer> iterator;
+        typedef list_const_iterator<T, void_pointer> const_iterator;
         typedef cheamstl::reverse_iterator<iterator> reverse_iterator;
         typedef cheamstl::reverse_iterator<const_iterator> const_reverse_iterator;
 
-        typedef typename node_traits<T>::base_ptr base_ptr;
-        typedef typename node_traits<T>::node_ptr node_ptr;
+        typedef typename node_traits<T, void_pointer>::base_ptr base_ptr;
+        typedef typename node_traits<T, void_pointer>::node_ptr node_ptr;
 
-        allocator_type get_allocator()
+        typedef list_node_handle<T, node_allocator> node_type;
+
+        allocator_type get_allocator() const
         {
-            return node_allocator();
+            return this->template alloc_as<allocator_type>();
         }
 
     private:
-        base_ptr node_;
+        typedef alloc_holder<node_allocator> holder_type;
+
+        /* 哨兵节点直接放在 list 对象内部，而不是再向分配器申请：
+         * 1. 默认构造、空链表的析构都不需要任何内存分配
+         * 2. 哨兵永远存在，被移动过的 list 依然是一个合法的空链表，可以继续调用 empty()/begin() 等
+         * 代价是哨兵的地址随 list 对象变化，所以移动/交换时要把首尾节点重新指向新的哨兵 */
+        list_node_base<T, void_pointer> head_;
         size_type size_;
 
+        /* 可选的位置索引（见 enable_index），默认不存在，不存在时不做任何维护
+         * nodes[i] 是第 i * step 个元素，但只有前 valid 个检查点可信：修改链表时，修改位置之后的检查点失效，之前的保持不变。
+         * slots 是检查点节点地址 -> 下标的开放定址表（线性探测），index_of 每走一步只需一次乘法和很少的比较 */
+        struct position_index
+        {
+            struct slot
+            {
+                const void *key;
+                size_type at;
+            };
+
+            std::vector<base_ptr> nodes;
+            std::vector<slot> slots; // 容量为 2 的幂，至少是检查点个数的四倍，未命中时探测很快结束
+            unsigned shift = 62;     // 散列值取高位时右移的位数
+            size_type step = 1;
+            size_type valid = 0;
+
+            static size_type none() noexcept { return static_cast<size_type>(-1); }
+
+            size_type hash(const void *p) const noexcept
+            {
+                return static_cast<size_type>((static_cast<uint64_t>(reinterpret_cast<uintptr_t>(p)) *
+                                               0x9e3779b97f4a7c15ULL) >>
+                                              shift);
+            }
+
+            /* 按 nodes 重建散列表 */
+            void rehash()
+            {
+                size_type cap = 4;
+                unsigned bits = 2;
+                for (; cap < 4 * nodes.size(); cap *= 2)
+                    ++bits;
+                slots.assign(cap, slot{nullptr, 0});
+                shift = 64 - bits;
+                for (size_type i = 0; i < nodes.size(); ++i)
+                {
+                    const void *key = &*nodes[i];
+                    size_type h = hash(key);
+                    while (slots[h].key != nullptr)
+                        h = (h + 1) & (cap - 1);
+                    slots[h] = slot{key, i};
+                }
+            }
+
+            /* p 是第几个检查点，不是检查点时返回 none()；返回值不小于 valid 时对应的检查点已经失效 */
+            size_type find(const void *p) const noexcept
+            {
+                if (slots.empty())
+                    return none();
+                for (size_type h = hash(p);; h = (h + 1) & (slots.size() - 1))
+                {
+                    if (slots[h].key == p)
+                        return slots[h].at;
+                    if (slots[h].key == nullptr)
+                        return none();
+                }
+            }
+        };
+        position_index *index_ = nullptr;
+
     public:
-        list() { fill_init(0, value_type()); }
+        list() noexcept : size_(0) { head_.unlink(); }
+
+        explicit list(const allocator_type &a) noexcept : holder_type(a), size_(0) { head_.unlink(); }
 
         explicit list(size_type n)
         {
@@ -337,20 +580,38 @@ namespace cheamstl
             fill_init(n, value);
         }
 
+        list(size_type n, const T &value, const allocator_type &a) : holder_type(a)
+        {
+            fill_init(n, value);
+        }
+
         template <class Iter, typename std::enable_if<cheamstl::is_input_iterator<Iter>::value, int>::type = 0>
         list(Iter first, Iter last)
         {
             copy_init(first, last);
         }
 
-        list(std::initalizer_list<T> ilist)
+        template <class Iter, typename std::enable_if<cheamstl::is_input_iterator<Iter>::value, int>::type = 0>
+        list(Iter first, Iter last, const allocator_type &a) : holder_type(a)
+        {
+            copy_init(first, last);
+        }
+
+        list(std::initializer_list<T> ilist)
+        {
+            copy_init(ilist.begin(), ilist.end());
+        }
+
+        list(std::initializer_list<T> ilist, const allocator_type &a) : holder_type(a)
         {
             copy_init(ilist.begin(), ilist.end());
         }
 
-        list(const list &rhs)
+        /* 元素个数直接取 rhs.size_，不需要再数一遍 */
+        list(const list &rhs) : holder_type(), size_(0)
         {
-            copy_init(rhs.cbegin(), rhs.cend());
+            head_.unlink();
+            copy_init_n(rhs.cbegin(), rhs.size_);
         }
 
         /* 使用 && 表示右值引用的参数是为了支持移动语义。右值引用是C++11引入的特性，允许我们有效地将资源的所有权从一个对象转移到另一个对象，而不需要进行深拷贝操作，从而提高了性能和资源的利用率。在构造函数中使用右值引用参数，通常用于实现移动构造函数和移动赋值运算符。
@@ -364,10 +625,11 @@ namespace cheamstl
 资源管理： 右值引用还有助于更有效地管理资源，如内存、文件句柄等。当一个对象被移动时，通常需要将原对象清空，这有助于确保资源的正确释放或转移。
 
 总之，使用右值引用参数允许你实现移动语义，以更高效地管理资源和提高性能。在合适的情况下，使用移动构造函数和右值引用可以避免不必要的数据复制，同时确保资源的正确管理 */
-        list(list &&rhs) noexcept : node_(rhs.node_), size_(rhs.size_)
+        /* 复制构造的新链表使用默认的分配器（与 std::pmr 相同），移动构造则连同分配器一起接管 */
+        list(list &&rhs) noexcept : holder_type(static_cast<const holder_type &>(rhs)), size_(0)
         {
-            rhs.node_ = nullptr;
-            rhs.size_ = 0;
+            head_.unlink();
+            take_nodes(rhs);
         }
 
         list &operator=(const list &rhs)
@@ -379,29 +641,36 @@ namespace cheamstl
             return *this;
         }
 
-        list &operator=(list &&rhs) noexcept
+        /* 分配器相同时直接接管节点；不同时（不同的内存资源）只能逐个移动元素 */
+        list &operator=(list &&rhs) noexcept(!holder_type::stateful)
         {
-            clear();
-            splice(end(), rhs);
+            if (this != &rhs)
+            {
+                if (this->same_alloc(rhs))
+                {
+                    clear();
+                    take_nodes(rhs);
+                }
+                else
+                {
+                    assign(std::make_move_iterator(rhs.begin()), std::make_move_iterator(rhs.end()));
+                    rhs.clear();
+                }
+            }
             return *this;
         }
 
-        list &operator=(std::initializer_list<T>, ilist)
+        list &operator=(std::initializer_list<T> ilist)
         {
-            list tmp(ilist.begin(), ilist.end());
+            list tmp(ilist.begin(), ilist.end(), get_allocator());
             swap(tmp);
             return *this;
         }
 
         ~list()
         {
-            if (node_)
-            {
-                clear();
-                base_allocator::deallocate(node_);
-                node_ = nullptr;
-                size_ = 0;
-            }
+            clear();
+            delete index_;
         }
 
     public:
@@ -411,22 +680,22 @@ namespace cheamstl
         如果只是希望遍历链表而不修改元素，可以使用常量迭代器，这可以提高代码的安全性和可读性 */
         iterator begin() noexcept
         {
-            return node_->next;
+            return node()->next;
         }
 
-        const_iterator begin() noexcept
+        const_iterator begin() const noexcept
         {
-            return node_->next;
+            return node()->next;
         }
 
         iterator end() noexcept
         {
-            return node_;
+            return node();
         }
 
-        const_iterator end() noexcept
+        const_iterator end() const noexcept
         {
-            return node_;
+            return node();
         }
 
         reverse_iterator rbegin() noexcept
@@ -434,9 +703,9 @@ namespace cheamstl
             return reverse_iterator(end());
         }
 
-        const_reverse_iterator rbegin() noexcept
+        const_reverse_iterator rbegin() const noexcept
         {
-            return reverse_iterator(end());
+            return const_reverse_iterator(end());
         }
 
         reverse_iterator rend() noexcept
@@ -444,9 +713,9 @@ namespace cheamstl
             return reverse_iterator(begin());
         }
 
-        const_reverse_iterator rend() noexcept
+        const_reverse_iterator rend() const noexcept
         {
-            return reverse_iterator(begin());
+            return const_reverse_iterator(begin());
         }
 
         /* const_iterator cbegin() const noexcept: 这是成员函数 cbegin() 的声明。它返回一个 const_iterator，表示返回的迭代器是常量的，
@@ -474,7 +743,7 @@ namespace cheamstl
         /* 容量相关操作 */
         bool empty() const noexcept
         {
-            return node_->next == node_;
+            return head_.next == node();
         }
 
         size_type size() const noexcept
@@ -482,9 +751,11 @@ namespace cheamstl
             return size_;
         }
 
-        size_type max_size() const noexcept {
+        size_type max_size() const noexcept
+        {
             // static_cast<size_type>(-1) 执行了显式类型转换，将 -1 转换为 size_type。这个操作将 -1 转换为 size_type 的最大可能值，因为 size_type 是无符号整数类型，不允许负数值。
-            return static_cast<size_type>(-1)}
+            return static_cast<size_type>(-1);
+        }
 
         /* 访问元素相关操作 */
         reference front()
@@ -493,68 +764,1492 @@ namespace cheamstl
             return *begin();
         }
 
+        const_reference front() const
+        {
+            CHEAMSTL_DEBUG(!empty());
+            return *begin();
+        }
+
+        reference back()
+        {
+            CHEAMSTL_DEBUG(!empty());
+            return *(--end());
+        }
+
+        const_reference back() const
+        {
+            CHEAMSTL_DEBUG(!empty());
+            return *(--end());
+        }
+
+        /* 调整容器相关操作 */
+        void assign(size_type n, const value_type &value)
+        {
+            fill_assign(n, value);
+        }
+
+        template <class Iter, typename std::enable_if<cheamstl::is_input_iterator<Iter>::value, int>::type = 0>
+        void assign(Iter first, Iter last)
+        {
+            copy_assign(first, last);
+        }
+
+        void assign(std::initializer_list<T> ilist)
+        {
+            copy_assign(ilist.begin(), ilist.end());
+        }
+
+        /* emplace 系列：参数一路完美转发到 data_allocator::construct，元素直接在节点内构造，
+         * 不会先构造一个临时的 T 再复制/移动进去 */
+        template <class... Args>
+        void emplace_front(Args &&...args)
+        {
+            THROW_LENGTH_ERROR_IF(size_ > max_size() - 1, "list<T>'s size too big");
+            auto link_node = create_node(std::forward<Args>(args)...);
+            link_nodes_at_front(link_node->as_base(), link_node->as_base());
+            ++size_;
+        }
+
+        template <class... Args>
+        void emplace_back(Args &&...args)
+        {
+            THROW_LENGTH_ERROR_IF(size_ > max_size() - 1, "list<T>'s size too big");
+            auto link_node = create_node(std::forward<Args>(args)...);
+            link_nodes_at_back(link_node->as_base(), link_node->as_base());
+            ++size_;
+        }
+
+        template <class... Args>
+        iterator emplace(const_iterator pos, Args &&...args)
+        {
+            THROW_LENGTH_ERROR_IF(size_ > max_size() - 1, "list<T>'s size too big");
+            auto link_node = create_node(std::forward<Args>(args)...);
+            ++size_;
+            return link_iter_node(pos, link_node->as_base());
+        }
+
+        iterator insert(const_iterator pos, const value_type &value)
+        {
+            return emplace(pos, value);
+        }
+
+        iterator insert(const_iterator pos, value_type &&value)
+        {
+            return emplace(pos, std::move(value));
+        }
+
+        iterator insert(const_iterator pos, size_type n, const value_type &value)
+        {
+            THROW_LENGTH_ERROR_IF(size_ > max_size() - n, "list<T>'s size too big");
+            return fill_insert(pos, n, value);
+        }
+
+        /* 元素通过 *first 构造，传入 std::move_iterator 时 *first 是右值，元素会被移动而不是复制 */
+        template <class Iter, typename std::enable_if<cheamstl::is_input_iterator<Iter>::value, int>::type = 0>
+        iterator insert(const_iterator pos, Iter first, Iter last)
+        {
+            return copy_insert(pos, first, last, typename iterator_traits<Iter>::iterator_category());
+        }
+
+        iterator insert(const_iterator pos, std::initializer_list<T> ilist)
+        {
+            return insert(pos, ilist.begin(), ilist.end());
+        }
+
+        void push_front(const value_type &value)
+        {
+            emplace_front(value);
+        }
+
+        void push_front(value_type &&value)
+        {
+            emplace_front(std::move(value));
+        }
+
+        void push_back(const value_type &value)
+        {
+            emplace_back(value);
+        }
+
+        void push_back(value_type &&value)
+        {
+            emplace_back(std::move(value));
+        }
+
+        void pop_front() noexcept
+        {
+            CHEAMSTL_DEBUG(!empty());
+            auto n = head_.next;
+            unlink_nodes(n, n);
+            destroy_node(n->as_node());
+            --size_;
+        }
+
+        void pop_back() noexcept
+        {
+            CHEAMSTL_DEBUG(!empty());
+            auto n = head_.prev;
+            unlink_nodes(n, n);
+            destroy_node(n->as_node());
+            --size_;
+        }
+
+        iterator erase(const_iterator pos);
+        iterator erase(const_iterator first, const_iterator last);
+
+        /* 摘下 pos 处的节点并交给节点句柄，元素既不析构也不移动 */
+        node_type extract(const_iterator pos) noexcept
+        {
+            CHEAMSTL_DEBUG(pos != cend());
+            base_ptr n = pos.node_;
+            unlink_nodes(n, n);
+            --size_;
+            return node_type(n->as_node(), this->alloc());
+        }
+
+        /* 把节点句柄持有的节点接到 pos 之前，返回指向它的迭代器；句柄为空时什么也不做，返回 pos */
+        iterator insert(const_iterator pos, node_type &&nh)
+        {
+            if (nh.empty())
+                return iterator(pos.node_);
+            CHEAMSTL_DEBUG(this->same_alloc(nh));
+            THROW_LENGTH_ERROR_IF(size_ > max_size() - 1, "list<T>'s size too big");
+            node_ptr p = nh.release();
+            ++size_;
+            return link_iter_node(pos, p->as_base());
+        }
+
+        void clear() noexcept;
+
+        /* O(1) 交换：只交换两个哨兵所连接的节点链，不会分配内存，也不会移动任何元素。两个链表的分配器必须相同 */
+        void swap(list &rhs) noexcept
+        {
+            if (this == &rhs)
+                return;
+            CHEAMSTL_DEBUG(this->same_alloc(rhs));
+            list tmp(std::move(rhs));
+            rhs.take_nodes(*this);
+            take_nodes(tmp);
+        }
+
+        /* 链表特有的操作 */
+        void splice(const_iterator pos, list &other);
+        void splice(const_iterator pos, list &other, const_iterator it);
+        void splice(const_iterator pos, list &other, const_iterator first, const_iterator last);
+
+        /* 以下操作都只改动节点的 prev/next，不会构造、复制或移动任何元素，也不申请内存 */
+        size_type unique() { return unique(std::equal_to<T>()); }
+        template <class BinaryPredicate>
+        size_type unique(BinaryPredicate pred);
+
+        void merge(list &other) { merge(other, std::less<T>()); }
+        void merge(list &&other) { merge(other, std::less<T>()); }
+        template <class Compare>
+        void merge(list &other, Compare comp);
+        template <class Compare>
+        void merge(list &&other, Compare comp) { merge(other, comp); }
+
+        void sort() { sort(std::less<T>()); }
+        template <class Compared>
+        void sort(Compared comp);
+
+        /* 并行排序：把链表切成 threads 段，交给 work_stealing_pool 分别排序，再两两并行归并
+         * threads 为 0 时使用线程池的线程数；元素较少时直接退化为串行版本 */
+        void sort(execution::parallel_policy policy, size_type threads = 0) { sort(policy, std::less<T>(), threads); }
+        template <class Compared, typename std::enable_if<!std::is_integral<Compared>::value, int>::type = 0>
+        void sort(execution::parallel_policy, Compared comp, size_type threads = 0);
+
+        /* 碎片整理：把全部元素按链表顺序移动到一段新的、地址连续递增的节点中，再释放旧节点。
+         * 长时间随机插入/删除之后节点散落在堆上，遍历会受限于内存延迟，整理后遍历速度与新建的链表相当。
+         * 迭代器失效规则：所有元素的地址都会改变，指向元素的迭代器、指针、引用全部失效，只有 end() 保持有效；
+         * 已经 extract 出去的节点句柄不受影响。
+         * 元素的移动构造不会抛出异常时使用移动，否则使用复制；复制失败时链表保持原样（强异常安全） */
+        void compact();
+
+        /* 二进制快照，只支持可平凡复制的 T：
+         * save 把全部元素按链表顺序写成一整块（前面是带版本号的文件头）；
+         * load 把文件映射进来（不支持 mmap 的平台整块读入），一次申请全部节点，一趟复制元素并连接。
+         * 出错时抛出 std::runtime_error，load 失败时链表保持原样 */
+        void save(const char *path) const;
+        void load(const char *path);
+
+        /* 带软件预取的遍历：访问当前节点的同时预取 prefetch_distance 个节点之后的节点，
+         * 让对元素的处理与沿 next 指针的访存重叠 */
+        static constexpr size_type prefetch_distance = 4;
+
+        template <class UnaryFunction>
+        UnaryFunction for_each(UnaryFunction f);
+        template <class UnaryFunction>
+        UnaryFunction for_each(UnaryFunction f) const;
+
+        template <class UnaryPredicate>
+        iterator find_if(UnaryPredicate pred) { return iterator(find_node(pred)); }
+        template <class UnaryPredicate>
+        const_iterator find_if(UnaryPredicate pred) const { return const_iterator(find_node(pred)); }
+
+        iterator find(const value_type &value)
+        {
+            return find_if([&value](const value_type &v)
+                           { return v == value; });
+        }
+        const_iterator find(const value_type &value) const
+        {
+            return find_if([&value](const value_type &v)
+                           { return v == value; });
+        }
+
+        /* 位置索引：每隔约 sqrt(n) 个节点记录一个检查点（节点及其序号），nth / index_of / distance 由此降到约 O(sqrt n)
+         * 1. 默认关闭，关闭时链表的任何操作都不会为它付出代价
+         * 2. 打开后增量维护：在尾部追加元素不影响索引；在中间插入、删除时，从修改处最多向后走 sqrt(n) 步找到下一个检查点，
+         *    只让它及之后的检查点失效，前面的继续可用。下一次非 const 的查询从最后一个可信的检查点往后补齐，
+         *    代价与修改位置到末尾的距离成正比；排序、整理、整体替换等操作让整个索引失效
+         * 3. const 的 nth / index_of / distance 只读取索引、不修改它，可以在多个线程中同时调用；
+         *    它们只利用仍然可信的检查点，失效的部分按普通链表走。非 const 的版本先补齐索引再查询
+         * 4. 索引属于当前对象，复制、移动、交换都不会带走它 */
+        void enable_index()
+        {
+            if (index_ == nullptr)
+                index_ = new position_index;
+            index_refresh();
+        }
+
+        void disable_index() noexcept
+        {
+            delete index_;
+            index_ = nullptr;
+        }
+
+        bool index_enabled() const noexcept { return index_ != nullptr; }
+
+        /* 第 k 个元素（从 0 开始），没有索引时从较近的一端走过去 */
+        iterator nth(size_type k)
+        {
+            if (index_ != nullptr)
+                index_refresh();
+            return iterator(nth_node(k));
+        }
+        const_iterator nth(size_type k) const { return const_iterator(nth_node(k)); }
+
+        /* it 的序号，end() 的序号为 size() */
+        size_type index_of(const_iterator it)
+        {
+            if (index_ != nullptr)
+                index_refresh();
+            return static_cast<const list &>(*this).index_of(it);
+        }
+        size_type index_of(const_iterator it) const;
+
+        /* 同一链表内 [first, last) 的元素个数，first 必须在 last 之前 */
+        size_type distance(const_iterator first, const_iterator last)
+        {
+            if (index_ != nullptr)
+                index_refresh();
+            return static_cast<const list &>(*this).distance(first, last);
+        }
+        size_type distance(const_iterator first, const_iterator last) const
+        {
+            if (index_ == nullptr)
+                return static_cast<size_type>(cheamstl::distance(first, last));
+            return index_of(last) - index_of(first);
+        }
+
     private:
+        /* 哨兵节点的地址。const 成员函数里构造迭代器同样需要一个可修改的 base_ptr，所以这里去掉 const */
+        base_ptr node() const noexcept
+        {
+            return const_cast<list_node_base<T, void_pointer> &>(head_).self();
+        }
+
+        // 创建 / 销毁节点
+        template <class... Args>
+        node_ptr create_node(Args &&...args);
+        void destroy_node(node_ptr p);
+        template <class Ctor>
+        void create_node_chain(size_type n, Ctor ctor, base_ptr &first, base_ptr &last);
+
+        // 初始化
         void fill_init(size_type n, const value_type &value);
-        void link_node_at_back(base_ptr first, base_ptr last);
+        template <class Iter>
+        void copy_init(Iter first, Iter last);
+        template <class Iter>
+        void copy_init(Iter first, Iter last, cheamstl::input_iterator_tag);
+        template <class Iter>
+        void copy_init(Iter first, Iter last, cheamstl::forward_iterator_tag);
+        template <class Iter>
+        void copy_init_n(Iter first, size_type n);
+
+        // 插入
+        iterator fill_insert(const_iterator pos, size_type n, const value_type &value);
+        template <class Iter>
+        iterator copy_insert(const_iterator pos, Iter first, Iter last, cheamstl::input_iterator_tag);
+        template <class Iter>
+        iterator copy_insert(const_iterator pos, Iter first, Iter last, cheamstl::forward_iterator_tag);
+
+        // 链接 / 断开节点
+        iterator link_iter_node(const_iterator pos, base_ptr link_node);
+        void link_nodes(base_ptr p, base_ptr first, base_ptr last);
+        void link_nodes_at_front(base_ptr first, base_ptr last);
+        void link_nodes_at_back(base_ptr first, base_ptr last);
+        void unlink_nodes(base_ptr first, base_ptr last);
+
+        // 赋值
+        void fill_assign(size_type n, const value_type &value);
+        template <class Iter>
+        void copy_assign(Iter first, Iter last);
+
+        /* 把 rhs 的全部节点接到当前（必须为空的）链表上，rhs 随后变为空链表 */
+        void take_nodes(list &rhs) noexcept;
+
+        // 排序时使用的单向链（以 nullptr 结尾，只维护 next）。small_list 的节点与 list 相同，直接复用
+        template <class, size_t, class>
+        friend class small_list;
+        template <class Compared>
+        static void merge_chain(base_ptr &a, base_ptr &b, Compared &comp);
+        template <class Compared>
+        static void sort_chain(base_ptr &chain, Compared &comp);
+        static base_ptr concat_chain(base_ptr a, base_ptr b) noexcept;
+        void relink_chain(base_ptr chain) noexcept;
+
+        // 碎片整理与预取遍历
+        node_ptr allocate_compact_chain(size_type n, std::true_type);
+        node_ptr allocate_compact_chain(size_type n, std::false_type);
+        template <class UnaryPredicate>
+        base_ptr find_node(UnaryPredicate &pred) const;
+
+        // 位置索引
+        void index_touch() noexcept
+        {
+            if (index_ != nullptr)
+                index_->valid = 0;
+        }
+        void index_touch(base_ptr from) noexcept;
+        void index_refresh();
+        base_ptr nth_node(size_type k) const;
+    };
+
+    /*****************************************************************************************/
+
+    // 删除 pos 处的元素
+    template <class T, class Alloc>
+    typename list<T, Alloc>::iterator list<T, Alloc>::erase(const_iterator pos)
+    {
+        CHEAMSTL_DEBUG(pos != cend());
+        auto n = pos.node_;
+        auto next = n->next;
+        unlink_nodes(n, n);
+        destroy_node(n->as_node());
+        --size_;
+        return iterator(next);
     }
 
-    template <class T>
-    void list<T>::fill_init(size_type n, const value_type &value)
+    // 删除 [first, last) 内的元素
+    template <class T, class Alloc>
+    typename list<T, Alloc>::iterator list<T, Alloc>::erase(const_iterator first, const_iterator last)
     {
-        node_ = base_allocator::allocate(1);
-        node_->unlink();
-        size_ = n;
-        try
+        if (first != last)
         {
-            for (; n > 0; --n)
+            unlink_nodes(first.node_, last.node_->prev);
+            while (first != last)
             {
-                auto node = create_node(value);
-                link_nodes_at_back(node->as_base(), node->as_base());
+                auto cur = first.node_;
+                ++first;
+                destroy_node(cur->as_node());
+                --size_;
             }
         }
-        catch (...)
+        return iterator(last.node_);
+    }
+
+    /* 清空 list，只释放元素节点，内置的哨兵保留
+     * 元素不需要析构、分配器的 deallocate 又什么也不做（单调增长的内存资源）时，逐个访问节点没有任何意义，
+     * 直接把链表置空即可，O(1)；节点占用的内存在资源 release() 时统一回收 */
+    template <class T, class Alloc>
+    void list<T, Alloc>::clear() noexcept
+    {
+        index_touch();
+        if (size_ != 0 && std::is_trivially_destructible<T>::value && this->deallocate_is_noop())
         {
-            clear();
-            base_allocator::deallocate(node_);
-            node_ = nullptr;
-            throw;
+            head_.unlink();
+            size_ = 0;
+        }
+        else if (size_ != 0)
+        {
+            auto cur = head_.next;
+            for (base_ptr next = cur->next; cur != node(); cur = next, next = cur->next)
+            {
+                destroy_node(cur->as_node());
+            }
+            head_.unlink();
+            size_ = 0;
         }
     }
 
-    template <class T>
-    void list<T>::link_node_at_back(base_ptr first, base_ptr last)
+    // 将 list other 接合于 pos 之前
+    template <class T, class Alloc>
+    void list<T, Alloc>::splice(const_iterator pos, list &other)
     {
-        last->next = node_;
-        first->prev = node_->prev;
-        first->prev->next = first;
-        node_->prev = last;
+        CHEAMSTL_DEBUG(this != &other && this->same_alloc(other));
+        if (!other.empty())
+        {
+            THROW_LENGTH_ERROR_IF(size_ > max_size() - other.size_, "list<T>'s size too big");
+
+            auto f = other.head_.next;
+            auto l = other.head_.prev;
+
+            other.unlink_nodes(f, l);
+            link_nodes(pos.node_, f, l);
+
+            size_ += other.size_;
+            other.size_ = 0;
+        }
     }
 
-    template <class T>
-    template <class Iter>
-    void list<T>::copy_init(Iter first, Iter last)
+    // 将 it 所指的节点接合于 pos 之前
+    template <class T, class Alloc>
+    void list<T, Alloc>::splice(const_iterator pos, list &other, const_iterator it)
     {
-        node_ = base_allocator::allocate(1);
-        node_->unlink();
-        size_type n = cheamstl::distance(first, last);
-        size_ = n;
-        try
+        CHEAMSTL_DEBUG(this->same_alloc(other));
+        if (pos.node_ != it.node_ && pos.node_ != it.node_->next)
         {
-            for (; n > 0; --n, ++first)
-            {
-                auto node = create_node(*first);
-                link_nocdes_at_back(node->as_base(), node->as_base());
-            }
-        }
-        catch (...)
+            THROW_LENGTH_ERROR_IF(size_ > max_size() - 1, "list<T>'s size too big");
+
+            auto f = it.node_;
+
+            other.unlink_nodes(f, f);
+            link_nodes(pos.node_, f, f);
+
+            ++size_;
+            --other.size_;
+        }
+    }
+
+    // 将 list other 的 [first, last) 内的节点接合于 pos 之前
+    template <class T, class Alloc>
+    void list<T, Alloc>::splice(const_iterator pos, list &other, const_iterator first, const_iterator last)
+    {
+        CHEAMSTL_DEBUG(this->same_alloc(other));
+        if (first != last && this != &other)
+        {
+            size_type n = cheamstl::distance(first, last);
+            THROW_LENGTH_ERROR_IF(size_ > max_size() - n, "list<T>'s size too big");
+            auto f = first.node_;
+            auto l = last.node_->prev;
+
+            other.unlink_nodes(f, l);
+            link_nodes(pos.node_, f, l);
+
+            size_ += n;
+            other.size_ -= n;
+        }
+        else if (first != last)
+        {
+            /* 同一个链表内部移动，元素个数不变 */
+            auto f = first.node_;
+            auto l = last.node_->prev;
+            unlink_nodes(f, l);
+            link_nodes(pos.node_, f, l);
+        }
+    }
+
+    // 移除相邻的重复元素，返回移除的个数
+    template <class T, class Alloc>
+    template <class BinaryPredicate>
+    typename list<T, Alloc>::size_type list<T, Alloc>::unique(BinaryPredicate pred)
+    {
+        size_type removed = 0;
+        base_ptr i = head_.next;
+        if (i == node())
+            return 0;
+        base_ptr j = i->next;
+        while (j != node())
+        {
+            if (pred(i->as_node()->value, j->as_node()->value))
+            {
+                base_ptr next = j->next;
+                unlink_nodes(j, j);
+                destroy_node(j->as_node());
+                --size_;
+                ++removed;
+                j = next;
+            }
+            else
+            {
+                i = j;
+                j = j->next;
+            }
+        }
+        return removed;
+    }
+
+    // 与另一个有序链表合并，相等的元素 *this 中的排在前面，other 合并后为空
+    template <class T, class Alloc>
+    template <class Compare>
+    void list<T, Alloc>::merge(list &other, Compare comp)
+    {
+        if (this == &other)
+            return;
+        CHEAMSTL_DEBUG(this->same_alloc(other));
+        THROW_LENGTH_ERROR_IF(size_ > max_size() - other.size_, "list<T>'s size too big");
+
+        base_ptr f1 = head_.next;
+        base_ptr f2 = other.head_.next;
+        base_ptr e1 = node();
+        base_ptr e2 = other.node();
+        while (f1 != e1 && f2 != e2)
+        {
+            if (comp(f2->as_node()->value, f1->as_node()->value))
+            {
+                /* 找出 other 中一段都小于 *f1 的节点，整段接到 f1 之前。
+                 * 每接一段就转移相应的计数，comp 中途抛出时两个链表的 size 仍与节点一致 */
+                base_ptr next = f2->next;
+                size_type n = 1;
+                while (next != e2 && comp(next->as_node()->value, f1->as_node()->value))
+                {
+                    next = next->next;
+                    ++n;
+                }
+                base_ptr f = f2;
+                base_ptr l = next->prev;
+                f2 = next;
+                other.unlink_nodes(f, l);
+                link_nodes(f1, f, l);
+                size_ += n;
+                other.size_ -= n;
+            }
+            f1 = f1->next;
+        }
+        if (f2 != e2)
+        {
+            base_ptr f = f2;
+            base_ptr l = e2->prev;
+            other.unlink_nodes(f, l);
+            link_nodes(e1, f, l);
+            size_ += other.size_;
+            other.size_ = 0;
+        }
+    }
+
+    /* 自底向上的归并排序，稳定、不申请内存，只改动 prev/next：
+     * 1. 先把循环链表在哨兵处断开，当作以 nullptr 结尾的单向链表处理，归并时只需要维护 next
+     * 2. bins[i] 保存一段长度为 2^i 的有序链，每取下一个节点就像二进制加一那样向上归并
+     * 3. 全部归并完成后，再用一趟遍历补上 prev 并接回哨兵
+     * comp 抛出异常时，所有节点都会被重新接回链表（顺序不确定），不会丢失元素 */
+    template <class T, class Alloc>
+    template <class Compared>
+    void list<T, Alloc>::sort(Compared comp)
+    {
+        if (size_ < 2)
+            return;
+        base_ptr chain = head_.next;
+        head_.prev->next = nullptr;
+        try
+        {
+            sort_chain(chain, comp);
+        }
+        catch (...)
+        {
+            relink_chain(chain);
+            throw;
+        }
+        relink_chain(chain);
+    }
+
+    /* 并行排序：一趟遍历按 size_ 均分成若干段，各段互不相交，可以放心地在线程池中各自排序；
+     * 之后每一轮把相邻两段并行归并，直到只剩一段。
+     * parallel_for 在 comp 抛出或提交任务失败时，也会等已经开始的任务全部结束才抛出，
+     * 此时各段仍然完整，把它们依次接起来放回链表（顺序不确定），不会丢失元素 */
+    template <class T, class Alloc>
+    template <class Compared, typename std::enable_if<!std::is_integral<Compared>::value, int>::type>
+    void list<T, Alloc>::sort(execution::parallel_policy, Compared comp, size_type threads)
+    {
+        work_stealing_pool &pool = work_stealing_pool::instance();
+        if (threads == 0)
+            threads = pool.size();
+        /* 每段至少 4096 个元素，否则调度的开销得不偿失 */
+        const size_type min_run = 4096;
+        if (threads > size_ / min_run)
+            threads = size_ / min_run;
+        if (threads < 2)
+        {
+            sort(comp);
+            return;
+        }
+
+        /* 需要申请内存的准备工作都放在拆开链表之前 */
+        std::vector<base_ptr> chains(threads);
+        base_ptr cur = head_.next;
+        head_.prev->next = nullptr;
+        for (size_type i = 0; i < threads; ++i)
+        {
+            size_type len = size_ / threads + (i < size_ % threads ? 1 : 0);
+            chains[i] = cur;
+            for (size_type k = 1; k < len; ++k)
+                cur = cur->next;
+            base_ptr next = cur->next;
+            cur->next = nullptr;
+            cur = next;
+        }
+
+        /* 每个任务使用 comp 的一份拷贝，避免有状态的比较器被并发访问 */
+        try
+        {
+            pool.parallel_for(threads, [&](size_t t)
+                              {
+                Compared c = comp;
+                sort_chain(chains[t], c); });
+            for (size_type step = 1; step < threads; step *= 2)
+            {
+                /* 本轮把 chains[2*t*step] 与 chains[(2*t+1)*step] 合并到前者中 */
+                size_type count = 0;
+                while ((2 * count + 1) * step < threads)
+                    ++count;
+                pool.parallel_for(count, [&, step](size_t t)
+                                  {
+                    Compared c = comp;
+                    merge_chain(chains[2 * t * step], chains[(2 * t + 1) * step], c); });
+            }
+        }
+        catch (...)
+        {
+            base_ptr all = nullptr;
+            for (auto c : chains)
+                all = concat_chain(all, c);
+            relink_chain(all);
+            throw;
+        }
+        relink_chain(chains[0]);
+    }
+
+    // 碎片整理：先建好新节点，再一次性替换，失败时不影响原链表
+    template <class T, class Alloc>
+    void list<T, Alloc>::compact()
+    {
+        if (empty())
+            return;
+        std::vector<node_ptr> blocks;
+        blocks.reserve(size_);
+        for (node_ptr p = allocate_compact_chain(size_, has_fresh_chain<node_allocator>()); p != nullptr;
+             p = node_allocator::chain_next(p))
+            blocks.push_back(p);
+        /* 分配器不保证连续时，至少让节点地址随链表顺序递增，顺序访问对硬件预取更友好 */
+        std::sort(blocks.begin(), blocks.end(), std::less<node_ptr>());
+
+        size_type i = 0;
+        try
+        {
+            for (auto it = begin(); it != end(); ++it, ++i)
+                data_allocator::construct(&blocks[i]->value, std::move_if_noexcept(*it));
+        }
+        catch (...)
+        {
+            for (size_type j = 0; j < i; ++j)
+                data_allocator::destroy(&blocks[j]->value);
+            for (node_ptr p : blocks)
+                this->alloc().deallocate(p);
+            throw;
+        }
+
+        index_touch();
+        base_ptr old = head_.next;
+        base_ptr prev = node();
+        for (node_ptr p : blocks)
+        {
+            p->prev = prev;
+            prev->next = p->as_base();
+            prev = p->as_base();
+        }
+        prev->next = node();
+        head_.prev = prev;
+        /* 旧链的最后一个节点仍然指向哨兵，可以据此结束 */
+        while (old != node())
+        {
+            base_ptr next = old->next;
+            destroy_node(old->as_node());
+            old = next;
+        }
+    }
+
+    template <class T, class Alloc>
+    void list<T, Alloc>::save(const char *path) const
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "list::save needs a trivially copyable T");
+        std::FILE *f = std::fopen(path, "wb");
+        THROW_RUNTIME_ERROR_IF(f == nullptr, "list::save: cannot open file");
+        list_snapshot_header h;
+        h.magic = list_snapshot_header::magic_value;
+        h.version = list_snapshot_header::current_version;
+        h.byte_order = list_snapshot_header::byte_order_mark;
+        h.elem_size = static_cast<uint32_t>(sizeof(T));
+        h.elem_align = static_cast<uint32_t>(alignof(T));
+        h.reserved = 0;
+        h.count = static_cast<uint64_t>(size_);
+        char head[list_snapshot_header::payload_offset] = {};
+        std::memcpy(head, &h, sizeof(h));
+        bool ok = std::fwrite(head, sizeof(head), 1, f) == 1;
+
+        /* 节点分散在堆上，先攒满一个缓冲区再写，避免每个元素一次 fwrite */
+        const size_type batch = (size_type(1) << 20) / sizeof(T) + 1;
+        std::vector<char> buf(batch * sizeof(T));
+        size_type used = 0;
+        for (base_ptr p = head_.next; ok && p != node(); p = p->next)
+        {
+            std::memcpy(buf.data() + used * sizeof(T), &p->as_node()->value, sizeof(T));
+            if (++used == batch)
+            {
+                ok = std::fwrite(buf.data(), sizeof(T), used, f) == used;
+                used = 0;
+            }
+        }
+        if (ok && used != 0)
+            ok = std::fwrite(buf.data(), sizeof(T), used, f) == used;
+        ok = std::fclose(f) == 0 && ok;
+        THROW_RUNTIME_ERROR_IF(!ok, "list::save: write failed");
+    }
+
+    template <class T, class Alloc>
+    void list<T, Alloc>::load(const char *path)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "list::load needs a trivially copyable T");
+        const size_type offset = list_snapshot_header::payload_offset;
+        const char *data = nullptr;
+        size_type bytes = 0;
+#if CHEAMSTL_HAS_MMAP
+        int fd = ::open(path, O_RDONLY);
+        THROW_RUNTIME_ERROR_IF(fd < 0, "list::load: cannot open file");
+        struct stat sb;
+        if (::fstat(fd, &sb) != 0)
+        {
+            ::close(fd);
+            THROW_RUNTIME_ERROR_IF(true, "list::load: cannot stat file");
+        }
+        bytes = static_cast<size_type>(sb.st_size);
+        if (bytes < offset)
+        {
+            /* 空文件不能 mmap，先按长度报错，与不用 mmap 时的报错一致 */
+            ::close(fd);
+            THROW_RUNTIME_ERROR_IF(true, "list::load: file too short");
+        }
+        int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+        flags |= MAP_POPULATE; // 一次把整个文件读进来，避免逐页缺页
+#endif
+        void *map = ::mmap(nullptr, bytes, PROT_READ, flags, fd, 0);
+        ::close(fd);
+        THROW_RUNTIME_ERROR_IF(map == MAP_FAILED, "list::load: mmap failed");
+        ::madvise(map, bytes, MADV_SEQUENTIAL);
+        data = static_cast<const char *>(map);
+        struct unmapper
+        {
+            void *p;
+            size_t n;
+            ~unmapper() { ::munmap(p, n); }
+        } guard{map, bytes};
+#else
+        std::vector<char> file;
+        std::FILE *f = std::fopen(path, "rb");
+        THROW_RUNTIME_ERROR_IF(f == nullptr, "list::load: cannot open file");
+        std::fseek(f, 0, SEEK_END);
+        long len = std::ftell(f);
+        std::fseek(f, 0, SEEK_SET);
+        if (len > 0)
+        {
+            file.resize(static_cast<size_type>(len));
+            if (std::fread(file.data(), 1, file.size(), f) != file.size())
+                file.clear();
+        }
+        std::fclose(f);
+        data = file.data();
+        bytes = file.size();
+#endif
+        list_snapshot_header h;
+        THROW_RUNTIME_ERROR_IF(bytes < offset, "list::load: file too short");
+        std::memcpy(&h, data, sizeof(h));
+        THROW_RUNTIME_ERROR_IF(h.magic != list_snapshot_header::magic_value || h.byte_order != list_snapshot_header::byte_order_mark,
+                               "list::load: not a list snapshot");
+        THROW_RUNTIME_ERROR_IF(h.version != list_snapshot_header::current_version, "list::load: unsupported version");
+        THROW_RUNTIME_ERROR_IF(h.elem_size != sizeof(T) || h.elem_align != alignof(T),
+                               "list::load: element type mismatch");
+        THROW_RUNTIME_ERROR_IF(h.count > (bytes - offset) / sizeof(T), "list::load: file truncated");
+        size_type n = static_cast<size_type>(h.count);
+        if (n == 0)
         {
             clear();
-            base_allocator::deallocate(node_);
-            node_ = nullptr;
+            return;
+        }
+
+        /* 一次拿到 n 个节点，沿分配器的链依次复制元素并连接；先读出链上的下一个，再覆盖节点 */
+        node_ptr chain = allocate_compact_chain(n, has_fresh_chain<node_allocator>());
+        clear();
+        const char *src = data + offset;
+        base_ptr prev = node();
+        for (node_ptr p = chain; p != nullptr; src += sizeof(T))
+        {
+            node_ptr next = node_allocator::chain_next(p);
+            std::memcpy(static_cast<void *>(&p->value), src, sizeof(T));
+            p->prev = prev;
+            prev->next = p->as_base();
+            prev = p->as_base();
+            p = next;
+        }
+        prev->next = node();
+        head_.prev = prev;
+        size_ = n;
+    }
+
+    template <class T, class Alloc>
+    typename list<T, Alloc>::node_ptr list<T, Alloc>::allocate_compact_chain(size_type n, std::true_type)
+    {
+        return this->alloc().allocate_fresh_chain(n);
+    }
+
+    template <class T, class Alloc>
+    typename list<T, Alloc>::node_ptr list<T, Alloc>::allocate_compact_chain(size_type n, std::false_type)
+    {
+        return this->alloc().allocate_chain(n);
+    }
+
+    template <class T, class Alloc>
+    template <class UnaryFunction>
+    UnaryFunction list<T, Alloc>::for_each(UnaryFunction f)
+    {
+        base_ptr end_node = node();
+        base_ptr ahead = head_.next;
+        for (size_type i = 0; i < prefetch_distance && ahead != end_node; ++i)
+            ahead = ahead->next;
+        for (base_ptr cur = head_.next; cur != end_node; cur = cur->next)
+        {
+            if (ahead != end_node)
+            {
+                prefetch_read(&*ahead);
+                ahead = ahead->next;
+            }
+            f(cur->as_node()->value);
+        }
+        return f;
+    }
+
+    template <class T, class Alloc>
+    template <class UnaryFunction>
+    UnaryFunction list<T, Alloc>::for_each(UnaryFunction f) const
+    {
+        base_ptr end_node = node();
+        base_ptr ahead = head_.next;
+        for (size_type i = 0; i < prefetch_distance && ahead != end_node; ++i)
+            ahead = ahead->next;
+        for (base_ptr cur = head_.next; cur != end_node; cur = cur->next)
+        {
+            if (ahead != end_node)
+            {
+                prefetch_read(&*ahead);
+                ahead = ahead->next;
+            }
+            f(static_cast<const T &>(cur->as_node()->value));
+        }
+        return f;
+    }
+
+    // 返回第一个满足 pred 的节点，没有则返回哨兵
+    template <class T, class Alloc>
+    template <class UnaryPredicate>
+    typename list<T, Alloc>::base_ptr list<T, Alloc>::find_node(UnaryPredicate &pred) const
+    {
+        base_ptr end_node = node();
+        base_ptr ahead = head_.next;
+        for (size_type i = 0; i < prefetch_distance && ahead != end_node; ++i)
+            ahead = ahead->next;
+        for (base_ptr cur = head_.next; cur != end_node; cur = cur->next)
+        {
+            if (ahead != end_node)
+            {
+                prefetch_read(&*ahead);
+                ahead = ahead->next;
+            }
+            if (pred(static_cast<const T &>(cur->as_node()->value)))
+                return cur;
+        }
+        return end_node;
+    }
+
+    /* 从 it 同时向两边走：向后碰到可信的检查点或 end()，向前碰到可信的检查点或第一个元素，先到者决定序号。
+     * 没有可信的检查点时退化为走到较近的一端 */
+    template <class T, class Alloc>
+    typename list<T, Alloc>::size_type list<T, Alloc>::index_of(const_iterator it) const
+    {
+        const position_index *ix = index_ != nullptr && index_->valid != 0 ? index_ : nullptr;
+        base_ptr first = head_.next;
+        base_ptr f = it.node_;
+        base_ptr b = it.node_;
+        for (size_type steps = 0;; ++steps, f = f->next, b = b->prev)
+        {
+            if (f == node())
+                return size_ - steps;
+            if (b == first)
+                return steps;
+            if (ix != nullptr)
+            {
+                size_type at = ix->find(&*f);
+                if (at < ix->valid)
+                    return at * ix->step - steps;
+                at = ix->find(&*b);
+                if (at < ix->valid)
+                    return at * ix->step + steps;
+            }
+        }
+    }
+
+    /* from 及其之后的序号将要改变：找到 from 之后（含 from）的第一个检查点，让它和之后的检查点失效。
+     * 可信区域内相邻检查点恰好相隔 step 个节点，所以最多走 step 步；走完还没遇到检查点，
+     * 说明 from 已经在最后一个可信检查点之后，索引不受影响 */
+    template <class T, class Alloc>
+    void list<T, Alloc>::index_touch(base_ptr from) noexcept
+    {
+        if (index_ == nullptr || index_->valid == 0)
+            return;
+        position_index &ix = *index_;
+        base_ptr p = from;
+        for (size_type k = 0; k <= ix.step && p != node(); ++k, p = p->next)
+        {
+            size_type at = ix.find(&*p);
+            if (at != position_index::none())
+            {
+                if (at < ix.valid)
+                    ix.valid = at;
+                return;
+            }
+        }
+    }
+
+    /* 补齐索引：从最后一个可信的检查点往后走，重新放置之后的检查点；步长与 sqrt(n) 相差超过一倍时整体重建。
+     * 全部可信、只是尾部追加的元素还不多时什么也不做 */
+    template <class T, class Alloc>
+    void list<T, Alloc>::index_refresh()
+    {
+        position_index &ix = *index_;
+        if (size_ == 0)
+        {
+            ix.nodes.clear();
+            ix.slots.clear();
+            ix.valid = 0;
+            return;
+        }
+        size_type want = static_cast<size_type>(std::sqrt(static_cast<double>(size_)));
+        if (want == 0)
+            want = 1;
+        if (ix.step > 2 * want || 2 * ix.step < want)
+            ix.valid = 0;
+        if (ix.valid == ix.nodes.size() && ix.valid != 0 && size_ - 1 - (ix.valid - 1) * ix.step < 2 * ix.step)
+            return;
+
+        base_ptr p;
+        size_type i;
+        if (ix.valid == 0)
+        {
+            ix.step = want;
+            ix.nodes.clear();
+            ix.nodes.reserve(size_ / ix.step + 1);
+            p = head_.next;
+            i = 0;
+            ix.nodes.push_back(p);
+        }
+        else
+        {
+            ix.nodes.resize(ix.valid);
+            p = ix.nodes.back();
+            i = (ix.valid - 1) * ix.step;
+        }
+        for (p = p->next, ++i; p != node(); p = p->next, ++i)
+        {
+            if (i % ix.step == 0)
+                ix.nodes.push_back(p);
+        }
+        /* 散列表重建成功之后才把新的检查点算作可信 */
+        ix.rehash();
+        ix.valid = ix.nodes.size();
+    }
+
+    // 第 k 个节点：从最近的可信检查点（或两端）出发，向前或向后走
+    template <class T, class Alloc>
+    typename list<T, Alloc>::base_ptr list<T, Alloc>::nth_node(size_type k) const
+    {
+        CHEAMSTL_DEBUG(k < size_);
+        base_ptr from = head_.next;
+        size_type forward = k;
+        base_ptr back_from = node();
+        size_type backward = size_ - k;
+        if (index_ != nullptr && index_->valid != 0)
+        {
+            const position_index &ix = *index_;
+            size_type i = k / ix.step;
+            if (i >= ix.valid)
+                i = ix.valid - 1;
+            from = ix.nodes[i];
+            forward = k - i * ix.step;
+            if (i + 1 < ix.valid)
+            {
+                back_from = ix.nodes[i + 1];
+                backward = (i + 1) * ix.step - k;
+            }
+        }
+        if (forward <= backward)
+        {
+            for (; forward > 0; --forward)
+                from = from->next;
+            return from;
+        }
+        for (; backward > 0; --backward)
+            back_from = back_from->prev;
+        return back_from;
+    }
+
+    /*****************************************************************************************/
+    // helper function
+
+    // 创建结点
+    template <class T, class Alloc>
+    template <class... Args>
+    typename list<T, Alloc>::node_ptr list<T, Alloc>::create_node(Args &&...args)
+    {
+        node_ptr p = this->alloc().allocate(1);
+        try
+        {
+            data_allocator::construct(&p->value, std::forward<Args>(args)...);
+            p->prev = nullptr;
+            p->next = nullptr;
+        }
+        catch (...)
+        {
+            this->alloc().deallocate(p);
+            throw;
+        }
+        return p;
+    }
+
+    // 销毁结点
+    template <class T, class Alloc>
+    void list<T, Alloc>::destroy_node(node_ptr p)
+    {
+        data_allocator::destroy(&p->value);
+        this->alloc().deallocate(p);
+    }
+
+    /* 批量创建 n 个节点，并串成一条 [first, last] 的双向链：
+     * 1. 通过 node_allocator::allocate_chain 一次拿到 n 块内存，而不是 n 次分配
+     * 2. 依次用 ctor(&node->value) 构造元素，同时在同一趟循环中把 prev/next 连好
+     * 3. 任何一个元素构造失败，已构造的节点全部销毁、未使用的内存全部归还，然后重新抛出，
+     *    调用者此时还没有修改容器，因此能提供强异常安全保证 */
+    template <class T, class Alloc>
+    template <class Ctor>
+    void list<T, Alloc>::create_node_chain(size_type n, Ctor ctor, base_ptr &first, base_ptr &last)
+    {
+        node_ptr block = this->alloc().allocate_chain(n);
+        base_ptr head = nullptr;
+        base_ptr tail = nullptr;
+        node_ptr cur = nullptr;
+        try
+        {
+            for (; n > 0; --n)
+            {
+                cur = block;
+                block = node_allocator::chain_next(block); // 构造之前先取出链表中下一块的地址
+                ctor(&cur->value);
+                cur->prev = tail;
+                if (tail)
+                    tail->next = cur->as_base();
+                else
+                    head = cur->as_base();
+                tail = cur->as_base();
+            }
+        }
+        catch (...)
+        {
+            this->alloc().deallocate(cur);
+            for (; block != nullptr;)
+            {
+                node_ptr next = node_allocator::chain_next(block);
+                this->alloc().deallocate(block);
+                block = next;
+            }
+            while (head != nullptr)
+            {
+                base_ptr next = head == tail ? nullptr : head->next;
+                destroy_node(head->as_node());
+                head = next;
+            }
             throw;
         }
+        first = head;
+        last = tail;
+    }
+
+    // 用 n 个元素初始化容器
+    template <class T, class Alloc>
+    void list<T, Alloc>::fill_init(size_type n, const value_type &value)
+    {
+        head_.unlink();
+        size_ = 0;
+        if (n == 0)
+            return;
+        THROW_LENGTH_ERROR_IF(n > max_size(), "list<T>'s size too big");
+        base_ptr first, last;
+        create_node_chain(n, [&value](T *p)
+                          { data_allocator::construct(p, value); },
+                          first, last);
+        link_nodes_at_back(first, last);
+        size_ = n;
+    }
+
+    // 以 [first, last) 初始化容器
+    template <class T, class Alloc>
+    template <class Iter>
+    void list<T, Alloc>::copy_init(Iter first, Iter last)
+    {
+        head_.unlink();
+        size_ = 0;
+        copy_init(first, last, typename iterator_traits<Iter>::iterator_category());
     }
 
+    // 单遍的输入迭代器无法预先知道元素个数，只能逐个创建
+    template <class T, class Alloc>
+    template <class Iter>
+    void list<T, Alloc>::copy_init(Iter first, Iter last, cheamstl::input_iterator_tag)
+    {
+        try
+        {
+            for (; first != last; ++first)
+            {
+                auto node = create_node(*first);
+                link_nodes_at_back(node->as_base(), node->as_base());
+                ++size_;
+            }
+        }
+        catch (...)
+        {
+            clear();
+            throw;
+        }
+    }
+
+    // 前向迭代器：先求出个数，再一次性批量创建
+    template <class T, class Alloc>
+    template <class Iter>
+    void list<T, Alloc>::copy_init(Iter first, Iter last, cheamstl::forward_iterator_tag)
+    {
+        copy_init_n(first, static_cast<size_type>(cheamstl::distance(first, last)));
+    }
+
+    // 已知个数的 n 个元素，一次性批量创建
+    template <class T, class Alloc>
+    template <class Iter>
+    void list<T, Alloc>::copy_init_n(Iter first, size_type n)
+    {
+        if (n == 0)
+            return;
+        base_ptr f, l;
+        create_node_chain(n, [&first](T *p)
+                          { data_allocator::construct(p, *first); ++first; },
+                          f, l);
+        link_nodes_at_back(f, l);
+        size_ = n;
+    }
+
+    // 在 pos 处插入 n 个元素，返回指向第一个新元素的迭代器
+    template <class T, class Alloc>
+    typename list<T, Alloc>::iterator list<T, Alloc>::fill_insert(const_iterator pos, size_type n, const value_type &value)
+    {
+        if (n == 0)
+            return iterator(pos.node_);
+        base_ptr first, last;
+        create_node_chain(n, [&value](T *p)
+                          { data_allocator::construct(p, value); },
+                          first, last);
+        link_nodes(pos.node_, first, last);
+        size_ += n;
+        return iterator(first);
+    }
+
+    // 在 pos 处插入 [first, last)：先在临时链表中建好，再整体接合，失败时不影响 *this
+    template <class T, class Alloc>
+    template <class Iter>
+    typename list<T, Alloc>::iterator list<T, Alloc>::copy_insert(const_iterator pos, Iter first, Iter last,
+                                                    cheamstl::input_iterator_tag)
+    {
+        list tmp(first, last, get_allocator());
+        if (tmp.empty())
+            return iterator(pos.node_);
+        iterator r = tmp.begin();
+        splice(pos, tmp);
+        return r;
+    }
+
+    template <class T, class Alloc>
+    template <class Iter>
+    typename list<T, Alloc>::iterator list<T, Alloc>::copy_insert(const_iterator pos, Iter first, Iter last,
+                                                    cheamstl::forward_iterator_tag)
+    {
+        size_type n = cheamstl::distance(first, last);
+        if (n == 0)
+            return iterator(pos.node_);
+        THROW_LENGTH_ERROR_IF(size_ > max_size() - n, "list<T>'s size too big");
+        base_ptr f, l;
+        create_node_chain(n, [&first](T *p)
+                          { data_allocator::construct(p, *first); ++first; },
+                          f, l);
+        link_nodes(pos.node_, f, l);
+        size_ += n;
+        return iterator(f);
+    }
+
+    // 在 pos 处连接一个节点
+    template <class T, class Alloc>
+    typename list<T, Alloc>::iterator list<T, Alloc>::link_iter_node(const_iterator pos, base_ptr link_node)
+    {
+        if (pos == head_.next)
+        {
+            link_nodes_at_front(link_node, link_node);
+        }
+        else if (pos == node())
+        {
+            link_nodes_at_back(link_node, link_node);
+        }
+        else
+        {
+            link_nodes(pos.node_, link_node, link_node);
+        }
+        return iterator(link_node);
+    }
+
+    // 在 pos 处连接 [first, last] 的结点
+    template <class T, class Alloc>
+    void list<T, Alloc>::link_nodes(base_ptr pos, base_ptr first, base_ptr last)
+    {
+        index_touch(pos);
+        pos->prev->next = first;
+        first->prev = pos->prev;
+        pos->prev = last;
+        last->next = pos;
+    }
+
+    // 在头部连接 [first, last] 结点
+    template <class T, class Alloc>
+    void list<T, Alloc>::link_nodes_at_front(base_ptr first, base_ptr last)
+    {
+        index_touch();
+        first->prev = node();
+        last->next = head_.next;
+        last->next->prev = last;
+        head_.next = first;
+    }
+
+    // 在尾部连接 [first, last] 结点，已有元素的序号不变，位置索引依然有效
+    template <class T, class Alloc>
+    void list<T, Alloc>::link_nodes_at_back(base_ptr first, base_ptr last)
+    {
+        last->next = node();
+        first->prev = head_.prev;
+        first->prev->next = first;
+        head_.prev = last;
+    }
+
+    // 容器与 [first, last] 结点断开连接
+    template <class T, class Alloc>
+    void list<T, Alloc>::unlink_nodes(base_ptr first, base_ptr last)
+    {
+        index_touch(first);
+        first->prev->next = last->next;
+        last->next->prev = first->prev;
+    }
+
+    // 用 n 个元素为容器赋值，已有的节点直接复用
+    template <class T, class Alloc>
+    void list<T, Alloc>::fill_assign(size_type n, const value_type &value)
+    {
+        auto i = begin();
+        auto e = end();
+        for (; n > 0 && i != e; --n, ++i)
+        {
+            *i = value;
+        }
+        if (n > 0)
+        {
+            insert(e, n, value);
+        }
+        else
+        {
+            erase(i, e);
+        }
+    }
+
+    // 复制 [f2, l2) 为容器赋值，已有的节点直接复用
+    template <class T, class Alloc>
+    template <class Iter>
+    void list<T, Alloc>::copy_assign(Iter f2, Iter l2)
+    {
+        auto f1 = begin();
+        auto l1 = end();
+        for (; f1 != l1 && f2 != l2; ++f1, ++f2)
+        {
+            *f1 = *f2;
+        }
+        if (f2 == l2)
+        {
+            erase(f1, l1);
+        }
+        else
+        {
+            insert(l1, f2, l2);
+        }
+    }
+
+    // 接管 rhs 的全部节点，当前链表必须为空
+    template <class T, class Alloc>
+    void list<T, Alloc>::take_nodes(list &rhs) noexcept
+    {
+        index_touch();
+        rhs.index_touch();
+        if (rhs.empty())
+            return;
+        head_.next = rhs.head_.next;
+        head_.prev = rhs.head_.prev;
+        head_.next->prev = node();
+        head_.prev->next = node();
+        size_ = rhs.size_;
+        rhs.head_.unlink();
+        rhs.size_ = 0;
+    }
+
+    /* 把以 nullptr 结尾的有序单向链 b 稳定地归并进 a（相等时 a 的节点在前），结束后 b 为空
+     * comp 抛出异常时，已归并部分与 a、b 的剩余部分一起拼回 a，保证节点不会丢失 */
+    template <class T, class Alloc>
+    template <class Compared>
+    void list<T, Alloc>::merge_chain(base_ptr &a, base_ptr &b, Compared &comp)
+    {
+        list_node_base<T, void_pointer> dummy;
+        base_ptr tail = dummy.self();
+        base_ptr x = a;
+        base_ptr y = b;
+        try
+        {
+            while (x != nullptr && y != nullptr)
+            {
+                if (comp(y->as_node()->value, x->as_node()->value))
+                {
+                    tail->next = y;
+                    y = y->next;
+                }
+                else
+                {
+                    tail->next = x;
+                    x = x->next;
+                }
+                tail = tail->next;
+            }
+        }
+        catch (...)
+        {
+            tail->next = concat_chain(x, y);
+            a = dummy.next;
+            b = nullptr;
+            throw;
+        }
+        tail->next = x != nullptr ? x : y;
+        a = dummy.next;
+        b = nullptr;
+    }
+
+    // 对以 nullptr 结尾的单向链做自底向上的归并排序，异常时 chain 仍包含全部节点
+    template <class T, class Alloc>
+    template <class Compared>
+    void list<T, Alloc>::sort_chain(base_ptr &chain, Compared &comp)
+    {
+        base_ptr bins[64] = {};
+        size_type fill = 0;
+        base_ptr carry = nullptr;
+        try
+        {
+            while (chain != nullptr)
+            {
+                carry = chain;
+                chain = chain->next;
+                carry->next = nullptr;
+                size_type i = 0;
+                for (; i < fill && bins[i] != nullptr; ++i)
+                {
+                    /* bins[i] 中的元素比 carry 中的先出现，放在左边以保证稳定 */
+                    merge_chain(bins[i], carry, comp);
+                    carry = bins[i];
+                    bins[i] = nullptr;
+                }
+                bins[i] = carry;
+                carry = nullptr;
+                if (i == fill)
+                    ++fill;
+            }
+            /* 编号越大的 bin 越早形成，所以从低到高依次把结果归并到它的右边 */
+            for (size_type i = 0; i < fill; ++i)
+            {
+                if (bins[i] == nullptr)
+                    continue;
+                merge_chain(bins[i], carry, comp);
+                carry = bins[i];
+                bins[i] = nullptr;
+            }
+        }
+        catch (...)
+        {
+            chain = concat_chain(carry, chain);
+            for (size_type i = 0; i < fill; ++i)
+                chain = concat_chain(bins[i], chain);
+            throw;
+        }
+        chain = carry;
+    }
+
+    // 把单向链 b 接到 a 的末尾
+    template <class T, class Alloc>
+    typename list<T, Alloc>::base_ptr list<T, Alloc>::concat_chain(base_ptr a, base_ptr b) noexcept
+    {
+        if (a == nullptr)
+            return b;
+        base_ptr tail = a;
+        while (tail->next != nullptr)
+            tail = tail->next;
+        tail->next = b;
+        return a;
+    }
+
+    // 补上单向链的 prev 指针，并把整条链接回哨兵，元素个数不变
+    template <class T, class Alloc>
+    void list<T, Alloc>::relink_chain(base_ptr chain) noexcept
+    {
+        index_touch();
+        base_ptr prev = node();
+        for (base_ptr cur = chain; cur != nullptr; cur = cur->next)
+        {
+            cur->prev = prev;
+            prev->next = cur;
+            prev = cur;
+        }
+        prev->next = node();
+        head_.prev = prev;
+    }
+
+    // 重载 cheamstl 的 swap
+    template <class T, class Alloc>
+    void swap(list<T, Alloc> &lhs, list<T, Alloc> &rhs) noexcept
+    {
+        lhs.swap(rhs);
+    }
+
+    namespace pmr
+    {
+        /* 节点从 memory_resource 中分配的 list，例如：
+         *   cheamstl::pmr::monotonic_buffer_resource arena;
+         *   cheamstl::pmr::list<int> l(&arena);
+         * 元素不需要析构时，l 的 clear / 析构都是 O(1)，arena.release() 一次回收所有节点 */
+        template <class T>
+        using list = cheamstl::list<T, polymorphic_allocator<T>>;
+    } // namespace pmr
+
 } // namespace cheamstl
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,254 @@
+#ifndef CHEAMSTL_LRU_CACHE_H_
+#define CHEAMSTL_LRU_CACHE_H_
+
+/* lru_cache：容量固定、按最近使用顺序淘汰的缓存
+ * 常见的写法是 std::list + unordered_map，每次命中都 erase 再 push_front（释放一个节点再申请一个），
+ * 每次淘汰都要从 map 里删一个节点、再插入一个节点。这里：
+ * 1. 条目直接存放在 cheamstl::list 的节点中，命中时用 splice 把节点移到表头，只改指针
+ * 2. 缓存满时不释放表尾节点，而是调用淘汰回调后原地改写成新条目，再 splice 到表头
+ * 3. 索引是开放定址（线性探测）的哈希表，槽里只存节点指针，大小在设置容量时一次确定，删除用后移法不留墓碑
+ * 因此缓存填满之后，无论命中还是未命中都不会再分配内存。
+ *
+ * 返回的 V* 在该条目被淘汰、删除或者 clear 之前一直有效（节点不会移动） */
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "allocator.h"
+#include "exceptdef.h"
+#include "list.h"
+
+namespace cheamstl
+{
+
+    template <class K, class V>
+    struct lru_entry
+    {
+        K key;
+        V value;
+        size_t hash; // 保存哈希值，探测和后移时不必重新计算
+
+        template <class KK, class VV>
+        lru_entry(KK &&k, VV &&v, size_t h) : key(std::forward<KK>(k)), value(std::forward<VV>(v)), hash(h) {}
+    };
+
+    template <class K, class V, class Hash = std::hash<K>, class KeyEqual = std::equal_to<K>,
+              class Alloc = cheamstl::pool_allocator<lru_entry<K, V>>>
+    class lru_cache
+    {
+    public:
+        typedef K key_type;
+        typedef V mapped_type;
+        typedef lru_entry<K, V> value_type;
+        typedef size_t size_type;
+        typedef Hash hasher;
+        typedef KeyEqual key_equal;
+
+        /* 条目被淘汰时调用，参数是即将被覆盖的键和值，回调里可以把值移走 */
+        typedef std::function<void(const K &, V &)> evict_callback;
+
+        typedef cheamstl::list<value_type, Alloc> list_type;
+        /* 从最近使用到最久未使用依次遍历，遍历不改变顺序 */
+        typedef typename list_type::const_iterator const_iterator;
+
+    private:
+        typedef typename list_type::iterator iterator;
+        typedef typename list_type::base_ptr base_ptr;
+
+        list_type entries_;          // 表头是最近使用的条目
+        std::vector<base_ptr> slots_; // 开放定址表，nullptr 表示空槽
+        size_type mask_;
+        size_type capacity_;
+        evict_callback on_evict_;
+        hasher hash_;
+        key_equal equal_;
+
+    public:
+        explicit lru_cache(size_type capacity, evict_callback on_evict = evict_callback(),
+                           const hasher &hash = hasher(), const key_equal &equal = key_equal())
+            : mask_(0), capacity_(0), on_evict_(std::move(on_evict)), hash_(hash), equal_(equal)
+        {
+            set_capacity(capacity);
+        }
+
+        lru_cache(const lru_cache &) = delete;
+        lru_cache &operator=(const lru_cache &) = delete;
+
+        // 容量相关操作
+        bool empty() const noexcept { return entries_.empty(); }
+        size_type size() const noexcept { return entries_.size(); }
+        size_type capacity() const noexcept { return capacity_; }
+
+        /* 修改容量并重建索引；缩小时从最久未使用的一端开始淘汰（会调用回调） */
+        void set_capacity(size_type capacity)
+        {
+            THROW_LENGTH_ERROR_IF(capacity == 0, "lru_cache<K, V>'s capacity must be positive");
+            while (entries_.size() > capacity)
+                evict_back();
+            size_type slots = 2;
+            while (slots < capacity * 2)
+                slots *= 2;
+            std::vector<base_ptr> fresh(slots, nullptr);
+            slots_.swap(fresh);
+            mask_ = slots - 1;
+            capacity_ = capacity;
+            for (iterator it = entries_.begin(); it != entries_.end(); ++it)
+                slots_[probe_empty(it->hash)] = it.node_;
+        }
+
+        void set_evict_callback(evict_callback on_evict) { on_evict_ = std::move(on_evict); }
+
+        const_iterator begin() const noexcept { return entries_.cbegin(); }
+        const_iterator end() const noexcept { return entries_.cend(); }
+
+        /* 查找并把条目标记为最近使用，不存在时返回 nullptr */
+        V *get(const K &key)
+        {
+            size_type i = find_slot(key, hash_of(key));
+            if (slots_[i] == nullptr)
+                return nullptr;
+            iterator it(slots_[i]);
+            entries_.splice(entries_.cbegin(), entries_, it);
+            return &it->value;
+        }
+
+        /* 只查找，不改变使用顺序 */
+        const V *peek(const K &key) const
+        {
+            size_type i = find_slot(key, hash_of(key));
+            return slots_[i] == nullptr ? nullptr : &iterator(slots_[i])->value;
+        }
+
+        bool contains(const K &key) const { return peek(key) != nullptr; }
+
+        /* 插入或更新，结果成为最近使用的条目；缓存已满时先淘汰最久未使用的条目并复用它的节点 */
+        template <class VV>
+        V &put(const K &key, VV &&value)
+        {
+            size_t h = hash_of(key);
+            size_type i = find_slot(key, h);
+            if (slots_[i] != nullptr)
+            {
+                iterator it(slots_[i]);
+                it->value = std::forward<VV>(value);
+                entries_.splice(entries_.cbegin(), entries_, it);
+                return it->value;
+            }
+            if (entries_.size() < capacity_)
+            {
+                entries_.emplace_front(key, std::forward<VV>(value), h);
+                slots_[i] = entries_.begin().node_;
+                return entries_.front().value;
+            }
+            /* 复用表尾节点：先从索引中删掉旧键（后移可能改变 i，所以之后重新探测），再改写条目 */
+            iterator victim(entries_.end());
+            --victim;
+            if (on_evict_)
+                on_evict_(victim->key, victim->value);
+            erase_slot(find_slot(victim->key, victim->hash));
+            try
+            {
+                victim->key = key;
+                victim->value = std::forward<VV>(value);
+            }
+            catch (...)
+            {
+                /* 条目已经不在索引里，改写了一半的节点直接丢弃 */
+                entries_.erase(victim);
+                throw;
+            }
+            victim->hash = h;
+            slots_[probe_empty(h)] = victim.node_;
+            entries_.splice(entries_.cbegin(), entries_, victim);
+            return victim->value;
+        }
+
+        /* 删除一个条目（不调用淘汰回调），返回是否存在 */
+        bool erase(const K &key)
+        {
+            size_type i = find_slot(key, hash_of(key));
+            if (slots_[i] == nullptr)
+                return false;
+            iterator it(slots_[i]);
+            erase_slot(i);
+            entries_.erase(it);
+            return true;
+        }
+
+        void clear() noexcept
+        {
+            entries_.clear();
+            std::fill(slots_.begin(), slots_.end(), nullptr);
+        }
+
+    private:
+        /* std::hash 对整数往往是恒等映射，低位分布很差，而槽下标只取低位，所以再混合一次 */
+        size_t hash_of(const K &key) const
+        {
+            size_t h = hash_(key);
+            h ^= h >> 16;
+            h *= static_cast<size_t>(0x9E3779B97F4A7C15ULL);
+            h ^= h >> 29;
+            return h;
+        }
+
+        /* 返回 key 所在的槽，不存在时返回探测到的第一个空槽 */
+        size_type find_slot(const K &key, size_t h) const
+        {
+            size_type i = h & mask_;
+            while (slots_[i] != nullptr)
+            {
+                const value_type &e = *iterator(slots_[i]);
+                if (e.hash == h && equal_(e.key, key))
+                    return i;
+                i = (i + 1) & mask_;
+            }
+            return i;
+        }
+
+        size_type probe_empty(size_t h) const noexcept
+        {
+            size_type i = h & mask_;
+            while (slots_[i] != nullptr)
+                i = (i + 1) & mask_;
+            return i;
+        }
+
+        /* 清空槽 i，并把后面同一段探测序列中能前移的元素前移，保证之后的查找不会提前遇到空槽 */
+        void erase_slot(size_type i) noexcept
+        {
+            size_type j = i;
+            for (;;)
+            {
+                j = (j + 1) & mask_;
+                if (slots_[j] == nullptr)
+                    break;
+                size_type home = iterator(slots_[j])->hash & mask_;
+                /* home 不在 (i, j] 之间时，j 上的元素可以移到 i */
+                bool stay = i <= j ? (i < home && home <= j) : (i < home || home <= j);
+                if (!stay)
+                {
+                    slots_[i] = slots_[j];
+                    i = j;
+                }
+            }
+            slots_[i] = nullptr;
+        }
+
+        void evict_back()
+        {
+            iterator victim(entries_.end());
+            --victim;
+            if (on_evict_)
+                on_evict_(victim->key, victim->value);
+            erase_slot(find_slot(victim->key, victim->hash));
+            entries_.erase(victim);
+        }
+    };
+
+} // namespace cheamstl
+
+#endif // !CHEAMSTL_LRU_CACHE_H_
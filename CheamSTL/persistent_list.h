@@ -0,0 +1,472 @@
+#ifndef CHEAMSTL_PERSISTENT_LIST_H_
+#define CHEAMSTL_PERSISTENT_LIST_H_
+
+/* persistent_list：不可变的单向链表，修改时共享未改变的部分
+ * list 的复制构造要逐个复制节点，把一个大链表的快照交给很多读线程时，每次更新都是 O(n) 的分配和复制。
+ * persistent_list 的节点一旦创建就不再修改，节点带原子引用计数，多个版本可以共享同一段尾部：
+ * 1. 复制（取快照）只是引用计数加一，O(1)
+ * 2. push_front / pop_front 是 O(1)，新版本与旧版本共享整个尾部
+ * 3. set / insert / erase 第 i 个位置时复制前 i 个节点，其余的尾部共享，内存与改动的位置成正比，与链表长度无关
+ * 4. 节点不可变，任何线程都可以无锁地遍历自己手里的版本；最后一个引用释放时节点才被回收（循环释放，不会递归爆栈）
+ *
+ * 多个线程共享“当前版本”时使用 persistent_list_cell：读者 load() 得到一个快照（hazard pointer 保护下复制一个指针），
+ * 之后的遍历完全无锁；写者 update(f) 基于当前版本构造新版本再用 CAS 发布。
+ * 与 concurrent_queue 相同，节点可能在另一个线程释放，所以默认使用通用的 allocator */
+
+#include <atomic>
+#include <cstddef>
+#include <initializer_list>
+#include <type_traits>
+#include <utility>
+
+#include "allocator.h"
+#include "exceptdef.h"
+#include "hazard_pointer.h"
+#include "iterator.h"
+
+namespace cheamstl
+{
+
+    template <class T>
+    struct persistent_list_node
+    {
+        std::atomic<size_t> refs;
+        size_t length; // 从本节点到表尾的元素个数，size() 因此是 O(1)
+        persistent_list_node *next;
+        T value;
+
+        template <class... Args>
+        persistent_list_node(persistent_list_node *n, size_t len, Args &&...args)
+            : refs(1), length(len), next(n), value(std::forward<Args>(args)...)
+        {
+        }
+    };
+
+    /* 只读的前向迭代器，end() 为空指针 */
+    template <class T>
+    struct persistent_list_iterator
+    {
+        typedef cheamstl::forward_iterator_tag iterator_category;
+        typedef ptrdiff_t difference_type;
+        typedef T value_type;
+        typedef const T *pointer;
+        typedef const T &reference;
+        typedef persistent_list_node<T> *node_ptr;
+        typedef persistent_list_iterator self;
+
+        node_ptr node_;
+
+        persistent_list_iterator() = default;
+        explicit persistent_list_iterator(node_ptr x) : node_(x) {}
+
+        reference operator*() const { return node_->value; }
+        pointer operator->() const { return &(operator*()); }
+
+        self &operator++()
+        {
+            node_ = node_->next;
+            return *this;
+        }
+        self operator++(int)
+        {
+            self tmp = *this;
+            node_ = node_->next;
+            return tmp;
+        }
+
+        bool operator==(const self &rhs) const { return node_ == rhs.node_; }
+        bool operator!=(const self &rhs) const { return node_ != rhs.node_; }
+    };
+
+    template <class T, class Alloc = cheamstl::allocator<T>>
+    class persistent_list
+    {
+    public:
+        typedef Alloc allocator_type;
+        typedef typename Alloc::template rebind<persistent_list_node<T>>::other node_allocator;
+
+        typedef T value_type;
+        typedef const T *pointer;
+        typedef const T *const_pointer;
+        typedef const T &reference;
+        typedef const T &const_reference;
+        typedef size_t size_type;
+        typedef ptrdiff_t difference_type;
+
+        /* 元素不可修改，iterator 与 const_iterator 相同 */
+        typedef persistent_list_iterator<T> iterator;
+        typedef persistent_list_iterator<T> const_iterator;
+
+        typedef persistent_list_node<T> node_type;
+        typedef node_type *node_ptr;
+
+    private:
+        node_ptr head_;
+
+        explicit persistent_list(node_ptr head) noexcept : head_(head) {}
+
+    public:
+        persistent_list() noexcept : head_(nullptr) {}
+
+        template <class Iter, typename std::enable_if<cheamstl::is_input_iterator<Iter>::value, int>::type = 0>
+        persistent_list(Iter first, Iter last) : head_(nullptr)
+        {
+            build(first, last);
+        }
+
+        persistent_list(std::initializer_list<T> ilist) : head_(nullptr) { build(ilist.begin(), ilist.end()); }
+
+        /* 快照：与 rhs 共享所有节点 */
+        persistent_list(const persistent_list &rhs) noexcept : head_(acquire(rhs.head_)) {}
+
+        persistent_list(persistent_list &&rhs) noexcept : head_(rhs.head_) { rhs.head_ = nullptr; }
+
+        persistent_list &operator=(const persistent_list &rhs) noexcept
+        {
+            persistent_list tmp(rhs);
+            swap(tmp);
+            return *this;
+        }
+
+        persistent_list &operator=(persistent_list &&rhs) noexcept
+        {
+            persistent_list tmp(std::move(rhs));
+            swap(tmp);
+            return *this;
+        }
+
+        ~persistent_list() { release(head_); }
+
+    public:
+        // 迭代器相关操作
+        const_iterator begin() const noexcept { return const_iterator(head_); }
+        const_iterator end() const noexcept { return const_iterator(nullptr); }
+        const_iterator cbegin() const noexcept { return begin(); }
+        const_iterator cend() const noexcept { return end(); }
+
+        // 容量相关操作
+        bool empty() const noexcept { return head_ == nullptr; }
+        size_type size() const noexcept { return head_ == nullptr ? 0 : head_->length; }
+        size_type max_size() const noexcept { return static_cast<size_type>(-1); }
+
+        const_reference front() const
+        {
+            CHEAMSTL_DEBUG(!empty());
+            return head_->value;
+        }
+
+        /* 两个版本是否是同一个版本（共享同一个头节点） */
+        bool same_as(const persistent_list &rhs) const noexcept { return head_ == rhs.head_; }
+
+        void swap(persistent_list &rhs) noexcept
+        {
+            node_ptr tmp = head_;
+            head_ = rhs.head_;
+            rhs.head_ = tmp;
+        }
+
+        // 以下操作都不修改当前版本，而是返回新版本
+
+        template <class... Args>
+        persistent_list emplace_front(Args &&...args) const
+        {
+            return persistent_list(create_node(acquire(head_), size() + 1, std::forward<Args>(args)...));
+        }
+
+        persistent_list push_front(const value_type &value) const { return emplace_front(value); }
+        persistent_list push_front(value_type &&value) const { return emplace_front(std::move(value)); }
+
+        /* 去掉第一个元素，新版本就是原来的尾部 */
+        persistent_list pop_front() const
+        {
+            CHEAMSTL_DEBUG(!empty());
+            return persistent_list(acquire(head_->next));
+        }
+
+        /* 把第 i 个元素替换为 value：复制前 i 个节点，第 i 个之后的尾部共享 */
+        template <class VV>
+        persistent_list set(size_type i, VV &&value) const
+        {
+            THROW_OUT_OF_RANGE_IF(i >= size(), "persistent_list<T>::set out of range");
+            node_ptr old = nth(i);
+            return rebuild(i, old->next, std::forward<VV>(value));
+        }
+
+        /* 在第 i 个位置（0 <= i <= size()）插入 value，原来第 i 个及以后的节点共享 */
+        template <class VV>
+        persistent_list insert(size_type i, VV &&value) const
+        {
+            THROW_OUT_OF_RANGE_IF(i > size(), "persistent_list<T>::insert out of range");
+            return rebuild(i, nth(i), std::forward<VV>(value));
+        }
+
+        /* 删除第 i 个元素，它之后的节点共享 */
+        persistent_list erase(size_type i) const
+        {
+            THROW_OUT_OF_RANGE_IF(i >= size(), "persistent_list<T>::erase out of range");
+            node_ptr tail = nth(i)->next;
+            return persistent_list(copy_prefix(i, tail));
+        }
+
+    private:
+        static node_ptr acquire(node_ptr p) noexcept
+        {
+            if (p != nullptr)
+                p->refs.fetch_add(1, std::memory_order_relaxed);
+            return p;
+        }
+
+        /* 引用计数减到 0 时回收节点，并继续释放它对下一个节点的引用；用循环代替递归 */
+        static void release(node_ptr p) noexcept
+        {
+            while (p != nullptr && p->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                node_ptr next = p->next;
+                node_allocator::destroy(p);
+                node_allocator::deallocate(p);
+                p = next;
+            }
+        }
+
+        /* next 的引用由新节点接管；构造失败时把这份引用还回去 */
+        template <class... Args>
+        static node_ptr create_node(node_ptr next, size_type length, Args &&...args)
+        {
+            node_ptr p = nullptr;
+            try
+            {
+                p = node_allocator::allocate(1);
+                node_allocator::construct(p, next, length, std::forward<Args>(args)...);
+            }
+            catch (...)
+            {
+                if (p != nullptr)
+                    node_allocator::deallocate(p);
+                release(next);
+                throw;
+            }
+            return p;
+        }
+
+        node_ptr nth(size_type i) const noexcept
+        {
+            node_ptr p = head_;
+            for (; i > 0; --i)
+                p = p->next;
+            return p;
+        }
+
+        /* 复制前 i 个节点并接到 tail（共享，引用计数加一）上，返回新的头节点；复制的节点长度按 tail 的长度重新计算 */
+        node_ptr copy_prefix(size_type i, node_ptr tail) const
+        {
+            size_type tail_len = tail == nullptr ? 0 : tail->length;
+            node_ptr head = nullptr;
+            node_ptr last = nullptr;
+            try
+            {
+                node_ptr src = head_;
+                for (size_type k = 0; k < i; ++k, src = src->next)
+                {
+                    node_ptr p = create_node(nullptr, tail_len + (i - k), src->value);
+                    if (last == nullptr)
+                        head = p;
+                    else
+                        last->next = p;
+                    last = p;
+                }
+            }
+            catch (...)
+            {
+                release(head);
+                throw;
+            }
+            if (last == nullptr)
+                return acquire(tail);
+            last->next = acquire(tail);
+            return head;
+        }
+
+        template <class VV>
+        persistent_list rebuild(size_type i, node_ptr tail, VV &&value) const
+        {
+            node_ptr mid = create_node(acquire(tail), (tail == nullptr ? 0 : tail->length) + 1, std::forward<VV>(value));
+            node_ptr head;
+            try
+            {
+                head = copy_prefix(i, mid);
+            }
+            catch (...)
+            {
+                release(mid);
+                throw;
+            }
+            release(mid); // copy_prefix 已经持有 mid 的一份引用
+            return persistent_list(head);
+        }
+
+        template <class Iter>
+        void build(Iter first, Iter last)
+        {
+            node_ptr tail = nullptr;
+            size_type n = 0;
+            try
+            {
+                for (; first != last; ++first, ++n)
+                {
+                    node_ptr p = create_node(nullptr, 0, *first);
+                    if (tail == nullptr)
+                        head_ = p;
+                    else
+                        tail->next = p;
+                    tail = p;
+                }
+            }
+            catch (...)
+            {
+                release(head_);
+                head_ = nullptr;
+                throw;
+            }
+            for (node_ptr p = head_; p != nullptr; p = p->next, --n)
+                p->length = n;
+        }
+    };
+
+    template <class T, class Alloc>
+    bool operator==(const persistent_list<T, Alloc> &lhs, const persistent_list<T, Alloc> &rhs)
+    {
+        if (lhs.size() != rhs.size())
+            return false;
+        auto f1 = lhs.cbegin();
+        auto f2 = rhs.cbegin();
+        /* 共享同一段尾部后，剩下的部分必然相同 */
+        for (; f1 != lhs.cend() && f1.node_ != f2.node_; ++f1, ++f2)
+            if (!(*f1 == *f2))
+                return false;
+        return true;
+    }
+
+    template <class T, class Alloc>
+    bool operator!=(const persistent_list<T, Alloc> &lhs, const persistent_list<T, Alloc> &rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    template <class T, class Alloc>
+    void swap(persistent_list<T, Alloc> &lhs, persistent_list<T, Alloc> &rhs) noexcept
+    {
+        lhs.swap(rhs);
+    }
+
+    /* 多个线程共享的“当前版本”：
+     *   读者：auto snap = cell.load();  之后无锁遍历 snap，期间写者的更新不影响它
+     *   写者：cell.update([](const persistent_list<T> &cur) { return cur.push_front(x); });
+     * 当前版本放在一个小的 version 对象里，通过原子指针发布，读写都不加锁：
+     * 1. load：用 hazard pointer 保护 version，再复制其中的链表（引用计数加一），之后撤销保护
+     * 2. store / update：构造新的 version，用 exchange / CAS 换上去，被换下的交给 hazard_domain，
+     *    没有读者再保护它时才析构，这时才放弃它对旧版本的引用
+     * 线程第一次使用时要申请 hazard pointer 记录，所以 load 也可能抛出 bad_alloc */
+    template <class T, class Alloc = cheamstl::allocator<T>>
+    class persistent_list_cell
+    {
+    public:
+        typedef persistent_list<T, Alloc> list_type;
+
+    private:
+        struct version
+        {
+            version *retire_next; // hazard_domain 串起回收链表
+            list_type list;
+
+            explicit version(list_type &&l) noexcept : retire_next(nullptr), list(std::move(l)) {}
+        };
+
+        typedef typename Alloc::template rebind<version>::other version_allocator;
+
+        /* hazard_domain 回收 version 时调用：先析构（放弃对链表的引用），再归还内存 */
+        struct version_reclaimer
+        {
+            static void deallocate(version *v) noexcept
+            {
+                version_allocator::destroy(v);
+                version_allocator::deallocate(v);
+            }
+        };
+
+        typedef hazard_domain<version, version_reclaimer> domain;
+
+        std::atomic<version *> current_;
+
+    public:
+        persistent_list_cell() : current_(make_version(list_type())) {}
+        explicit persistent_list_cell(list_type init) : current_(make_version(std::move(init))) {}
+
+        persistent_list_cell(const persistent_list_cell &) = delete;
+        persistent_list_cell &operator=(const persistent_list_cell &) = delete;
+
+        /* 析构时不能再有其他线程访问；已经换下、还在等待回收的 version 由 hazard_domain 负责 */
+        ~persistent_list_cell()
+        {
+            version_reclaimer::deallocate(current_.load(std::memory_order_acquire));
+            domain::flush();
+        }
+
+        list_type load() const
+        {
+            typename domain::record *r = domain::acquire();
+            version *v = domain::protect(r, 0, current_);
+            list_type snap(v->list);
+            domain::clear(r);
+            return snap;
+        }
+
+        void store(list_type next)
+        {
+            version *v = make_version(std::move(next));
+            domain::retire(current_.exchange(v, std::memory_order_acq_rel));
+        }
+
+        /* 基于当前版本构造新版本并发布；期间有其他写者发布过，就基于最新版本重做。返回发布的版本。
+         * f 执行期间一直保护着它看到的 version，所以 CAS 比较的指针不会被回收后重用（没有 ABA） */
+        template <class F>
+        list_type update(F f)
+        {
+            typename domain::record *r = domain::acquire();
+            for (;;)
+            {
+                version *base = domain::protect(r, 0, current_);
+                version *v;
+                list_type published;
+                try
+                {
+                    list_type next = f(static_cast<const list_type &>(base->list));
+                    published = next;
+                    v = make_version(std::move(next));
+                }
+                catch (...)
+                {
+                    domain::clear(r);
+                    throw;
+                }
+                if (current_.compare_exchange_strong(base, v, std::memory_order_acq_rel, std::memory_order_relaxed))
+                {
+                    domain::clear(r);
+                    domain::retire(base);
+                    return published;
+                }
+                version_reclaimer::deallocate(v);
+            }
+        }
+
+    private:
+        static version *make_version(list_type &&l)
+        {
+            version *v = version_allocator::allocate(1);
+            version_allocator::construct(v, std::move(l));
+            return v;
+        }
+    };
+
+} // namespace cheamstl
+
+#endif // !CHEAMSTL_PERSISTENT_LIST_H_
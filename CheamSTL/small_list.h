@@ -0,0 +1,633 @@
+#ifndef CHEAMSTL_SMALL_LIST_H_
+#define CHEAMSTL_SMALL_LIST_H_
+
+/* small_list：前 N 个节点放在对象内部的双向链表
+ * 大多数链表只有几个元素，但 list 的每个节点都要向分配器申请一次。
+ * small_list 在对象内部预留 N 个 list_node<T> 的位置（哨兵本来就在对象内部），
+ * 节点优先使用这些内置槽，用完之后才向节点分配器申请：
+ * 1. 元素个数不超过 N 时，构造、插入、删除、析构都不会分配内存
+ * 2. 节点类型、迭代器都与 list 相同，插入 / 删除 / 同一链表内的 splice 的迭代器失效规则与 list 一样
+ * 3. 删除的内置槽挂进空闲链表，之后的插入优先复用
+ *
+ * 与 list 的不同之处：内置槽属于对象本身，不能把它交给另一个链表
+ * 1. 跨链表 splice 时，堆上的节点直接改指针转移；内置槽中的节点要把元素移动到目标链表新建的节点里，
+ *    这些元素的迭代器失效
+ * 2. 移动构造 / 交换 / merge 同理：堆上的节点被接管，内置槽中的元素逐个移动
+ * 只支持无状态的分配器（节点之间是普通指针）
+ *
+ * 提供 list 的基本接口，以及 splice / unique / merge / sort / find / find_if；sort 直接复用 list 的归并排序。
+ * 以下 list 的功能没有提供：节点句柄（内置槽中的节点不能离开对象）、并行排序（元素很少，用不上线程池）、
+ * compact / save / load / 位置索引（面向长链表），需要时先转换成 list */
+
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <type_traits>
+#include <utility>
+
+#include "allocator.h"
+#include "exceptdef.h"
+#include "iterator.h"
+#include "list.h"
+
+namespace cheamstl
+{
+
+    template <class T, size_t N = 8, class Alloc = cheamstl::pool_allocator<T>>
+    class small_list
+    {
+        static_assert(N >= 1, "small_list needs at least one inline node");
+
+    public:
+        typedef Alloc allocator_type;
+        typedef Alloc data_allocator;
+        typedef typename list_node_allocator<T, Alloc>::type node_allocator;
+        static_assert(std::is_same<typename list_node_allocator<T, Alloc>::void_pointer, void *>::value,
+                      "small_list only supports allocators with raw pointers");
+
+        typedef T value_type;
+        typedef T *pointer;
+        typedef const T *const_pointer;
+        typedef T &reference;
+        typedef const T &const_reference;
+        typedef size_t size_type;
+        typedef ptrdiff_t difference_type;
+
+        typedef list_iterator<T> iterator;
+        typedef list_const_iterator<T> const_iterator;
+        typedef cheamstl::reverse_iterator<iterator> reverse_iterator;
+        typedef cheamstl::reverse_iterator<const_iterator> const_reverse_iterator;
+
+        typedef typename node_traits<T>::base_ptr base_ptr;
+        typedef typename node_traits<T>::node_ptr node_ptr;
+
+        static constexpr size_type inline_capacity = N;
+
+    private:
+        typedef typename std::aligned_storage<sizeof(list_node<T>), alignof(list_node<T>)>::type slot_type;
+        typedef list<T, Alloc> list_type; // 借用 list 的排序
+
+        list_node_base<T> head_; // 内置哨兵
+        size_type size_;
+        size_type inline_used_; // [0, inline_used_) 的内置槽分配出去过
+        base_ptr inline_free_;  // 已释放的内置槽，用 next 串成单链表
+        slot_type slots_[N];
+
+    public:
+        small_list() noexcept : size_(0) { reset(); }
+
+        explicit small_list(size_type n) : size_(0)
+        {
+            reset();
+            fill_init(n, value_type());
+        }
+
+        small_list(size_type n, const T &value) : size_(0)
+        {
+            reset();
+            fill_init(n, value);
+        }
+
+        template <class Iter, typename std::enable_if<cheamstl::is_input_iterator<Iter>::value, int>::type = 0>
+        small_list(Iter first, Iter last) : size_(0)
+        {
+            reset();
+            copy_init(first, last);
+        }
+
+        small_list(std::initializer_list<T> ilist) : size_(0)
+        {
+            reset();
+            copy_init(ilist.begin(), ilist.end());
+        }
+
+        small_list(const small_list &rhs) : size_(0)
+        {
+            reset();
+            copy_init(rhs.begin(), rhs.end());
+        }
+
+        small_list(small_list &&rhs) noexcept(std::is_nothrow_move_constructible<T>::value) : size_(0)
+        {
+            reset();
+            take_nodes(rhs);
+        }
+
+        small_list &operator=(const small_list &rhs)
+        {
+            if (this != &rhs)
+            {
+                clear();
+                copy_init(rhs.begin(), rhs.end());
+            }
+            return *this;
+        }
+
+        small_list &operator=(small_list &&rhs) noexcept(std::is_nothrow_move_constructible<T>::value)
+        {
+            if (this != &rhs)
+            {
+                clear();
+                take_nodes(rhs);
+            }
+            return *this;
+        }
+
+        small_list &operator=(std::initializer_list<T> ilist)
+        {
+            clear();
+            copy_init(ilist.begin(), ilist.end());
+            return *this;
+        }
+
+        ~small_list() { clear(); }
+
+    public:
+        // 迭代器相关操作
+        iterator begin() noexcept { return iterator(head_.next); }
+        const_iterator begin() const noexcept { return const_iterator(head_.next); }
+        iterator end() noexcept { return iterator(node()); }
+        const_iterator end() const noexcept { return const_iterator(node()); }
+
+        reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+        const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+        reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+        const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+
+        const_iterator cbegin() const noexcept { return begin(); }
+        const_iterator cend() const noexcept { return end(); }
+        const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+        const_reverse_iterator crend() const noexcept { return rend(); }
+
+        // 容量相关操作
+        bool empty() const noexcept { return size_ == 0; }
+        size_type size() const noexcept { return size_; }
+        size_type max_size() const noexcept { return static_cast<size_type>(-1); }
+
+        // 访问元素相关操作
+        reference front()
+        {
+            CHEAMSTL_DEBUG(!empty());
+            return *begin();
+        }
+        const_reference front() const
+        {
+            CHEAMSTL_DEBUG(!empty());
+            return *begin();
+        }
+        reference back()
+        {
+            CHEAMSTL_DEBUG(!empty());
+            return *iterator(head_.prev);
+        }
+        const_reference back() const
+        {
+            CHEAMSTL_DEBUG(!empty());
+            return *const_iterator(head_.prev);
+        }
+
+        // assign
+        void assign(size_type n, const value_type &value)
+        {
+            clear();
+            fill_init(n, value);
+        }
+
+        template <class Iter, typename std::enable_if<cheamstl::is_input_iterator<Iter>::value, int>::type = 0>
+        void assign(Iter first, Iter last)
+        {
+            clear();
+            copy_init(first, last);
+        }
+
+        void assign(std::initializer_list<T> ilist) { assign(ilist.begin(), ilist.end()); }
+
+        // emplace_front / emplace_back / emplace
+        template <class... Args>
+        void emplace_front(Args &&...args)
+        {
+            emplace(cbegin(), std::forward<Args>(args)...);
+        }
+
+        template <class... Args>
+        void emplace_back(Args &&...args)
+        {
+            emplace(cend(), std::forward<Args>(args)...);
+        }
+
+        template <class... Args>
+        iterator emplace(const_iterator pos, Args &&...args)
+        {
+            THROW_LENGTH_ERROR_IF(size_ > max_size() - 1, "small_list<T>'s size too big");
+            node_ptr p = create_node(std::forward<Args>(args)...);
+            link_before(pos.node_, p->as_base(), p->as_base());
+            ++size_;
+            return iterator(p);
+        }
+
+        // insert
+        iterator insert(const_iterator pos, const value_type &value) { return emplace(pos, value); }
+        iterator insert(const_iterator pos, value_type &&value) { return emplace(pos, std::move(value)); }
+
+        iterator insert(const_iterator pos, size_type n, const value_type &value)
+        {
+            iterator r(pos.node_);
+            if (n != 0)
+            {
+                r = emplace(pos, value);
+                for (--n; n > 0; --n)
+                    emplace(pos, value);
+            }
+            return r;
+        }
+
+        template <class Iter, typename std::enable_if<cheamstl::is_input_iterator<Iter>::value, int>::type = 0>
+        iterator insert(const_iterator pos, Iter first, Iter last)
+        {
+            iterator r(pos.node_);
+            if (first != last)
+            {
+                r = emplace(pos, *first);
+                for (++first; first != last; ++first)
+                    emplace(pos, *first);
+            }
+            return r;
+        }
+
+        iterator insert(const_iterator pos, std::initializer_list<T> ilist) { return insert(pos, ilist.begin(), ilist.end()); }
+
+        // push_front / push_back
+        void push_front(const value_type &value) { emplace(cbegin(), value); }
+        void push_front(value_type &&value) { emplace(cbegin(), std::move(value)); }
+        void push_back(const value_type &value) { emplace(cend(), value); }
+        void push_back(value_type &&value) { emplace(cend(), std::move(value)); }
+
+        // pop_front / pop_back
+        void pop_front() noexcept
+        {
+            CHEAMSTL_DEBUG(!empty());
+            erase(cbegin());
+        }
+
+        void pop_back() noexcept
+        {
+            CHEAMSTL_DEBUG(!empty());
+            erase(const_iterator(head_.prev));
+        }
+
+        // erase / clear
+        iterator erase(const_iterator pos) noexcept
+        {
+            CHEAMSTL_DEBUG(pos != cend());
+            base_ptr p = pos.node_;
+            base_ptr next = p->next;
+            unlink(p, p);
+            destroy_node(p->as_node());
+            --size_;
+            return iterator(next);
+        }
+
+        iterator erase(const_iterator first, const_iterator last) noexcept
+        {
+            while (first != last)
+                first = erase(first);
+            return iterator(last.node_);
+        }
+
+        void clear() noexcept
+        {
+            base_ptr cur = head_.next;
+            while (cur != node())
+            {
+                base_ptr next = cur->next;
+                destroy_node(cur->as_node());
+                cur = next;
+            }
+            reset();
+        }
+
+        /* 两边的内置元素都要移动，所以借助一个临时对象完成 */
+        void swap(small_list &rhs) noexcept(std::is_nothrow_move_constructible<T>::value)
+        {
+            if (this == &rhs)
+                return;
+            small_list tmp(std::move(rhs));
+            rhs.take_nodes(*this);
+            take_nodes(tmp);
+        }
+
+        // 链表特有的操作
+        void splice(const_iterator pos, small_list &other)
+        {
+            CHEAMSTL_DEBUG(this != &other);
+            transfer(pos, other, other.cbegin(), other.cend());
+        }
+
+        void splice(const_iterator pos, small_list &other, const_iterator it)
+        {
+            if (this == &other)
+            {
+                if (pos.node_ != it.node_ && pos.node_ != it.node_->next)
+                {
+                    unlink(it.node_, it.node_);
+                    link_before(pos.node_, it.node_, it.node_);
+                }
+                return;
+            }
+            const_iterator next = it;
+            transfer(pos, other, it, ++next);
+        }
+
+        void splice(const_iterator pos, small_list &other, const_iterator first, const_iterator last)
+        {
+            if (first == last)
+                return;
+            if (this == &other)
+            {
+                if (pos == last)
+                    return;
+                base_ptr l = last.node_->prev;
+                unlink(first.node_, l);
+                link_before(pos.node_, first.node_, l);
+                return;
+            }
+            transfer(pos, other, first, last);
+        }
+
+        /* 以下操作与 list 相同，只改动 prev/next；merge 从另一个对象取来的内置槽元素需要移动 */
+        size_type unique() { return unique(std::equal_to<T>()); }
+
+        template <class BinaryPredicate>
+        size_type unique(BinaryPredicate pred)
+        {
+            size_type removed = 0;
+            base_ptr i = head_.next;
+            if (i == node())
+                return 0;
+            base_ptr j = i->next;
+            while (j != node())
+            {
+                if (pred(i->as_node()->value, j->as_node()->value))
+                {
+                    base_ptr next = j->next;
+                    erase(const_iterator(j));
+                    ++removed;
+                    j = next;
+                }
+                else
+                {
+                    i = j;
+                    j = j->next;
+                }
+            }
+            return removed;
+        }
+
+        void merge(small_list &other) { merge(other, std::less<T>()); }
+        void merge(small_list &&other) { merge(other, std::less<T>()); }
+        template <class Compare>
+        void merge(small_list &&other, Compare comp) { merge(other, comp); }
+
+        /* 相等的元素 *this 中的排在前面，other 合并后为空。
+         * comp 抛出或新建节点失败时，已经转移的元素留在 *this 中，两边的 size 仍与节点一致 */
+        template <class Compare>
+        void merge(small_list &other, Compare comp)
+        {
+            if (this == &other)
+                return;
+            base_ptr f1 = head_.next;
+            base_ptr e1 = node();
+            while (f1 != e1 && !other.empty())
+            {
+                base_ptr f2 = other.head_.next;
+                if (comp(f2->as_node()->value, f1->as_node()->value))
+                {
+                    base_ptr next = f2->next;
+                    while (next != other.node() && comp(next->as_node()->value, f1->as_node()->value))
+                        next = next->next;
+                    transfer(const_iterator(f1), other, const_iterator(f2), const_iterator(next));
+                }
+                f1 = f1->next;
+            }
+            if (!other.empty())
+                transfer(cend(), other, other.cbegin(), other.cend());
+        }
+
+        void sort() { sort(std::less<T>()); }
+
+        /* 稳定，不申请内存，也不移动元素；comp 抛出时所有节点都会重新接回链表（顺序不确定） */
+        template <class Compared>
+        void sort(Compared comp)
+        {
+            if (size_ < 2)
+                return;
+            base_ptr chain = head_.next;
+            head_.prev->next = nullptr;
+            try
+            {
+                list_type::sort_chain(chain, comp);
+            }
+            catch (...)
+            {
+                relink_chain(chain);
+                throw;
+            }
+            relink_chain(chain);
+        }
+
+        template <class UnaryPredicate>
+        iterator find_if(UnaryPredicate pred)
+        {
+            return iterator(static_cast<const small_list &>(*this).find_if(pred).node_);
+        }
+
+        template <class UnaryPredicate>
+        const_iterator find_if(UnaryPredicate pred) const
+        {
+            base_ptr cur = head_.next;
+            while (cur != node() && !pred(static_cast<const T &>(cur->as_node()->value)))
+                cur = cur->next;
+            return const_iterator(cur);
+        }
+
+        iterator find(const value_type &value)
+        {
+            return find_if([&value](const value_type &v)
+                           { return v == value; });
+        }
+        const_iterator find(const value_type &value) const
+        {
+            return find_if([&value](const value_type &v)
+                           { return v == value; });
+        }
+
+    private:
+        base_ptr node() const noexcept
+        {
+            return const_cast<list_node_base<T> &>(head_).self();
+        }
+
+        /* p 是否是本对象的内置槽 */
+        bool owns(base_ptr p) const noexcept
+        {
+            std::less<const void *> less;
+            const void *q = static_cast<const void *>(p);
+            return !less(q, static_cast<const void *>(slots_)) && less(q, static_cast<const void *>(slots_ + N));
+        }
+
+        void reset() noexcept
+        {
+            head_.unlink();
+            size_ = 0;
+            inline_used_ = 0;
+            inline_free_ = nullptr;
+        }
+
+        // 节点优先取内置槽（先复用释放过的，再用从未用过的），都没有时才向 node_allocator 申请
+        template <class... Args>
+        node_ptr create_node(Args &&...args)
+        {
+            node_ptr p;
+            bool inline_slot = true;
+            if (inline_free_ != nullptr)
+                p = inline_free_->as_node();
+            else if (inline_used_ < N)
+                p = reinterpret_cast<node_ptr>(slots_ + inline_used_);
+            else
+            {
+                p = node_allocator::allocate(1);
+                inline_slot = false;
+            }
+            try
+            {
+                data_allocator::construct(&p->value, std::forward<Args>(args)...);
+            }
+            catch (...)
+            {
+                if (!inline_slot)
+                    node_allocator::deallocate(p);
+                throw;
+            }
+            if (inline_slot)
+            {
+                if (p->as_base() == inline_free_)
+                    inline_free_ = inline_free_->next;
+                else
+                    ++inline_used_;
+            }
+            return p;
+        }
+
+        void destroy_node(node_ptr p) noexcept
+        {
+            data_allocator::destroy(&p->value);
+            if (owns(p->as_base()))
+            {
+                p->next = inline_free_;
+                inline_free_ = p->as_base();
+            }
+            else
+            {
+                node_allocator::deallocate(p);
+            }
+        }
+
+        // 在 pos 之前连接 [first, last]；断开 [first, last]
+        static void link_before(base_ptr pos, base_ptr first, base_ptr last) noexcept
+        {
+            base_ptr prev = pos->prev;
+            prev->next = first;
+            first->prev = prev;
+            last->next = pos;
+            pos->prev = last;
+        }
+
+        static void unlink(base_ptr first, base_ptr last) noexcept
+        {
+            first->prev->next = last->next;
+            last->next->prev = first->prev;
+        }
+
+        // 补上单向链的 prev 指针，并把整条链接回哨兵
+        void relink_chain(base_ptr chain) noexcept
+        {
+            base_ptr prev = node();
+            for (base_ptr cur = chain; cur != nullptr; cur = cur->next)
+            {
+                cur->prev = prev;
+                prev->next = cur;
+                prev = cur;
+            }
+            prev->next = node();
+            head_.prev = prev;
+        }
+
+        /* 把 other 的 [first, last) 逐个移到 pos 之前：堆上的节点直接转移，内置槽中的元素移动到新节点里 */
+        void transfer(const_iterator pos, small_list &other, const_iterator first, const_iterator last)
+        {
+            base_ptr p = first.node_;
+            while (p != last.node_)
+            {
+                base_ptr next = p->next;
+                if (other.owns(p))
+                {
+                    emplace(pos, std::move(p->as_node()->value));
+                    other.unlink(p, p);
+                    other.destroy_node(p->as_node());
+                }
+                else
+                {
+                    THROW_LENGTH_ERROR_IF(size_ > max_size() - 1, "small_list<T>'s size too big");
+                    other.unlink(p, p);
+                    link_before(pos.node_, p, p);
+                    ++size_;
+                }
+                --other.size_;
+                p = next;
+            }
+        }
+
+        void take_nodes(small_list &rhs) noexcept(std::is_nothrow_move_constructible<T>::value)
+        {
+            transfer(cend(), rhs, rhs.cbegin(), rhs.cend());
+        }
+
+        void fill_init(size_type n, const value_type &value)
+        {
+            try
+            {
+                for (; n > 0; --n)
+                    emplace(cend(), value);
+            }
+            catch (...)
+            {
+                clear();
+                throw;
+            }
+        }
+
+        template <class Iter>
+        void copy_init(Iter first, Iter last)
+        {
+            try
+            {
+                for (; first != last; ++first)
+                    emplace(cend(), *first);
+            }
+            catch (...)
+            {
+                clear();
+                throw;
+            }
+        }
+    };
+
+    template <class T, size_t N, class Alloc>
+    void swap(small_list<T, N, Alloc> &lhs, small_list<T, N, Alloc> &rhs) noexcept(noexcept(lhs.swap(rhs)))
+    {
+        lhs.swap(rhs);
+    }
+
+} // namespace cheamstl
+
+#endif // !CHEAMSTL_SMALL_LIST_H_
@@ -0,0 +1,238 @@
+#ifndef CHEAMSTL_THREAD_POOL_H_
+#define CHEAMSTL_THREAD_POOL_H_
+
+/* work_stealing_pool：并行算法使用的工作窃取线程池
+ * 1. 每个工作线程有一个自己的任务队列。工作线程提交的任务放进自己队列的尾部，并从尾部取（后进先出，缓存更热）；
+ *    外部线程提交的任务轮流分给各个队列
+ * 2. 自己的队列空了就从其他线程队列的头部“偷”任务，负载不均时空闲线程会自动分担
+ * 3. parallel_for 的调用者在等待期间也会执行池中的任务，因此在任务里再调用并行算法也不会死锁
+ * 任务都是较粗的块（每块数千个元素），队列用一把互斥锁保护已经足够，不必使用无锁双端队列 */
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cheamstl
+{
+
+    class work_stealing_pool
+    {
+    public:
+        typedef std::function<void()> task_type;
+
+    private:
+        struct task_queue
+        {
+            std::mutex mtx;
+            std::deque<task_type> tasks;
+        };
+
+        /* 当前线程是哪个池的第几个工作线程，外部线程为 nullptr */
+        struct worker_id
+        {
+            work_stealing_pool *pool;
+            size_t index;
+        };
+
+        std::vector<std::unique_ptr<task_queue>> queues_;
+        std::vector<std::thread> threads_;
+        std::atomic<size_t> pending_; // 已提交、尚未被取走的任务数
+        std::atomic<size_t> next_queue_;
+        std::mutex sleep_mtx_;
+        std::condition_variable sleep_cv_;
+        bool stop_;
+
+    public:
+        /* threads 为 0 时使用硬件线程数 */
+        explicit work_stealing_pool(size_t threads = 0) : pending_(0), next_queue_(0), stop_(false)
+        {
+            if (threads == 0)
+                threads = std::thread::hardware_concurrency();
+            if (threads == 0)
+                threads = 1;
+            for (size_t i = 0; i < threads; ++i)
+                queues_.emplace_back(new task_queue);
+            threads_.reserve(threads);
+            for (size_t i = 0; i < threads; ++i)
+                threads_.emplace_back([this, i]()
+                                      { worker_loop(i); });
+        }
+
+        work_stealing_pool(const work_stealing_pool &) = delete;
+        work_stealing_pool &operator=(const work_stealing_pool &) = delete;
+
+        ~work_stealing_pool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(sleep_mtx_);
+                stop_ = true;
+            }
+            sleep_cv_.notify_all();
+            for (auto &t : threads_)
+                t.join();
+        }
+
+        /* 进程内共享的默认线程池，第一次使用时创建 */
+        static work_stealing_pool &instance()
+        {
+            static work_stealing_pool pool;
+            return pool;
+        }
+
+        size_t size() const noexcept { return threads_.size(); }
+
+        void submit(task_type t)
+        {
+            worker_id &self = current();
+            size_t q = self.pool == this ? self.index : next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+            pending_.fetch_add(1, std::memory_order_release);
+            try
+            {
+                std::lock_guard<std::mutex> lock(queues_[q]->mtx);
+                queues_[q]->tasks.push_back(std::move(t));
+            }
+            catch (...)
+            {
+                pending_.fetch_sub(1, std::memory_order_relaxed);
+                throw;
+            }
+            {
+                std::lock_guard<std::mutex> lock(sleep_mtx_);
+            }
+            sleep_cv_.notify_one();
+        }
+
+        /* 取出并执行一个任务，没有任务时返回 false。等待中的线程可以借此帮忙 */
+        bool run_pending_task()
+        {
+            task_type t;
+            worker_id &self = current();
+            if (!take(self.pool == this ? self.index : 0, t))
+                return false;
+            t();
+            return true;
+        }
+
+        /* 对 [0, n) 中的每个 i 执行 f(i)，全部完成后返回；
+         * 任何一个 f 抛出异常时，等其余的任务结束后重新抛出第一个异常。
+         * 提交任务本身失败（bad_alloc）时，剩下的 i 不再执行，同样等已提交的任务结束后才抛出，
+         * 因此无论哪种情况，返回或抛出时都不会再有线程在使用调用者的数据 */
+        template <class F>
+        void parallel_for(size_t n, F f)
+        {
+            if (n == 0)
+                return;
+            if (n == 1)
+            {
+                f(size_t(0));
+                return;
+            }
+            std::atomic<size_t> remaining(n);
+            std::exception_ptr error;
+            std::mutex error_mtx;
+            std::exception_ptr submit_error;
+            for (size_t i = 0; i < n && !submit_error; ++i)
+            {
+                try
+                {
+                    submit([&, i]()
+                           {
+                        try
+                        {
+                            f(i);
+                        }
+                        catch (...)
+                        {
+                            std::lock_guard<std::mutex> lock(error_mtx);
+                            if (!error)
+                                error = std::current_exception();
+                        }
+                        remaining.fetch_sub(1, std::memory_order_acq_rel); });
+                }
+                catch (...)
+                {
+                    submit_error = std::current_exception();
+                    remaining.fetch_sub(n - i, std::memory_order_acq_rel);
+                }
+            }
+            while (remaining.load(std::memory_order_acquire) != 0)
+            {
+                if (!run_pending_task())
+                    std::this_thread::yield();
+            }
+            if (submit_error)
+                std::rethrow_exception(submit_error);
+            if (error)
+                std::rethrow_exception(error);
+        }
+
+    private:
+        static worker_id &current() noexcept
+        {
+            static thread_local worker_id id = {nullptr, 0};
+            return id;
+        }
+
+        /* 先从 home 队列的尾部取，再依次从其他队列的头部偷 */
+        bool take(size_t home, task_type &t)
+        {
+            if (pending_.load(std::memory_order_acquire) == 0)
+                return false;
+            {
+                task_queue &q = *queues_[home];
+                std::lock_guard<std::mutex> lock(q.mtx);
+                if (!q.tasks.empty())
+                {
+                    t = std::move(q.tasks.back());
+                    q.tasks.pop_back();
+                    pending_.fetch_sub(1, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+            for (size_t k = 1; k < queues_.size(); ++k)
+            {
+                task_queue &q = *queues_[(home + k) % queues_.size()];
+                std::lock_guard<std::mutex> lock(q.mtx);
+                if (!q.tasks.empty())
+                {
+                    t = std::move(q.tasks.front());
+                    q.tasks.pop_front();
+                    pending_.fetch_sub(1, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void worker_loop(size_t index)
+        {
+            current() = worker_id{this, index};
+            task_type t;
+            for (;;)
+            {
+                if (take(index, t))
+                {
+                    t();
+                    t = nullptr;
+                    continue;
+                }
+                std::unique_lock<std::mutex> lock(sleep_mtx_);
+                sleep_cv_.wait(lock, [this]()
+                               { return stop_ || pending_.load(std::memory_order_acquire) != 0; });
+                if (stop_ && pending_.load(std::memory_order_acquire) == 0)
+                    return;
+            }
+        }
+    };
+
+} // namespace cheamstl
+
+#endif // !CHEAMSTL_THREAD_POOL_H_
@@ -0,0 +1,643 @@
+#ifndef CHEAMSTL_UNROLLED_LIST_H_
+#define CHEAMSTL_UNROLLED_LIST_H_
+
+/* unrolled_list：展开链表
+ * list 的每个元素都有一个独立的节点（两个指针 + 分配器开销），遍历时每个元素一次 cache miss。
+ * 展开链表的每个节点保存一个容量为 N 的小数组，节点之间仍用 list_node_base 的 prev/next 串起来：
+ * 1. 遍历时大部分 ++ 只是数组下标加一，相邻元素在同一条 cache line 上
+ * 2. 每个元素分摊到的指针开销只有 2 * sizeof(void*) / N
+ * 3. 中间插入 / 删除最多移动一个节点内的 N 个元素，节点满了就一分为二，过空就与后继合并
+ *
+ * 迭代器失效规则（与 list 不同）：
+ * insert 使插入位置所在节点（分裂时还包括新节点）内的所有迭代器失效；
+ * erase 使被删除位置所在节点及其后继节点内的迭代器失效；其他节点上的迭代器保持有效 */
+
+#include <cstddef>
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "allocator.h"
+#include "exceptdef.h"
+#include "iterator.h"
+#include "list.h"
+
+namespace cheamstl
+{
+
+    /* 默认容量：让一个节点大约占 256 字节，但至少放 4 个元素 */
+    template <class T>
+    struct unrolled_list_capacity
+    {
+        static constexpr size_t bytes = 256 - 2 * sizeof(void *) - sizeof(size_t);
+        static constexpr size_t value = bytes / sizeof(T) < 4 ? 4 : bytes / sizeof(T);
+    };
+
+    /* 节点：继承 list_node_base，复用它的 prev/next 与 unlink() */
+    template <class T, size_t N>
+    struct unrolled_node : public list_node_base<T>
+    {
+        typedef typename list_node_base<T>::base_ptr base_ptr;
+
+        size_t count; // 当前节点中的元素个数
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type data[N];
+
+        T *elems() noexcept { return reinterpret_cast<T *>(data); }
+
+        static unrolled_node *from(base_ptr p) noexcept { return static_cast<unrolled_node *>(p); }
+    };
+
+    template <class T, size_t N, bool IsConst>
+    struct unrolled_list_iterator
+    {
+        typedef cheamstl::bidirectional_iterator_tag iterator_category;
+        typedef ptrdiff_t difference_type;
+        typedef T value_type;
+        typedef typename std::conditional<IsConst, const T *, T *>::type pointer;
+        typedef typename std::conditional<IsConst, const T &, T &>::type reference;
+        typedef typename list_node_base<T>::base_ptr base_ptr;
+        typedef unrolled_node<T, N> node_type;
+        typedef unrolled_list_iterator self;
+
+        base_ptr node_; // 所在节点，end() 时为哨兵
+        size_t idx_;    // 节点内的下标
+
+        unrolled_list_iterator() = default;
+        unrolled_list_iterator(base_ptr x, size_t i) : node_(x), idx_(i) {}
+        /* 普通迭代器可以隐式转换成常量迭代器 */
+        template <bool C, typename std::enable_if<IsConst && !C, int>::type = 0>
+        unrolled_list_iterator(const unrolled_list_iterator<T, N, C> &rhs) : node_(rhs.node_), idx_(rhs.idx_) {}
+
+        reference operator*() const { return node_type::from(node_)->elems()[idx_]; }
+        pointer operator->() const { return &(operator*()); }
+
+        self &operator++()
+        {
+            if (++idx_ == node_type::from(node_)->count)
+            {
+                node_ = node_->next;
+                idx_ = 0;
+            }
+            return *this;
+        }
+        self operator++(int)
+        {
+            self tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        self &operator--()
+        {
+            if (idx_ == 0)
+            {
+                node_ = node_->prev;
+                idx_ = node_type::from(node_)->count;
+            }
+            --idx_;
+            return *this;
+        }
+        self operator--(int)
+        {
+            self tmp = *this;
+            --*this;
+            return tmp;
+        }
+
+        bool operator==(const self &rhs) const { return node_ == rhs.node_ && idx_ == rhs.idx_; }
+        bool operator!=(const self &rhs) const { return !(*this == rhs); }
+    };
+
+    template <class T, size_t N = unrolled_list_capacity<T>::value>
+    class unrolled_list
+    {
+        static_assert(N >= 2, "unrolled_list needs at least two slots per node");
+
+    public:
+        typedef cheamstl::allocator<T> allocator_type;
+        typedef cheamstl::allocator<T> data_allocator;
+        typedef unrolled_node<T, N> node_type;
+        typedef cheamstl::pool_allocator<node_type> node_allocator;
+
+        typedef T value_type;
+        typedef T *pointer;
+        typedef const T *const_pointer;
+        typedef T &reference;
+        typedef const T &const_reference;
+        typedef size_t size_type;
+        typedef ptrdiff_t difference_type;
+
+        typedef unrolled_list_iterator<T, N, false> iterator;
+        typedef unrolled_list_iterator<T, N, true> const_iterator;
+        typedef cheamstl::reverse_iterator<iterator> reverse_iterator;
+        typedef cheamstl::reverse_iterator<const_iterator> const_reverse_iterator;
+
+        typedef typename list_node_base<T>::base_ptr base_ptr;
+
+        static constexpr size_type node_capacity = N;
+
+    private:
+        list_node_base<T> head_; // 内置哨兵
+        size_type size_;
+
+    public:
+        unrolled_list() noexcept : size_(0) { head_.unlink(); }
+
+        explicit unrolled_list(size_type n) : size_(0)
+        {
+            head_.unlink();
+            fill_init(n, value_type());
+        }
+
+        unrolled_list(size_type n, const T &value) : size_(0)
+        {
+            head_.unlink();
+            fill_init(n, value);
+        }
+
+        template <class Iter, typename std::enable_if<cheamstl::is_input_iterator<Iter>::value, int>::type = 0>
+        unrolled_list(Iter first, Iter last) : size_(0)
+        {
+            head_.unlink();
+            copy_init(first, last);
+        }
+
+        unrolled_list(std::initializer_list<T> ilist) : size_(0)
+        {
+            head_.unlink();
+            copy_init(ilist.begin(), ilist.end());
+        }
+
+        unrolled_list(const unrolled_list &rhs) : size_(0)
+        {
+            head_.unlink();
+            copy_init(rhs.begin(), rhs.end());
+        }
+
+        unrolled_list(unrolled_list &&rhs) noexcept : size_(0)
+        {
+            head_.unlink();
+            take_nodes(rhs);
+        }
+
+        unrolled_list &operator=(const unrolled_list &rhs)
+        {
+            if (this != &rhs)
+            {
+                unrolled_list tmp(rhs);
+                swap(tmp);
+            }
+            return *this;
+        }
+
+        unrolled_list &operator=(unrolled_list &&rhs) noexcept
+        {
+            if (this != &rhs)
+            {
+                clear();
+                take_nodes(rhs);
+            }
+            return *this;
+        }
+
+        unrolled_list &operator=(std::initializer_list<T> ilist)
+        {
+            unrolled_list tmp(ilist);
+            swap(tmp);
+            return *this;
+        }
+
+        ~unrolled_list() { clear(); }
+
+    public:
+        // 迭代器相关操作
+        iterator begin() noexcept { return iterator(node()->next, 0); }
+        const_iterator begin() const noexcept { return const_iterator(node()->next, 0); }
+        iterator end() noexcept { return iterator(node(), 0); }
+        const_iterator end() const noexcept { return const_iterator(node(), 0); }
+
+        reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+        const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+        reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+        const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+
+        const_iterator cbegin() const noexcept { return begin(); }
+        const_iterator cend() const noexcept { return end(); }
+        const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+        const_reverse_iterator crend() const noexcept { return rend(); }
+
+        // 容量相关操作
+        bool empty() const noexcept { return size_ == 0; }
+        size_type size() const noexcept { return size_; }
+        size_type max_size() const noexcept { return static_cast<size_type>(-1); }
+
+        // 访问元素相关操作
+        reference front()
+        {
+            CHEAMSTL_DEBUG(!empty());
+            return *begin();
+        }
+        const_reference front() const
+        {
+            CHEAMSTL_DEBUG(!empty());
+            return *begin();
+        }
+        reference back()
+        {
+            CHEAMSTL_DEBUG(!empty());
+            auto n = node_type::from(head_.prev);
+            return n->elems()[n->count - 1];
+        }
+        const_reference back() const
+        {
+            CHEAMSTL_DEBUG(!empty());
+            auto n = node_type::from(head_.prev);
+            return n->elems()[n->count - 1];
+        }
+
+        // 插入 / 删除
+        iterator insert(const_iterator pos, const value_type &value) { return emplace_at(pos, value); }
+        iterator insert(const_iterator pos, value_type &&value) { return emplace_at(pos, std::move(value)); }
+
+        void push_back(const value_type &value) { emplace_back_impl(value); }
+        void push_back(value_type &&value) { emplace_back_impl(std::move(value)); }
+
+        void push_front(const value_type &value) { emplace_at(cbegin(), value); }
+        void push_front(value_type &&value) { emplace_at(cbegin(), std::move(value)); }
+
+        void pop_front() noexcept
+        {
+            CHEAMSTL_DEBUG(!empty());
+            erase(cbegin());
+        }
+
+        void pop_back() noexcept
+        {
+            CHEAMSTL_DEBUG(!empty());
+            auto n = node_type::from(head_.prev);
+            data_allocator::destroy(n->elems() + --n->count);
+            --size_;
+            if (n->count == 0)
+                free_node(n);
+        }
+
+        iterator erase(const_iterator pos);
+        iterator erase(const_iterator first, const_iterator last);
+
+        void clear() noexcept;
+
+        void swap(unrolled_list &rhs) noexcept
+        {
+            if (this == &rhs)
+                return;
+            unrolled_list tmp(std::move(rhs));
+            rhs.take_nodes(*this);
+            take_nodes(tmp);
+        }
+
+        // 链表特有的操作
+        void splice(const_iterator pos, unrolled_list &other);
+        void splice(const_iterator pos, unrolled_list &other, const_iterator it);
+        void splice(const_iterator pos, unrolled_list &other, const_iterator first, const_iterator last);
+
+    private:
+        base_ptr node() const noexcept
+        {
+            return const_cast<list_node_base<T> &>(head_).self();
+        }
+
+        node_type *new_node_before(base_ptr pos);
+        void free_node(node_type *n) noexcept;
+        node_type *split_node(node_type *n, size_type at);
+        iterator erase_in_node(const_iterator pos) noexcept;
+
+        template <class... Args>
+        void emplace_back_impl(Args &&...args);
+        template <class... Args>
+        iterator emplace_at(const_iterator pos, Args &&...args);
+
+        void fill_init(size_type n, const value_type &value);
+        template <class Iter>
+        void copy_init(Iter first, Iter last);
+
+        void take_nodes(unrolled_list &rhs) noexcept;
+    };
+
+    /*****************************************************************************************/
+
+    // 在 pos 之前链接一个新的空节点
+    template <class T, size_t N>
+    typename unrolled_list<T, N>::node_type *unrolled_list<T, N>::new_node_before(base_ptr pos)
+    {
+        node_type *n = node_allocator::allocate(1);
+        n->count = 0;
+        n->next = pos;
+        n->prev = pos->prev;
+        pos->prev->next = n;
+        pos->prev = n;
+        return n;
+    }
+
+    // 断开并释放一个已经没有元素的节点
+    template <class T, size_t N>
+    void unrolled_list<T, N>::free_node(node_type *n) noexcept
+    {
+        n->prev->next = n->next;
+        n->next->prev = n->prev;
+        node_allocator::deallocate(n);
+    }
+
+    // 把 n 中 [at, count) 的元素移到紧随其后的新节点中，返回新节点
+    template <class T, size_t N>
+    typename unrolled_list<T, N>::node_type *unrolled_list<T, N>::split_node(node_type *n, size_type at)
+    {
+        node_type *m = new_node_before(n->next);
+        T *src = n->elems();
+        T *dst = m->elems();
+        for (size_type i = at; i < n->count; ++i)
+        {
+            data_allocator::construct(dst + m->count, std::move(src[i]));
+            ++m->count;
+            data_allocator::destroy(src + i);
+        }
+        n->count = at;
+        return m;
+    }
+
+    template <class T, size_t N>
+    template <class... Args>
+    void unrolled_list<T, N>::emplace_back_impl(Args &&...args)
+    {
+        THROW_LENGTH_ERROR_IF(size_ > max_size() - 1, "unrolled_list<T>'s size too big");
+        node_type *n = node_type::from(head_.prev);
+        bool fresh = false;
+        if (head_.prev == node() || n->count == N)
+        {
+            n = new_node_before(node());
+            fresh = true;
+        }
+        try
+        {
+            data_allocator::construct(n->elems() + n->count, std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            if (fresh)
+                free_node(n);
+            throw;
+        }
+        ++n->count;
+        ++size_;
+    }
+
+    // 在 pos 处构造元素：节点未满时在节点内后移元素，已满时先一分为二
+    template <class T, size_t N>
+    template <class... Args>
+    typename unrolled_list<T, N>::iterator
+    unrolled_list<T, N>::emplace_at(const_iterator pos, Args &&...args)
+    {
+        THROW_LENGTH_ERROR_IF(size_ > max_size() - 1, "unrolled_list<T>'s size too big");
+        /* 参数可能引用链表中的元素，后移元素之前先构造一个临时对象 */
+        value_type tmp(std::forward<Args>(args)...);
+
+        base_ptr p = pos.node_;
+        size_type idx = pos.idx_;
+        if (p == node())
+        {
+            /* end()：追加到最后一个节点，满了就新开一个 */
+            emplace_back_impl(std::move(tmp));
+            node_type *last = node_type::from(head_.prev);
+            return iterator(last, last->count - 1);
+        }
+
+        node_type *n = node_type::from(p);
+        if (idx == 0 && n->prev != node() && node_type::from(n->prev)->count < N)
+        {
+            /* 插在节点开头，而前一个节点还有空位：直接追加到前一个节点末尾，不用移动任何元素 */
+            node_type *prev = node_type::from(n->prev);
+            data_allocator::construct(prev->elems() + prev->count, std::move(tmp));
+            ++size_;
+            return iterator(prev, prev->count++);
+        }
+        if (n->count == N)
+        {
+            node_type *m = split_node(n, N / 2);
+            if (idx > N / 2)
+            {
+                n = m;
+                idx -= N / 2;
+            }
+        }
+
+        T *e = n->elems();
+        if (idx == n->count)
+        {
+            data_allocator::construct(e + idx, std::move(tmp));
+        }
+        else
+        {
+            data_allocator::construct(e + n->count, std::move(e[n->count - 1]));
+            for (size_type i = n->count - 1; i > idx; --i)
+                e[i] = std::move(e[i - 1]);
+            e[idx] = std::move(tmp);
+        }
+        ++n->count;
+        ++size_;
+        return iterator(n, idx);
+    }
+
+    // 删除 pos 处的元素但不合并节点：只有同一节点内 pos 之后的迭代器失效
+    template <class T, size_t N>
+    typename unrolled_list<T, N>::iterator unrolled_list<T, N>::erase_in_node(const_iterator pos) noexcept
+    {
+        node_type *n = node_type::from(pos.node_);
+        size_type idx = pos.idx_;
+        T *e = n->elems();
+        for (size_type i = idx; i + 1 < n->count; ++i)
+            e[i] = std::move(e[i + 1]);
+        data_allocator::destroy(e + --n->count);
+        --size_;
+
+        if (n->count == 0)
+        {
+            base_ptr next = n->next;
+            free_node(n);
+            return iterator(next, 0);
+        }
+        if (idx < n->count)
+            return iterator(n, idx);
+        return iterator(n->next, 0);
+    }
+
+    // 删除 pos 处的元素，节点过空时把后继节点合并进来
+    template <class T, size_t N>
+    typename unrolled_list<T, N>::iterator unrolled_list<T, N>::erase(const_iterator pos)
+    {
+        CHEAMSTL_DEBUG(pos != cend());
+        node_type *n = node_type::from(pos.node_);
+        if (n->count == 1)
+            return erase_in_node(pos); // 节点被整个释放，无需合并
+        erase_in_node(pos);
+        if (n->count < N / 4 && n->next != node())
+        {
+            node_type *m = node_type::from(n->next);
+            if (n->count + m->count <= N)
+            {
+                T *e = n->elems();
+                T *src = m->elems();
+                for (size_type i = 0; i < m->count; ++i)
+                {
+                    data_allocator::construct(e + n->count, std::move(src[i]));
+                    ++n->count;
+                    data_allocator::destroy(src + i);
+                }
+                m->count = 0;
+                free_node(m);
+            }
+        }
+        if (pos.idx_ < n->count)
+            return iterator(n, pos.idx_);
+        return iterator(n->next, 0);
+    }
+
+    // 删除 [first, last) 内的元素
+    template <class T, size_t N>
+    typename unrolled_list<T, N>::iterator
+    unrolled_list<T, N>::erase(const_iterator first, const_iterator last)
+    {
+        /* 合并节点会使 last 失效，所以先数出个数再逐个删除 */
+        size_type n = static_cast<size_type>(cheamstl::distance(first, last));
+        iterator it(first.node_, first.idx_);
+        for (; n > 0; --n)
+            it = erase(it);
+        return it;
+    }
+
+    template <class T, size_t N>
+    void unrolled_list<T, N>::clear() noexcept
+    {
+        base_ptr cur = head_.next;
+        while (cur != node())
+        {
+            node_type *n = node_type::from(cur);
+            cur = cur->next;
+            data_allocator::destroy(n->elems(), n->elems() + n->count);
+            node_allocator::deallocate(n);
+        }
+        head_.unlink();
+        size_ = 0;
+    }
+
+    // 将 other 整体接合于 pos 之前：pos 在节点中间时先把节点拆开，之后只是改指针
+    template <class T, size_t N>
+    void unrolled_list<T, N>::splice(const_iterator pos, unrolled_list &other)
+    {
+        CHEAMSTL_DEBUG(this != &other);
+        if (other.empty())
+            return;
+        THROW_LENGTH_ERROR_IF(size_ > max_size() - other.size_, "unrolled_list<T>'s size too big");
+        base_ptr p = pos.node_;
+        if (pos.idx_ != 0)
+            p = split_node(node_type::from(p), pos.idx_);
+
+        base_ptr f = other.head_.next;
+        base_ptr l = other.head_.prev;
+        other.head_.unlink();
+        p->prev->next = f;
+        f->prev = p->prev;
+        p->prev = l;
+        l->next = p;
+
+        size_ += other.size_;
+        other.size_ = 0;
+    }
+
+    // 将 it 所指的元素移动到 pos 之前
+    template <class T, size_t N>
+    void unrolled_list<T, N>::splice(const_iterator pos, unrolled_list &other, const_iterator it)
+    {
+        if (pos == it)
+            return;
+        const_iterator next = it;
+        splice(pos, other, it, ++next);
+    }
+
+    /* 将 other 的 [first, last) 移动到 pos 之前：元素逐个移入一个临时链表，再整体接合。
+     * 移出时使用不合并节点的 erase_in_node，这样同一个链表内部移动时 pos 只需要修正下标 */
+    template <class T, size_t N>
+    void unrolled_list<T, N>::splice(const_iterator pos, unrolled_list &other, const_iterator first,
+                                     const_iterator last)
+    {
+        if (first == last)
+            return;
+        size_type k = static_cast<size_type>(cheamstl::distance(first, last));
+        unrolled_list tmp;
+        const_iterator cur = first;
+        for (; k > 0; --k)
+        {
+            tmp.push_back(std::move(const_cast<reference>(*cur)));
+            if (this == &other && pos.node_ == cur.node_ && pos.idx_ > cur.idx_)
+                --pos.idx_;
+            cur = other.erase_in_node(cur);
+        }
+        splice(pos, tmp);
+    }
+
+    /*****************************************************************************************/
+    // helper function
+
+    template <class T, size_t N>
+    void unrolled_list<T, N>::fill_init(size_type n, const value_type &value)
+    {
+        try
+        {
+            for (; n > 0; --n)
+                emplace_back_impl(value);
+        }
+        catch (...)
+        {
+            clear();
+            throw;
+        }
+    }
+
+    template <class T, size_t N>
+    template <class Iter>
+    void unrolled_list<T, N>::copy_init(Iter first, Iter last)
+    {
+        try
+        {
+            for (; first != last; ++first)
+                emplace_back_impl(*first);
+        }
+        catch (...)
+        {
+            clear();
+            throw;
+        }
+    }
+
+    template <class T, size_t N>
+    void unrolled_list<T, N>::take_nodes(unrolled_list &rhs) noexcept
+    {
+        if (rhs.empty())
+            return;
+        head_.next = rhs.head_.next;
+        head_.prev = rhs.head_.prev;
+        head_.next->prev = node();
+        head_.prev->next = node();
+        size_ = rhs.size_;
+        rhs.head_.unlink();
+        rhs.size_ = 0;
+    }
+
+    template <class T, size_t N>
+    void swap(unrolled_list<T, N> &lhs, unrolled_list<T, N> &rhs) noexcept
+    {
+        lhs.swap(rhs);
+    }
+
+} // namespace cheamstl
+
+#endif // !CHEAMSTL_UNROLLED_LIST_H_
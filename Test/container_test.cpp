@@ -0,0 +1,1451 @@
+/* 容器的行为检查：覆盖链表类容器中容易出错的边界情况
+ *
+ * 编译（Linux）：g++ -O1 -g -std=c++11 -pthread -fsanitize=address,undefined Test/container_test.cpp -o container_test
+ * 运行：./container_test，全部通过时输出 "all checks passed" 并返回 0，否则逐条打印失败的检查并返回 1 */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <list>
+#include <new>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "../CheamSTL/algorithm.h"
+#include "../CheamSTL/allocator.h"
+#include "../CheamSTL/compact_list.h"
+#include "../CheamSTL/list.h"
+#include "../CheamSTL/persistent_list.h"
+#include "../CheamSTL/small_list.h"
+#include "../CheamSTL/unrolled_list.h"
+
+namespace
+{
+    /* operator new 的计数与故障注入：fail_after 为 n 时，再成功 n 次之后的申请抛出 bad_alloc，-1 表示不注入。
+     * 线程池的工作线程也会经过这里，所以都用原子变量 */
+    std::atomic<long> live_news(0);
+    std::atomic<long> fail_after(-1);
+}
+
+void *operator new(size_t n)
+{
+    long left = fail_after.load(std::memory_order_relaxed);
+    while (left > 0 && !fail_after.compare_exchange_weak(left, left - 1, std::memory_order_relaxed))
+    {
+    }
+    if (left == 0)
+        throw std::bad_alloc();
+    if (void *p = std::malloc(n ? n : 1))
+    {
+        ++live_news;
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+/* std::stable_sort 等用 nothrow 版本申请临时缓冲区，释放时走的仍是上面那个 operator delete */
+void *operator new(size_t n, const std::nothrow_t &) noexcept
+{
+    try
+    {
+        return ::operator new(n);
+    }
+    catch (const std::bad_alloc &)
+    {
+        return nullptr;
+    }
+}
+
+void operator delete(void *p) noexcept
+{
+    if (p != nullptr)
+        --live_news;
+    std::free(p);
+}
+
+namespace
+{
+
+    int failures = 0;
+
+#define CHECK(expr)                                                              \
+    do                                                                           \
+    {                                                                            \
+        if (!(expr))                                                             \
+        {                                                                        \
+            std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #expr); \
+            ++failures;                                                          \
+        }                                                                        \
+    } while (0)
+
+    template <class Container>
+    std::vector<int> to_vector(const Container &c)
+    {
+        return std::vector<int>(c.begin(), c.end());
+    }
+
+    /* IndexT 与 size_t 一样宽时，计算扩容上限不能回绕成 0 */
+    template <class IndexT>
+    void test_compact_list_index()
+    {
+        cheamstl::compact_list<int, IndexT> l;
+        CHECK(l.max_size() > 0);
+        for (int i = 0; i < 1000; ++i)
+            l.push_back(i);
+        CHECK(l.size() == 1000);
+        CHECK(l.front() == 0 && l.back() == 999);
+        l.erase(l.begin());
+        l.push_front(-1);
+        CHECK(l.front() == -1);
+        CHECK(l.capacity() >= l.size());
+
+        cheamstl::compact_list<int, IndexT> r;
+        r.reserve(10);
+        CHECK(r.capacity() >= 10);
+    }
+
+    void test_compact_list()
+    {
+        test_compact_list_index<uint16_t>();
+        test_compact_list_index<uint32_t>();
+        test_compact_list_index<uint64_t>();
+        test_compact_list_index<size_t>();
+
+        /* 16 位下标的容量上限 */
+        cheamstl::compact_list<int, uint16_t> small;
+        for (int i = 0; i < 65535; ++i)
+            small.push_back(i);
+        bool thrown = false;
+        try
+        {
+            small.push_back(0);
+        }
+        catch (const std::length_error &)
+        {
+            thrown = true;
+        }
+        CHECK(thrown);
+        CHECK(small.size() == 65535);
+    }
+
+    /* 每个节点都非空且不超过容量，元素个数与 size() 一致 */
+    template <class T, size_t N>
+    bool unrolled_well_formed(const cheamstl::unrolled_list<T, N> &l)
+    {
+        typedef typename cheamstl::unrolled_list<T, N>::node_type node_type;
+        size_t total = 0;
+        for (auto p = l.begin().node_; p != l.end().node_; p = p->next)
+        {
+            size_t count = node_type::from(p)->count;
+            if (count == 0 || count > N)
+                return false;
+            total += count;
+        }
+        return total == l.size();
+    }
+
+    template <class T, size_t N>
+    size_t unrolled_node_count(const cheamstl::unrolled_list<T, N> &l)
+    {
+        size_t nodes = 0;
+        for (auto p = l.begin().node_; p != l.end().node_; p = p->next)
+            ++nodes;
+        return nodes;
+    }
+
+    std::vector<int> iota_vector(int first, int last)
+    {
+        std::vector<int> v;
+        for (int i = first; i < last; ++i)
+            v.push_back(i);
+        return v;
+    }
+
+    /* 节点容量取 8：插入满节点会分裂，删到少于 N / 4 个元素会与后继合并 */
+    void test_unrolled_list()
+    {
+        typedef cheamstl::unrolled_list<int, 8> ulist;
+
+        /* 在满节点的中间、开头和末尾插入：节点一分为二，顺序不变 */
+        {
+            ulist l;
+            for (int i = 0; i < 8; ++i)
+                l.push_back(i * 10);
+            std::vector<int> expect = to_vector(l);
+            auto it = l.begin();
+            for (int i = 0; i < 3; ++i)
+                ++it;
+            it = l.insert(it, 25);
+            CHECK(*it == 25);
+            expect.insert(expect.begin() + 3, 25);
+            l.insert(l.begin(), -1);
+            expect.insert(expect.begin(), -1);
+            l.insert(l.end(), 99);
+            expect.push_back(99);
+            CHECK(to_vector(l) == expect);
+            CHECK(unrolled_well_formed(l));
+            std::vector<int> backward;
+            for (auto r = l.rbegin(); r != l.rend(); ++r)
+                backward.push_back(*r);
+            CHECK(std::vector<int>(expect.rbegin(), expect.rend()) == backward);
+        }
+
+        /* 把第一个节点删到只剩一个元素：后继（4 个元素）合并进来，返回的迭代器指向下一个元素 */
+        {
+            std::vector<int> v = iota_vector(0, 12);
+            ulist l(v.begin(), v.end());
+            CHECK(unrolled_node_count(l) == 2);
+            auto it = l.begin();
+            for (int i = 0; i < 6; ++i)
+                it = l.erase(it);
+            CHECK(*it == 6);
+            it = l.erase(it);
+            CHECK(*it == 7);
+            CHECK(to_vector(l) == iota_vector(7, 12));
+            CHECK(unrolled_node_count(l) == 1);
+            CHECK(unrolled_well_formed(l));
+        }
+
+        /* 跨越多个节点的区间删除 */
+        {
+            std::vector<int> v = iota_vector(0, 40);
+            ulist l(v.begin(), v.end());
+            auto first = l.begin();
+            auto last = l.begin();
+            for (int i = 0; i < 5; ++i)
+                ++first;
+            for (int i = 0; i < 29; ++i)
+                ++last;
+            auto it = l.erase(first, last);
+            CHECK(it != l.end() && *it == 29);
+            v.erase(v.begin() + 5, v.begin() + 29);
+            CHECK(to_vector(l) == v);
+            CHECK(unrolled_well_formed(l));
+            l.erase(l.begin(), l.end());
+            CHECK(l.empty() && l.begin() == l.end());
+        }
+
+        /* splice：整体接到节点中间、单个元素、同一链表内的区间 */
+        {
+            std::vector<int> va = iota_vector(0, 12);
+            std::vector<int> vb = iota_vector(100, 120);
+            ulist a(va.begin(), va.end());
+            ulist b(vb.begin(), vb.end());
+            std::list<int> ma(va.begin(), va.end());
+            std::list<int> mb(vb.begin(), vb.end());
+
+            auto pos = a.begin();
+            auto mpos = ma.begin();
+            for (int i = 0; i < 3; ++i, ++pos, ++mpos)
+            {
+            }
+            a.splice(pos, b);
+            ma.splice(mpos, mb);
+            CHECK(b.empty() && a.size() == 32);
+            CHECK(to_vector(a) == std::vector<int>(ma.begin(), ma.end()));
+            CHECK(unrolled_well_formed(a) && unrolled_well_formed(b));
+
+            b.splice(b.end(), a, a.begin());
+            mb.splice(mb.end(), ma, ma.begin());
+            CHECK(to_vector(b) == std::vector<int>(mb.begin(), mb.end()));
+
+            /* 把 [10, 20) 移到第 25 个元素之前 */
+            auto first = a.begin(), last = a.begin(), to = a.begin();
+            auto mfirst = ma.begin(), mlast = ma.begin(), mto = ma.begin();
+            for (int i = 0; i < 10; ++i, ++first, ++mfirst)
+            {
+            }
+            for (int i = 0; i < 20; ++i, ++last, ++mlast)
+            {
+            }
+            for (int i = 0; i < 25; ++i, ++to, ++mto)
+            {
+            }
+            a.splice(to, a, first, last);
+            ma.splice(mto, ma, mfirst, mlast);
+            CHECK(to_vector(a) == std::vector<int>(ma.begin(), ma.end()));
+            CHECK(unrolled_well_formed(a));
+        }
+
+        /* 随机操作与 std::list 对照 */
+        {
+            ulist l;
+            std::list<int> model;
+            std::mt19937 rng(5);
+            for (int step = 0; step < 20000; ++step)
+            {
+                size_t at = model.empty() ? 0 : rng() % (model.size() + 1);
+                auto it = l.begin();
+                auto mit = model.begin();
+                for (size_t i = 0; i < at; ++i, ++it, ++mit)
+                {
+                }
+                if (rng() % 3 != 0 || model.empty() || mit == model.end())
+                {
+                    l.insert(it, step);
+                    model.insert(mit, step);
+                }
+                else
+                {
+                    l.erase(it);
+                    model.erase(mit);
+                }
+                if (model.size() > 200)
+                {
+                    l.erase(l.begin(), l.end());
+                    model.clear();
+                }
+            }
+            CHECK(to_vector(l) == std::vector<int>(model.begin(), model.end()));
+            CHECK(unrolled_well_formed(l));
+        }
+    }
+
+    /* allocate_chain 中途失败时，已经申请的块要全部还回去。
+     * 对齐要求超过指针的类型不走线程缓存，每块都直接来自 ::operator new */
+    struct alignas(32) over_aligned
+    {
+        char bytes[64];
+    };
+
+    void test_allocate_chain_failure()
+    {
+        long before = live_news;
+        fail_after = 5;
+        bool thrown = false;
+        try
+        {
+            cheamstl::thread_cache_allocator<over_aligned>::allocate_chain(10);
+        }
+        catch (const std::bad_alloc &)
+        {
+            thrown = true;
+        }
+        fail_after = -1;
+        CHECK(thrown);
+        CHECK(live_news == before);
+
+        fail_after = 5;
+        thrown = false;
+        try
+        {
+            cheamstl::allocator<over_aligned>::allocate_chain(10);
+        }
+        catch (const std::bad_alloc &)
+        {
+            thrown = true;
+        }
+        fail_after = -1;
+        CHECK(thrown);
+        CHECK(live_news == before);
+    }
+
+    /* 并行算法的迭代器区间版本要走两遍区间，单趟迭代器不应该匹配 */
+    template <class Iter, class = void>
+    struct par_for_each_accepts : std::false_type
+    {
+    };
+
+    template <class Iter>
+    struct par_for_each_accepts<Iter, decltype(cheamstl::for_each(cheamstl::execution::par, std::declval<Iter>(),
+                                                                  std::declval<Iter>(), std::declval<void (*)(int)>()))>
+        : std::true_type
+    {
+    };
+
+    template <class InIter, class OutIter, class = void>
+    struct par_transform_accepts : std::false_type
+    {
+    };
+
+    template <class InIter, class OutIter>
+    struct par_transform_accepts<InIter, OutIter,
+                                 decltype((void)cheamstl::transform(cheamstl::execution::par, std::declval<InIter>(),
+                                                                    std::declval<InIter>(), std::declval<OutIter>(),
+                                                                    std::declval<int (*)(int)>()))> : std::true_type
+    {
+    };
+
+    int twice(int x) { return 2 * x; }
+
+    void test_parallel_algorithms()
+    {
+        typedef std::istream_iterator<int> in_iter;
+        typedef std::ostream_iterator<int> out_iter;
+        typedef cheamstl::list<int>::iterator list_iter;
+        static_assert(par_for_each_accepts<list_iter>::value, "forward iterators use the parallel overload");
+        static_assert(!par_for_each_accepts<in_iter>::value, "single-pass iterators must not be split");
+        static_assert(par_transform_accepts<list_iter, std::vector<int>::iterator>::value, "");
+        static_assert(!par_transform_accepts<in_iter, std::vector<int>::iterator>::value, "");
+        static_assert(!par_transform_accepts<list_iter, out_iter>::value, "the output range is split too");
+        static_assert(!par_transform_accepts<list_iter, std::back_insert_iterator<std::vector<int>>>::value, "");
+
+        std::vector<int> v = iota_vector(0, 50000);
+        cheamstl::list<int> l(v.begin(), v.end());
+        std::vector<int> out(l.size());
+        cheamstl::transform(cheamstl::execution::par, l.begin(), l.end(), out.begin(), twice);
+        bool ok = true;
+        for (size_t i = 0; i < out.size(); ++i)
+            ok = ok && out[i] == 2 * v[i];
+        CHECK(ok);
+        CHECK(cheamstl::count_if(cheamstl::execution::par, l.begin(), l.end(), [](int x)
+                                 { return x % 3 == 0; }) == 16667);
+        CHECK(cheamstl::reduce(cheamstl::execution::par, l, 0LL, [](long long a, long long b)
+                               { return a + b; }) == 49999LL * 50000 / 2);
+
+        /* 单趟迭代器仍然可以用串行版本 */
+        std::istringstream in("1 2 3 4");
+        long long sum = 0;
+        cheamstl::for_each(cheamstl::execution::seq, in_iter(in), in_iter(), [&](int x)
+                           { sum += x; });
+        CHECK(sum == 10);
+    }
+
+    /* 段里的链表在 close 之后重新映射仍然可用；不是段文件的文件要被拒绝 */
+    struct segment_test_tag
+    {
+    };
+
+    void test_mapped_segment_reopen()
+    {
+        typedef cheamstl::mapped_segment<segment_test_tag> segment;
+        typedef cheamstl::list<int, cheamstl::mapped_allocator<int, segment_test_tag>> mapped_list;
+
+        char path[] = "/tmp/cheamstl_segment_XXXXXX";
+        int fd = ::mkstemp(path);
+        CHECK(fd >= 0);
+        if (fd < 0)
+            return;
+        ::close(fd);
+
+        CHECK(segment::open(path, 1 << 20));
+        mapped_list *l = segment::find_or_construct_root<mapped_list>();
+        for (int i = 0; i < 1000; ++i)
+            l->push_back(i);
+        for (auto it = l->begin(); it != l->end();)
+            it = *it % 2 != 0 ? l->erase(it) : ++it;
+        segment::close();
+        CHECK(!segment::is_open());
+
+        /* 中间占用一段地址，让第二次映射尽量落到别的位置 */
+        std::vector<char> filler(1 << 20);
+        CHECK(!segment::open(path, 1 << 20));
+        l = segment::find_or_construct_root<mapped_list>();
+        std::vector<int> expect;
+        for (int i = 0; i < 1000; i += 2)
+            expect.push_back(i);
+        CHECK(l->size() == 500);
+        CHECK(to_vector(*l) == expect);
+        l->push_front(-1);
+        CHECK(l->front() == -1 && l->back() == 998);
+        segment::close();
+
+        bool thrown = false;
+        std::FILE *f = std::fopen(path, "wb");
+        std::fputs("not a segment, only some text", f);
+        std::fclose(f);
+        try
+        {
+            segment::open(path, 1 << 20);
+        }
+        catch (const std::runtime_error &)
+        {
+            thrown = true;
+        }
+        CHECK(thrown);
+        CHECK(!segment::is_open());
+        std::remove(path);
+    }
+
+    /* 调用 f，返回它抛出的 runtime_error 的说明，没有抛出时返回空串 */
+    template <class F>
+    std::string runtime_error_of(F f)
+    {
+        try
+        {
+            f();
+        }
+        catch (const std::runtime_error &e)
+        {
+            return e.what();
+        }
+        return std::string();
+    }
+
+    void write_file(const char *path, const std::string &content)
+    {
+        std::FILE *f = std::fopen(path, "wb");
+        std::fwrite(content.data(), 1, content.size(), f);
+        std::fclose(f);
+    }
+
+    std::string read_file(const char *path)
+    {
+        std::string content;
+        std::FILE *f = std::fopen(path, "rb");
+        char buf[4096];
+        size_t n;
+        while ((n = std::fread(buf, 1, sizeof(buf), f)) != 0)
+            content.append(buf, n);
+        std::fclose(f);
+        return content;
+    }
+
+    /* save / load 的往返，以及各种损坏的文件：加载失败时报错并且原链表不变 */
+    void test_list_snapshot()
+    {
+        char path[] = "/tmp/cheamstl_snapshot_XXXXXX";
+        int fd = ::mkstemp(path);
+        CHECK(fd >= 0);
+        if (fd < 0)
+            return;
+        ::close(fd);
+
+        std::vector<int> v = iota_vector(-100, 100000);
+        cheamstl::list<int> src(v.begin(), v.end());
+        src.save(path);
+        cheamstl::list<int> dst(5, 7);
+        dst.load(path);
+        CHECK(dst.size() == v.size());
+        CHECK(to_vector(dst) == v);
+        CHECK(dst.back() == 99999 && *--dst.end() == 99999);
+
+        cheamstl::list<int> empty;
+        empty.save(path);
+        dst.load(path);
+        CHECK(dst.empty() && dst.begin() == dst.end());
+
+        src.save(path);
+        const std::string good = read_file(path);
+        const std::vector<int> before{1, 2, 3};
+        cheamstl::list<int> target(before.begin(), before.end());
+        auto load_target = [&]()
+        { target.load(path); };
+
+        write_file(path, std::string());
+        CHECK(runtime_error_of(load_target) == "list::load: file too short");
+        CHECK(to_vector(target) == before);
+
+        write_file(path, good.substr(0, 40));
+        CHECK(runtime_error_of(load_target) == "list::load: file too short");
+        CHECK(to_vector(target) == before);
+
+        write_file(path, good.substr(0, good.size() - 1));
+        CHECK(runtime_error_of(load_target) == "list::load: file truncated");
+        CHECK(to_vector(target) == before);
+
+        std::string bad_magic = good;
+        bad_magic[0] ^= 0x5a;
+        write_file(path, bad_magic);
+        CHECK(runtime_error_of(load_target) == "list::load: not a list snapshot");
+        CHECK(to_vector(target) == before);
+
+        write_file(path, good);
+        cheamstl::list<long long> wide(3, 1);
+        CHECK(runtime_error_of([&]()
+                               { wide.load(path); }) == "list::load: element type mismatch");
+        CHECK(wide.size() == 3 && wide.front() == 1);
+
+        std::remove(path);
+        CHECK(runtime_error_of(load_target) == "list::load: cannot open file");
+        CHECK(to_vector(target) == before);
+    }
+
+    /* 记录复制、移动和析构次数的元素 */
+    struct counted
+    {
+        static long copies, moves, destroyed;
+        int v;
+
+        explicit counted(int x) : v(x) {}
+        counted(const counted &rhs) : v(rhs.v) { ++copies; }
+        counted(counted &&rhs) noexcept : v(rhs.v) { ++moves; }
+        counted &operator=(const counted &rhs)
+        {
+            v = rhs.v;
+            ++copies;
+            return *this;
+        }
+        ~counted() { ++destroyed; }
+    };
+    long counted::copies = 0;
+    long counted::moves = 0;
+    long counted::destroyed = 0;
+
+    /* extract / insert 只转移节点：不分配内存，不复制也不移动元素；仍然持有节点的句柄析构时归还节点。
+     * 用直接走 ::operator new 的 allocator，归还的节点才能从 live_news 上看出来 */
+    void test_list_node_handle()
+    {
+        typedef cheamstl::list<counted, cheamstl::allocator<counted>> list_type;
+        list_type a, b;
+        for (int i = 0; i < 4; ++i)
+            a.emplace_back(i);
+        b.emplace_back(100);
+
+        long news = live_news;
+        counted::copies = counted::moves = counted::destroyed = 0;
+        auto it = a.begin();
+        ++it;
+        const counted *addr = &*it;
+        list_type::node_type nh = a.extract(it);
+        CHECK(!nh.empty() && nh.value().v == 1 && &nh.value() == addr);
+        CHECK(a.size() == 3);
+        list_type::node_type moved(std::move(nh));
+        CHECK(nh.empty() && &moved.value() == addr);
+        auto pos = b.insert(b.begin(), std::move(moved));
+        CHECK(moved.empty());
+        CHECK(&*pos == addr && pos->v == 1);
+        CHECK(b.size() == 2 && b.front().v == 1 && b.back().v == 100);
+        CHECK(live_news == news);
+        CHECK(counted::copies == 0 && counted::moves == 0 && counted::destroyed == 0);
+
+        /* 空句柄插入什么也不做 */
+        list_type::node_type none;
+        CHECK(b.insert(b.end(), std::move(none)) == b.end());
+        CHECK(b.size() == 2);
+
+        {
+            list_type::node_type dropped = a.extract(a.begin());
+            CHECK(a.size() == 2 && a.front().v == 2);
+            CHECK(live_news == news);
+        }
+        CHECK(counted::destroyed == 1);
+        CHECK(live_news == news - 1);
+
+        /* 移动赋值给一个非空句柄时，原来持有的节点同样要归还 */
+        list_type::node_type h1 = a.extract(a.begin());
+        list_type::node_type h2 = b.extract(b.begin());
+        h1 = std::move(h2);
+        CHECK(counted::destroyed == 2);
+        CHECK(live_news == news - 2);
+        CHECK(!h1.empty() && h1.value().v == 1 && h2.empty());
+    }
+
+    /* 复制构造在第 throw_at 次时抛出；没有 noexcept 的移动构造，move_if_noexcept 会选择复制 */
+    struct throwing_copy
+    {
+        static long copies, throw_at;
+        int v;
+
+        explicit throwing_copy(int x) : v(x) {}
+        throwing_copy(const throwing_copy &rhs) : v(rhs.v)
+        {
+            if (++copies == throw_at)
+                throw std::runtime_error("copy failed");
+        }
+        throwing_copy &operator=(const throwing_copy &) = default;
+    };
+    long throwing_copy::copies = 0;
+    long throwing_copy::throw_at = -1;
+
+    template <class List>
+    std::vector<const void *> node_addresses(const List &l)
+    {
+        std::vector<const void *> addrs;
+        for (const auto &x : l)
+            addrs.push_back(&x);
+        return addrs;
+    }
+
+    template <class List>
+    bool ascending(const List &l)
+    {
+        std::vector<const void *> addrs = node_addresses(l);
+        return std::is_sorted(addrs.begin(), addrs.end(), std::less<const void *>()) &&
+               std::adjacent_find(addrs.begin(), addrs.end()) == addrs.end();
+    }
+
+    /* 打乱节点在内存中的顺序：反复从中间摘下再接到末尾，并在其间穿插其他分配 */
+    template <class List>
+    void scatter(List &l, std::vector<int> &model)
+    {
+        std::mt19937 rng(7);
+        List other;
+        for (int round = 0; round < 2000; ++round)
+        {
+            size_t k = rng() % l.size();
+            auto it = l.begin();
+            std::advance(it, k);
+            l.splice(l.end(), l, it);
+            model.push_back(model[k]);
+            model.erase(model.begin() + k);
+            other.emplace_back(round);
+        }
+    }
+
+    /* compact 之后元素不变、节点地址沿链表递增；复制中途抛出时链表保持原样（强异常保证） */
+    template <class Alloc>
+    void test_list_compact_with()
+    {
+        typedef cheamstl::list<int, typename Alloc::template rebind<int>::other> int_list;
+        std::vector<int> model = iota_vector(0, 3000);
+        int_list l(model.begin(), model.end());
+        scatter(l, model);
+        CHECK(to_vector(l) == model);
+        CHECK(!ascending(l));
+        l.compact();
+        CHECK(to_vector(l) == model);
+        CHECK(ascending(l));
+        CHECK(*--l.end() == model.back());
+
+        typedef cheamstl::list<throwing_copy, typename Alloc::template rebind<throwing_copy>::other> throwing_list;
+        throwing_list t;
+        for (int i = 0; i < 500; ++i)
+            t.emplace_back(i);
+        std::vector<const void *> addrs = node_addresses(t);
+        long news = live_news;
+        throwing_copy::copies = 0;
+        throwing_copy::throw_at = 250;
+        bool thrown = false;
+        try
+        {
+            t.compact();
+        }
+        catch (const std::runtime_error &)
+        {
+            thrown = true;
+        }
+        throwing_copy::throw_at = -1;
+        CHECK(thrown);
+        CHECK(t.size() == 500);
+        CHECK(node_addresses(t) == addrs);
+        bool same = true;
+        int expect = 0;
+        for (const auto &x : t)
+            same = same && x.v == expect++;
+        CHECK(same);
+        /* 抛出之前申请的新节点全部归还（只有直接走 operator new 的分配器能从计数上看出来） */
+        if (std::is_same<Alloc, cheamstl::allocator<int>>::value)
+            CHECK(live_news == news);
+    }
+
+    void test_list_compact()
+    {
+        test_list_compact_with<cheamstl::allocator<int>>();
+        test_list_compact_with<cheamstl::pool_allocator<int>>();
+    }
+
+    /* 转发给 target 的内存资源，记录调用次数和尚未归还的字节数；is_monotonic 与 target 一致 */
+    class counting_resource : public cheamstl::pmr::memory_resource
+    {
+    public:
+        cheamstl::pmr::memory_resource *target;
+        long allocations = 0, deallocations = 0, outstanding = 0;
+
+        explicit counting_resource(cheamstl::pmr::memory_resource *t) : target(t) {}
+
+    private:
+        void *do_allocate(size_t bytes, size_t alignment) override
+        {
+            ++allocations;
+            outstanding += static_cast<long>(bytes);
+            return target->allocate(bytes, alignment);
+        }
+
+        void do_deallocate(void *p, size_t bytes, size_t alignment) override
+        {
+            ++deallocations;
+            outstanding -= static_cast<long>(bytes);
+            target->deallocate(p, bytes, alignment);
+        }
+
+        bool do_is_monotonic() const noexcept override { return target->is_monotonic(); }
+    };
+
+    /* pmr::list：单调资源上 clear 不逐个归还节点，release() 回收全部内存；
+     * 不同资源之间的移动赋值逐个移动元素，节点来自目标自己的资源 */
+    void test_pmr_list()
+    {
+        counting_resource upstream(cheamstl::pmr::new_delete_resource());
+        {
+            cheamstl::pmr::monotonic_buffer_resource arena(&upstream);
+            counting_resource spy(&arena);
+            cheamstl::pmr::list<int> l(&spy);
+            for (int i = 0; i < 10000; ++i)
+                l.push_back(i);
+            CHECK(spy.allocations == 10000);
+            CHECK(upstream.outstanding > 0);
+            l.clear();
+            CHECK(spy.deallocations == 0);
+            CHECK(l.empty() && l.begin() == l.end());
+            /* 清空之后链表照常可用 */
+            l.push_back(1);
+            l.push_front(0);
+            CHECK(to_vector(l) == std::vector<int>({0, 1}));
+
+            /* 元素需要析构时不能跳过节点 */
+            cheamstl::pmr::list<counted> c(&spy);
+            for (int i = 0; i < 100; ++i)
+                c.emplace_back(i);
+            counted::destroyed = 0;
+            c.clear();
+            CHECK(counted::destroyed == 100);
+
+            l.clear();
+            arena.release();
+            CHECK(upstream.outstanding == 0);
+            /* release 之后资源仍可继续使用 */
+            l.push_back(42);
+            CHECK(l.front() == 42 && upstream.outstanding > 0);
+            l.clear();
+        }
+        CHECK(upstream.outstanding == 0);
+
+        /* 不是单调资源时 clear 逐个归还节点 */
+        counting_resource heap(cheamstl::pmr::new_delete_resource());
+        {
+            cheamstl::pmr::list<int> l(&heap);
+            for (int i = 0; i < 100; ++i)
+                l.push_back(i);
+            l.clear();
+            CHECK(heap.deallocations == 100 && heap.outstanding == 0);
+        }
+
+        counting_resource r1(cheamstl::pmr::new_delete_resource()), r2(cheamstl::pmr::new_delete_resource());
+        {
+            std::vector<int> v = iota_vector(0, 1000);
+            cheamstl::pmr::list<int> a(v.begin(), v.end(), &r1);
+            cheamstl::pmr::list<int> b(&r2);
+            b.push_back(-1);
+            b = std::move(a);
+            CHECK(b.get_allocator().resource() == &r2);
+            CHECK(to_vector(b) == v);
+            CHECK(a.empty());
+            CHECK(r1.outstanding == 0);
+            CHECK(r2.allocations - r2.deallocations == 1000);
+
+            /* 同一个资源之间直接接管节点，不再分配 */
+            cheamstl::pmr::list<int> c(&r2);
+            const int *first = &b.front();
+            long allocations = r2.allocations;
+            c = std::move(b);
+            CHECK(r2.allocations == allocations);
+            CHECK(&c.front() == first && c.size() == 1000 && b.empty());
+
+            /* 移动构造连同资源一起接管 */
+            cheamstl::pmr::list<int> d(std::move(c));
+            CHECK(d.get_allocator().resource() == &r2 && &d.front() == first);
+        }
+        CHECK(r1.outstanding == 0 && r2.outstanding == 0);
+    }
+
+    /* merge 的比较函数中途抛出时，两个链表的 size 仍与实际节点数一致，元素不丢失 */
+    void test_list_merge_throwing_compare()
+    {
+        for (int throw_after = 0; throw_after < 40; ++throw_after)
+        {
+            std::vector<int> va, vb;
+            for (int i = 0; i < 20; ++i)
+            {
+                va.push_back(3 * i);
+                vb.push_back(3 * i - 4);
+                vb.push_back(3 * i - 2);
+            }
+            cheamstl::list<int> a(va.begin(), va.end());
+            cheamstl::list<int> b(vb.begin(), vb.end());
+            int calls = 0;
+            bool thrown = false;
+            try
+            {
+                a.merge(b, [&](int x, int y)
+                        {
+                    if (calls++ == throw_after)
+                        throw std::runtime_error("compare failed");
+                    return x < y; });
+            }
+            catch (const std::runtime_error &)
+            {
+                thrown = true;
+            }
+            CHECK(thrown);
+            CHECK(a.size() == static_cast<size_t>(std::distance(a.begin(), a.end())));
+            CHECK(b.size() == static_cast<size_t>(std::distance(b.begin(), b.end())));
+            CHECK(a.size() + b.size() == 60);
+            std::vector<int> all = to_vector(a), rest = to_vector(b);
+            all.insert(all.end(), rest.begin(), rest.end());
+            std::sort(all.begin(), all.end());
+            std::vector<int> expect = va;
+            expect.insert(expect.end(), vb.begin(), vb.end());
+            std::sort(expect.begin(), expect.end());
+            CHECK(all == expect);
+        }
+    }
+
+    struct keyed
+    {
+        int key;
+        int order;
+    };
+
+    /* 并行排序稳定；comp 抛出或线程池提交任务失败时，所有元素都回到链表中，size 与节点数一致 */
+    void test_list_parallel_sort()
+    {
+        const int n = 40000;
+        std::mt19937 rng(11);
+        std::vector<keyed> v;
+        for (int i = 0; i < n; ++i)
+            v.push_back(keyed{static_cast<int>(rng() % 1000), i});
+        auto by_key = [](const keyed &a, const keyed &b)
+        { return a.key < b.key; };
+
+        cheamstl::list<keyed> l(v.begin(), v.end());
+        l.sort(cheamstl::execution::par, by_key, 8);
+        std::vector<keyed> expect = v;
+        std::stable_sort(expect.begin(), expect.end(), by_key);
+        bool same = l.size() == expect.size();
+        auto it = l.begin();
+        for (size_t i = 0; same && i < expect.size(); ++i, ++it)
+            same = it->key == expect[i].key && it->order == expect[i].order;
+        CHECK(same);
+        CHECK((--l.end())->order == expect.back().order);
+
+        auto intact = [&](const cheamstl::list<keyed> &x)
+        {
+            if (x.size() != static_cast<size_t>(std::distance(x.begin(), x.end())) || x.size() != v.size())
+                return false;
+            std::vector<int> orders;
+            for (const keyed &k : x)
+                orders.push_back(k.order);
+            /* 反向遍历的节点数也要一致，prev 指针同样被接好了 */
+            size_t back = 0;
+            for (auto r = x.end(); r != x.begin(); --r)
+                ++back;
+            std::sort(orders.begin(), orders.end());
+            return back == x.size() && orders == iota_vector(0, n);
+        };
+
+        for (int throw_at : {10, 50000, 200000, 450000})
+        {
+            cheamstl::list<keyed> t(v.begin(), v.end());
+            std::atomic<int> calls(0);
+            bool thrown = false;
+            try
+            {
+                t.sort(cheamstl::execution::par, [&](const keyed &a, const keyed &b)
+                       {
+                    if (calls.fetch_add(1, std::memory_order_relaxed) == throw_at)
+                        throw std::runtime_error("compare failed");
+                    return a.key < b.key; },
+                       8);
+            }
+            catch (const std::runtime_error &)
+            {
+                thrown = true;
+            }
+            CHECK(thrown);
+            CHECK(intact(t));
+        }
+
+        /* 拆开链表之后、向线程池提交任务时申请内存失败；逐次推迟失败点，直到排序能够完成 */
+        bool finished = false;
+        for (long fail = 0; !finished && fail < 200; ++fail)
+        {
+            cheamstl::list<keyed> t(v.begin(), v.end());
+            fail_after = fail;
+            try
+            {
+                t.sort(cheamstl::execution::par, by_key, 8);
+                finished = true;
+            }
+            catch (const std::bad_alloc &)
+            {
+            }
+            fail_after = -1;
+            CHECK(intact(t));
+            if (finished)
+                CHECK(std::is_sorted(t.begin(), t.end(), by_key));
+        }
+        CHECK(finished);
+    }
+
+    /* 只在下面的测试里使用这个大小，thread_cache_pool 的状态不受其他测试影响 */
+    struct pool_block
+    {
+        void *words[9];
+    };
+
+    /* 已退出线程的块经全局池流到别的线程、再被释放时，会挂到那个空闲 heap 的 remote 栈上；
+     * 补货时要收回这些块，而不是切新的 chunk：反复分配、释放同样多的块，用到的始终是一开始就有的 chunk */
+    void test_thread_cache_idle_heap_drain()
+    {
+        typedef cheamstl::thread_cache_allocator<pool_block> alloc;
+        typedef alloc::pool_type pool;
+        static_assert(alloc::use_pool, "the test must go through thread_cache_pool");
+        const size_t per_chunk = pool::chunk_bytes / pool::block_size;
+        const size_t k = per_chunk * 3 / 2;
+        auto chunk_of = [](void *p)
+        { return reinterpret_cast<uintptr_t>(p) & ~static_cast<uintptr_t>(pool::chunk_bytes - 1); };
+
+        /* 本线程先建好自己的 heap，否则会直接接手下面那个线程退出后留下的 heap */
+        pool_block *mine = alloc::allocate();
+
+        /* 另一个线程切出 chunk、用完后退出，它的块全部进入全局池 */
+        std::vector<uintptr_t> chunks;
+        std::thread([&]()
+                    {
+            std::vector<pool_block *> v;
+            for (size_t i = 0; i < k; ++i)
+                v.push_back(alloc::allocate());
+            for (pool_block *p : v)
+                chunks.push_back(chunk_of(p));
+            for (pool_block *p : v)
+                alloc::deallocate(p); })
+            .join();
+        chunks.push_back(chunk_of(mine));
+        std::sort(chunks.begin(), chunks.end());
+        chunks.erase(std::unique(chunks.begin(), chunks.end()), chunks.end());
+        auto known = [&](pool_block *p)
+        { return std::binary_search(chunks.begin(), chunks.end(), chunk_of(p)); };
+
+        for (int round = 0; round < 20; ++round)
+        {
+            std::vector<pool_block *> v;
+            for (size_t i = 0; i < k; ++i)
+                v.push_back(alloc::allocate());
+            bool reused = true;
+            for (pool_block *p : v)
+                reused = reused && known(p);
+            CHECK(reused);
+            /* 这些块的所有者是已经退出的线程，释放后都挂到它的 remote 栈上 */
+            for (pool_block *p : v)
+                alloc::deallocate(p);
+            pool::trim();
+        }
+
+        /* 多个线程交叉分配、释放对方的块，结束后同样不需要新的 chunk */
+        std::vector<std::vector<pool_block *>> handoff(4);
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < handoff.size(); ++t)
+            threads.emplace_back([&, t]()
+                                 {
+                for (size_t i = 0; i < k / handoff.size(); ++i)
+                    handoff[t].push_back(alloc::allocate()); });
+        for (auto &th : threads)
+            th.join();
+        threads.clear();
+        for (size_t t = 0; t < handoff.size(); ++t)
+            threads.emplace_back([&, t]()
+                                 {
+                for (pool_block *p : handoff[(t + 1) % handoff.size()])
+                    alloc::deallocate(p); });
+        for (auto &th : threads)
+            th.join();
+        std::vector<pool_block *> v;
+        for (size_t i = 0; i < k; ++i)
+            v.push_back(alloc::allocate());
+        bool reused = true;
+        for (pool_block *p : v)
+            reused = reused && known(p);
+        CHECK(reused);
+        for (pool_block *p : v)
+            alloc::deallocate(p);
+        alloc::deallocate(mine);
+        pool::trim();
+    }
+
+    /* 检查 nth / index_of / distance 与模型一致；const 版本只读取索引，非 const 版本会先补齐索引 */
+    template <class List>
+    bool index_queries_match(List &l, const std::vector<int> &model, std::mt19937 &rng)
+    {
+        const List &cl = l;
+        bool ok = l.size() == model.size() && cl.index_of(cl.end()) == model.size();
+        for (int q = 0; ok && q < 8 && !model.empty(); ++q)
+        {
+            size_t k = rng() % model.size();
+            size_t j = k + rng() % (model.size() - k + 1);
+            auto ck = cl.nth(k);
+            ok = *ck == model[k] && cl.index_of(ck) == k;
+            auto cj = j == model.size() ? cl.end() : cl.nth(j);
+            ok = ok && cl.distance(ck, cj) == j - k;
+            if (q % 2 == 1)
+            {
+                auto it = l.nth(k);
+                ok = ok && *it == model[k] && l.index_of(it) == k && l.distance(it, l.end()) == model.size() - k;
+            }
+        }
+        return ok;
+    }
+
+    /* 位置索引的增量维护：随机在各处插入、删除、接合，每次修改之后都查询；元素值各不相同 */
+    void test_list_position_index()
+    {
+        std::mt19937 rng(5);
+        std::vector<int> model = iota_vector(0, 3000);
+        cheamstl::list<int> l(model.begin(), model.end());
+        cheamstl::list<int> other;
+        l.enable_index();
+        int next = 3000;
+        bool ok = index_queries_match(l, model, rng);
+        for (int round = 0; ok && round < 3000; ++round)
+        {
+            size_t k = model.empty() ? 0 : rng() % (model.size() + 1);
+            auto pos = l.begin();
+            std::advance(pos, k);
+            switch (rng() % 8)
+            {
+            case 0:
+                l.insert(pos, next);
+                model.insert(model.begin() + k, next++);
+                break;
+            case 1:
+                if (k < model.size())
+                {
+                    l.erase(pos);
+                    model.erase(model.begin() + k);
+                }
+                break;
+            case 2:
+                l.push_back(next);
+                model.push_back(next++);
+                break;
+            case 3:
+                l.push_front(next);
+                model.insert(model.begin(), next++);
+                break;
+            case 4:
+                if (!model.empty())
+                {
+                    l.pop_back();
+                    model.pop_back();
+                }
+                break;
+            case 5:
+            {
+                /* 把 [k, k + m) 移到另一个链表，再整段接回到随机位置 */
+                size_t m = std::min<size_t>(rng() % 50, model.size() - k);
+                auto last = pos;
+                std::advance(last, m);
+                other.splice(other.end(), l, pos, last);
+                std::vector<int> moved(model.begin() + k, model.begin() + k + m);
+                model.erase(model.begin() + k, model.begin() + k + m);
+                size_t at = rng() % (model.size() + 1);
+                auto to = l.begin();
+                std::advance(to, at);
+                l.splice(to, other);
+                model.insert(model.begin() + at, moved.begin(), moved.end());
+                break;
+            }
+            case 6:
+            {
+                /* 批量追加，尾部超过两倍步长后查询会补上新的检查点 */
+                for (int i = 0; i < 200; ++i)
+                {
+                    l.push_back(next);
+                    model.push_back(next++);
+                }
+                break;
+            }
+            default:
+                if (k < model.size())
+                {
+                    size_t m = std::min<size_t>(rng() % 100, model.size() - k);
+                    auto last = pos;
+                    std::advance(last, m);
+                    l.erase(pos, last);
+                    model.erase(model.begin() + k, model.begin() + k + m);
+                }
+                break;
+            }
+            ok = index_queries_match(l, model, rng);
+        }
+        CHECK(ok);
+        CHECK(to_vector(l) == model);
+
+        /* 排序让整个索引失效，查询结果仍然正确 */
+        l.sort();
+        std::sort(model.begin(), model.end());
+        CHECK(index_queries_match(l, model, rng));
+        l.disable_index();
+        CHECK(index_queries_match(l, model, rng));
+    }
+
+    /* const 查询不修改索引：多个线程同时在部分失效的索引上查询（配合 ThreadSanitizer） */
+    void test_list_index_concurrent_reads()
+    {
+        std::vector<int> model = iota_vector(0, 20000);
+        cheamstl::list<int> l(model.begin(), model.end());
+        l.enable_index();
+        auto mid = l.begin();
+        std::advance(mid, 15000);
+        l.erase(mid);
+        model.erase(model.begin() + 15000);
+        l.push_back(-1);
+        model.push_back(-1);
+
+        const cheamstl::list<int> &cl = l;
+        std::atomic<int> mismatches(0);
+        std::vector<std::thread> readers;
+        for (unsigned t = 0; t < 4; ++t)
+            readers.emplace_back([&, t]()
+                                 {
+                std::mt19937 rng(t);
+                for (int q = 0; q < 300; ++q)
+                {
+                    size_t k = rng() % model.size();
+                    auto it = cl.nth(k);
+                    if (*it != model[k] || cl.index_of(it) != k || cl.distance(cl.begin(), it) != k)
+                        mismatches.fetch_add(1, std::memory_order_relaxed);
+                } });
+        for (auto &r : readers)
+            r.join();
+        CHECK(mismatches.load() == 0);
+    }
+
+    /* persistent_list：随机地从任意一个旧版本派生新版本，所有存活的版本都要与各自的模型一致 */
+    void test_persistent_list_versions()
+    {
+        typedef cheamstl::persistent_list<std::string> plist;
+        typedef std::vector<std::string> model_type;
+        auto as_vector = [](const plist &l)
+        { return model_type(l.begin(), l.end()); };
+
+        std::mt19937 rng(4);
+        std::vector<std::pair<plist, model_type>> versions(1);
+        bool ok = true;
+        for (int round = 0; ok && round < 20000; ++round)
+        {
+            const auto &base = versions[rng() % versions.size()];
+            plist l = base.first;
+            model_type v = base.second;
+            /* 超过短字符串优化的长度，元素在堆上，泄漏或重复释放都能被 ASan 发现 */
+            std::string s = "persistent-list-value-" + std::to_string(round);
+            switch (rng() % 5)
+            {
+            case 0:
+                l = l.push_front(s);
+                v.insert(v.begin(), s);
+                break;
+            case 1:
+                if (!v.empty())
+                {
+                    l = l.pop_front();
+                    v.erase(v.begin());
+                }
+                break;
+            case 2:
+                if (!v.empty())
+                {
+                    size_t i = rng() % v.size();
+                    l = l.set(i, s);
+                    v[i] = s;
+                }
+                break;
+            case 3:
+            {
+                size_t i = rng() % (v.size() + 1);
+                l = l.insert(i, s);
+                v.insert(v.begin() + i, s);
+                break;
+            }
+            default:
+                if (!v.empty())
+                {
+                    size_t i = rng() % v.size();
+                    l = l.erase(i);
+                    v.erase(v.begin() + i);
+                }
+                break;
+            }
+            ok = as_vector(l) == v && l.size() == v.size();
+            versions.emplace_back(l, v);
+            if (versions.size() > 200)
+                versions.erase(versions.begin() + rng() % versions.size());
+        }
+        CHECK(ok);
+        for (const auto &p : versions)
+            ok = ok && as_vector(p.first) == p.second;
+        CHECK(ok);
+
+        /* 很长的链表释放时不能递归 */
+        cheamstl::persistent_list<int> big;
+        for (int i = 0; i < 1000000; ++i)
+            big = big.push_front(i);
+        CHECK(big.size() == 1000000 && big.front() == 999999);
+        big = cheamstl::persistent_list<int>();
+        CHECK(big.empty());
+
+        /* 单线程下 cell 的 load / store / update */
+        cheamstl::persistent_list_cell<std::string> cell(plist{"a", "b"});
+        plist snap = cell.load();
+        cell.store(snap.push_front("z"));
+        plist published = cell.update([](const plist &cur)
+                                      { return cur.set(1, "A"); });
+        CHECK(as_vector(snap) == model_type({"a", "b"}));
+        CHECK(as_vector(published) == model_type({"z", "A", "b"}));
+        CHECK(cell.load() == published && cell.load().same_as(published));
+    }
+
+    /* small_list：不超过 N 个元素时完全不分配内存；删除的内置槽进入空闲链表被复用；
+     * 跨对象 splice 时堆上的节点原样转移，内置槽中的元素移动到目标的新节点里 */
+    void test_small_list()
+    {
+        typedef cheamstl::small_list<int, 4, cheamstl::allocator<int>> small_type;
+        long news = live_news;
+        {
+            small_type l{1, 2, 3, 4};
+            CHECK(live_news == news);
+            /* 反复删除、插入，元素个数始终不超过 4，每次都复用刚释放的内置槽 */
+            for (int round = 0; round < 100; ++round)
+            {
+                auto it = l.begin();
+                for (int k = round % 4; k > 0; --k)
+                    ++it;
+                const int *slot = &*it;
+                l.erase(it);
+                auto fresh = l.insert(l.begin(), round);
+                CHECK(&*fresh == slot);
+            }
+            CHECK(l.size() == 4);
+            CHECK(live_news == news);
+            l.push_back(5); // 第 5 个元素才向分配器申请
+            CHECK(live_news == news + 1);
+            l.pop_back();
+            CHECK(live_news == news);
+            l.clear();
+            l.assign({7, 8, 9});
+            CHECK(live_news == news);
+        }
+        CHECK(live_news == news);
+
+        {
+            small_type a{1, 2, 3, 4, 5, 6}; // 1..4 在内置槽中，5、6 在堆上
+            small_type b{10};
+            CHECK(live_news == news + 2);
+            int *heap5 = &*std::next(a.begin(), 4);
+            int *inline2 = &*std::next(a.begin());
+
+            /* 单个堆节点：地址不变，迭代器仍然有效，现在属于 b */
+            b.splice(b.end(), a, std::next(a.begin(), 4));
+            CHECK(&b.back() == heap5);
+            CHECK(to_vector(a) == std::vector<int>({1, 2, 3, 4, 6}) && to_vector(b) == std::vector<int>({10, 5}));
+            CHECK(live_news == news + 2);
+
+            /* 单个内置元素：移动到 b 的内置槽里，a 的内置槽被释放，之后 a 的插入复用它 */
+            b.splice(b.begin(), a, std::next(a.begin()));
+            CHECK(to_vector(a) == std::vector<int>({1, 3, 4, 6}) && to_vector(b) == std::vector<int>({2, 10, 5}));
+            CHECK(&b.front() != inline2);
+            a.push_front(0);
+            CHECK(&a.front() == inline2);
+            CHECK(live_news == news + 2);
+
+            /* 整体 splice：b 的内置槽用完后，a 的内置元素才需要新节点 */
+            b.splice(std::next(b.begin()), a);
+            CHECK(a.empty() && a.size() == 0);
+            CHECK(to_vector(b) == std::vector<int>({2, 0, 1, 3, 4, 6, 10, 5}));
+            CHECK(b.size() == 8);
+            CHECK(live_news == news + 4);
+
+            /* 同一对象内的 splice 只改指针 */
+            const int *first = &b.front();
+            b.splice(b.end(), b, b.begin());
+            CHECK(&b.back() == first);
+            CHECK(to_vector(b) == std::vector<int>({0, 1, 3, 4, 6, 10, 5, 2}));
+
+            /* 移动与交换：堆节点被接管，内置元素逐个移动 */
+            small_type c(std::move(b));
+            CHECK(b.empty() && to_vector(c) == std::vector<int>({0, 1, 3, 4, 6, 10, 5, 2}));
+            a = {42};
+            a.swap(c);
+            CHECK(to_vector(a) == std::vector<int>({0, 1, 3, 4, 6, 10, 5, 2}) && to_vector(c) == std::vector<int>({42}));
+        }
+        CHECK(live_news == news);
+
+        /* 元素的构造、移动与析构一一对应 */
+        counted::destroyed = counted::copies = counted::moves = 0;
+        {
+            cheamstl::small_list<counted, 2> x, y;
+            for (int i = 0; i < 5; ++i)
+                x.emplace_back(i);
+            y.emplace_back(9);
+            y.splice(y.begin(), x);
+            CHECK(x.empty() && y.size() == 6);
+            CHECK(counted::moves == 2); // 只有 x 的两个内置元素需要移动
+        }
+        CHECK(counted::destroyed == 6 + counted::moves);
+
+        /* 与 list 一致的算法：sort 稳定、merge、unique、find */
+        std::mt19937 rng(19);
+        std::vector<keyed> v;
+        for (int i = 0; i < 50; ++i)
+            v.push_back(keyed{static_cast<int>(rng() % 10), i});
+        auto by_key = [](const keyed &a, const keyed &b)
+        { return a.key < b.key; };
+        cheamstl::small_list<keyed, 8> s(v.begin(), v.end());
+        s.sort(by_key);
+        std::stable_sort(v.begin(), v.end(), by_key);
+        bool same = s.size() == v.size();
+        auto sit = s.begin();
+        for (size_t i = 0; same && i < v.size(); ++i, ++sit)
+            same = sit->key == v[i].key && sit->order == v[i].order;
+        CHECK(same);
+
+        cheamstl::small_list<int, 3> m1{1, 4, 4, 9, 12};
+        cheamstl::small_list<int, 3> m2{0, 4, 5, 20, 21};
+        m1.merge(m2);
+        CHECK(m2.empty() && m2.size() == 0);
+        CHECK(to_vector(m1) == std::vector<int>({0, 1, 4, 4, 4, 5, 9, 12, 20, 21}));
+        CHECK(m1.unique() == 2 && m1.size() == 8);
+        CHECK(to_vector(m1) == std::vector<int>({0, 1, 4, 5, 9, 12, 20, 21}));
+        CHECK(*m1.find(9) == 9 && m1.find(3) == m1.end());
+        CHECK(*m1.find_if([](int x)
+                          { return x > 10; }) == 12);
+        m1.sort(std::greater<int>());
+        CHECK(to_vector(m1) == std::vector<int>({21, 20, 12, 9, 5, 4, 1, 0}));
+
+        /* comp 抛出时 sort 不丢失元素 */
+        cheamstl::small_list<int, 4> t{5, 3, 8, 1, 9, 2};
+        int calls = 0;
+        try
+        {
+            t.sort([&calls](int a, int b)
+                   {
+                if (++calls == 5)
+                    throw std::runtime_error("comp");
+                return a < b; });
+            CHECK(false);
+        }
+        catch (const std::runtime_error &)
+        {
+        }
+        std::vector<int> rest = to_vector(t);
+        std::sort(rest.begin(), rest.end());
+        CHECK(t.size() == 6 && rest == std::vector<int>({1, 2, 3, 5, 8, 9}));
+    }
+
+} // namespace
+
+int main()
+{
+    test_compact_list();
+    test_unrolled_list();
+    test_allocate_chain_failure();
+    test_parallel_algorithms();
+    test_mapped_segment_reopen();
+    test_list_snapshot();
+    test_list_node_handle();
+    test_list_compact();
+    test_pmr_list();
+    test_list_merge_throwing_compare();
+    test_list_parallel_sort();
+    test_thread_cache_idle_heap_drain();
+    test_list_position_index();
+    test_list_index_concurrent_reads();
+    test_persistent_list_versions();
+    test_small_list();
+    if (failures != 0)
+    {
+        std::printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,532 @@
+/* list 的性能基准：把 cheamstl::list（分别搭配 allocator.h 中的每一种分配器）、cheamstl::compact_list、
+ * cheamstl::unrolled_list 与 std::list 放在一起比较
+ *
+ * 编译（Linux）：g++ -O2 -std=c++11 -pthread Test/list_benchmark.cpp -o list_benchmark
+ * 运行：
+ *   ./list_benchmark                      全部用例，结果以 CSV 输出到标准输出
+ *   ./list_benchmark --max 100000         只跑元素个数不超过 100000 的用例
+ *   ./list_benchmark --filter sort        只跑操作名包含 sort 的用例
+ *   ./list_benchmark --compare old.csv    与之前保存的结果比较，变慢超过阈值（默认 10%）时返回非零
+ *   ./list_benchmark --threshold 0.2      修改比较的阈值
+ *
+ * 输出格式：container,allocator,type,op,n,ns_per_elem
+ * 每个用例重复若干次取中位数，ns_per_elem 为平均到每个元素上的耗时。
+ * op 为 memory 的行例外：最后一列是用 n 个元素构造容器之后堆上多占用的字节数再除以 n，
+ * 包含 malloc 的块头、分配器 chunk 中没用完的部分和 compact_list 扩容留下的空槽（只在 glibc 下统计）。
+ * memory 在所有计时用例之前、只用选中的最大 n 跑一次，因为池分配器的 chunk 不归还，之后再测就只能测到复用。
+ * pmr::polymorphic_allocator 一列使用 monotonic_buffer_resource：每个用例和每次采样各用一个，采样结束时整体释放。
+ * 结束时在标准错误上打印 huge_page_allocator 实际拿到的页面类型 */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <list>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#define LIST_BENCHMARK_HAS_HEAP_USAGE 1
+#else
+#define LIST_BENCHMARK_HAS_HEAP_USAGE 0
+#endif
+
+#include "../CheamSTL/compact_list.h"
+#include "../CheamSTL/list.h"
+#include "../CheamSTL/unrolled_list.h"
+
+namespace
+{
+
+    /* 小而平凡可复制的元素 */
+    typedef int small_t;
+
+    /* 大而不平凡的元素：带堆内存的字符串 + 一段负载，复制和析构都有代价 */
+    struct large_t
+    {
+        std::string name;
+        double payload[8];
+        int key;
+
+        large_t() : name("cheamstl-large-element"), payload(), key(0) {}
+        explicit large_t(int k) : name("cheamstl-large-element"), payload(), key(k) {}
+        bool operator<(const large_t &rhs) const { return key < rhs.key; }
+    };
+
+    template <class T>
+    T make_value(int k);
+    template <>
+    small_t make_value<small_t>(int k) { return k; }
+    template <>
+    large_t make_value<large_t>(int k) { return large_t(k); }
+
+    template <class T>
+    int key_of(const T &v);
+    template <>
+    int key_of<small_t>(const small_t &v) { return v; }
+    template <>
+    int key_of<large_t>(const large_t &v) { return v.key; }
+
+    struct options
+    {
+        size_t max_n = 10000000;
+        std::string filter;
+        std::string compare;
+        double threshold = 0.10;
+        bool memory_pass = false; // 只跑 memory 用例
+    };
+
+    /* 防止编译器把结果优化掉 */
+    volatile long long sink;
+
+    typedef std::chrono::steady_clock clock_type;
+
+    /* 一个用例：setup 不计时，run 计时，teardown 不计时 */
+    struct timer
+    {
+        clock_type::time_point start;
+        double elapsed_ns = 0;
+        void begin() { start = clock_type::now(); }
+        void end() { elapsed_ns = std::chrono::duration<double, std::nano>(clock_type::now() - start).count(); }
+    };
+
+    struct result
+    {
+        std::string container, allocator, type, op;
+        size_t n;
+        double ns_per_elem;
+    };
+
+    std::vector<result> results;
+
+    /* 小规模的用例重复更多次，保证总耗时足够长、结果稳定 */
+    size_t repeats_for(size_t n)
+    {
+        size_t r = 2000000 / (n ? n : 1);
+        if (r < 3)
+            r = 3;
+        if (r > 200)
+            r = 200;
+        return r;
+    }
+
+    /* 容器的内存从哪里来：
+     * mapped_bytes 返回 malloc 之外（mallinfo 看不到）的内存，memory 用例把它一起算上；
+     * scope 在用例和每次采样期间生效，默认什么也不做 */
+    template <class List>
+    struct backing
+    {
+        static size_t mapped_bytes() { return 0; }
+        struct scope
+        {
+            scope() {}
+        };
+    };
+
+    /* huge_page_allocator 的 chunk 直接 mmap；退回 ::operator new 的部分 mallinfo 已经统计到了 */
+    template <class T>
+    struct backing<cheamstl::list<T, cheamstl::huge_page_allocator<T>>>
+    {
+        static size_t mapped_bytes()
+        {
+            cheamstl::huge_page_chunk_source::backing_report r = cheamstl::huge_page_chunk_source::report();
+            return r.explicit_huge_bytes + r.transparent_huge_bytes;
+        }
+        struct scope
+        {
+            scope() {}
+        };
+    };
+
+    /* pmr::list：作用域内的默认资源换成一个新的 monotonic_buffer_resource，离开时整体释放。
+     * 同一次采样中的链表来自同一个资源，可以互相 splice */
+    template <class T>
+    struct backing<cheamstl::pmr::list<T>>
+    {
+        static size_t mapped_bytes() { return 0; }
+        struct scope
+        {
+            cheamstl::pmr::monotonic_buffer_resource arena;
+            cheamstl::pmr::memory_resource *prev;
+
+            scope() : prev(cheamstl::pmr::set_default_resource(&arena)) {}
+            ~scope() { cheamstl::pmr::set_default_resource(prev); }
+        };
+    };
+
+    template <class List, class F>
+    double median_ns(size_t n, F f)
+    {
+        size_t reps = repeats_for(n);
+        std::vector<double> samples;
+        samples.reserve(reps);
+        for (size_t i = 0; i < reps; ++i)
+        {
+            typename backing<List>::scope sample_scope;
+            samples.push_back(f());
+        }
+        std::sort(samples.begin(), samples.end());
+        return samples[samples.size() / 2] / static_cast<double>(n ? n : 1);
+    }
+
+    /* 当前堆上正在使用的字节数（含 malloc 的块头，以及直接 mmap 的大块），不支持时返回 0 */
+    size_t heap_in_use()
+    {
+#if LIST_BENCHMARK_HAS_HEAP_USAGE
+#if __GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33)
+        struct mallinfo2 mi = mallinfo2();
+#else
+        struct mallinfo mi = mallinfo();
+#endif
+        return static_cast<size_t>(mi.uordblks) + static_cast<size_t>(mi.hblkhd);
+#else
+        return 0;
+#endif
+    }
+
+    template <class List>
+    std::vector<typename List::iterator> collect_iterators(List &l)
+    {
+        std::vector<typename List::iterator> its;
+        its.reserve(l.size());
+        for (auto it = l.begin(); it != l.end(); ++it)
+            its.push_back(it);
+        return its;
+    }
+
+    /* 打乱节点在内存中的排布：随机删掉一半元素，再在随机位置插回同样多的元素 */
+    template <class List, class T>
+    void fragment(List &l, const std::vector<T> &values)
+    {
+        auto its = collect_iterators(l);
+        std::mt19937 r(11);
+        std::shuffle(its.begin(), its.end(), r);
+        size_t half = its.size() / 2;
+        for (size_t i = 0; i < half; ++i)
+            l.erase(its[i]);
+        its.erase(its.begin(), its.begin() + half);
+        for (size_t i = 0; i < half; ++i)
+            its.push_back(l.insert(its[r() % its.size()], values[i]));
+    }
+
+    /* 只有 cheamstl::list 提供 compact，std::list 保持碎片化的状态作为对照 */
+    template <class List>
+    void compact_if_supported(List &) {}
+
+    template <class T, class Alloc>
+    void compact_if_supported(cheamstl::list<T, Alloc> &l) { l.compact(); }
+
+    template <class T, class IndexT>
+    void compact_if_supported(cheamstl::compact_list<T, IndexT> &l) { l.compact(); }
+
+    /* unrolled_list 的插入和删除会使同一节点内的其他迭代器失效，也没有 sort，
+     * 所以依赖事先保存的迭代器的用例（iterate_compacted、random_insert、random_erase）和 sort 对它跳过 */
+    template <class List>
+    struct suite_traits
+    {
+        static constexpr bool stable_iterators = true;
+        static constexpr bool has_sort = true;
+    };
+
+    template <class T, size_t N>
+    struct suite_traits<cheamstl::unrolled_list<T, N>>
+    {
+        static constexpr bool stable_iterators = false;
+        static constexpr bool has_sort = false;
+    };
+
+    template <class List>
+    void sort_if_supported(List &l) { l.sort(); }
+
+    template <class T, size_t N>
+    void sort_if_supported(cheamstl::unrolled_list<T, N> &) {}
+
+    template <class List, class T>
+    void run_suite(const options &opt, const char *container, const char *alloc, const char *type, size_t n)
+    {
+        auto report = [&](const char *op, double ns)
+        {
+            results.push_back(result{container, alloc, type, op, n, ns});
+            std::printf("%s,%s,%s,%s,%zu,%.3f\n", container, alloc, type, op, n, ns);
+            std::fflush(stdout);
+        };
+        auto wanted = [&](const char *op)
+        {
+            return opt.filter.empty() || std::string(op).find(opt.filter) != std::string::npos;
+        };
+
+        typename backing<List>::scope suite_scope;
+        std::mt19937 rng(static_cast<unsigned>(n));
+        std::vector<T> values;
+        values.reserve(n);
+        for (size_t i = 0; i < n; ++i)
+            values.push_back(make_value<T>(static_cast<int>(rng() % 1000000)));
+
+        if (opt.memory_pass)
+        {
+            if (LIST_BENCHMARK_HAS_HEAP_USAGE && wanted("memory") && n != 0)
+            {
+                size_t before = heap_in_use() + backing<List>::mapped_bytes();
+                List l(values.begin(), values.end());
+                size_t after = heap_in_use() + backing<List>::mapped_bytes();
+                sink = static_cast<long long>(l.size());
+                report("memory", static_cast<double>(after - before) / n);
+            }
+            return;
+        }
+
+        if (wanted("push_back"))
+            report("push_back", median_ns<List>(n, [&]()
+                                          {
+                List l;
+                timer t;
+                t.begin();
+                for (size_t i = 0; i < n; ++i)
+                    l.push_back(values[i]);
+                t.end();
+                return t.elapsed_ns; }));
+
+        if (wanted("push_front"))
+            report("push_front", median_ns<List>(n, [&]()
+                                           {
+                List l;
+                timer t;
+                t.begin();
+                for (size_t i = 0; i < n; ++i)
+                    l.push_front(values[i]);
+                t.end();
+                return t.elapsed_ns; }));
+
+        if (wanted("iterate"))
+        {
+            List l(values.begin(), values.end());
+            report("iterate", median_ns<List>(n, [&]()
+                                        {
+                timer t;
+                long long sum = 0;
+                t.begin();
+                for (auto it = l.begin(); it != l.end(); ++it)
+                    sum += key_of<T>(*it);
+                t.end();
+                sink = sum;
+                return t.elapsed_ns; }));
+        }
+
+        if (suite_traits<List>::stable_iterators && wanted("iterate_compacted"))
+        {
+            List l(values.begin(), values.end());
+            fragment(l, values);
+            compact_if_supported(l);
+            report("iterate_compacted", median_ns<List>(n, [&]()
+                                                  {
+                timer t;
+                long long sum = 0;
+                t.begin();
+                for (auto it = l.begin(); it != l.end(); ++it)
+                    sum += key_of<T>(*it);
+                t.end();
+                sink = sum;
+                return t.elapsed_ns; }));
+        }
+
+        if (suite_traits<List>::stable_iterators && wanted("random_insert"))
+            report("random_insert", median_ns<List>(n, [&]()
+                                              {
+                List l(values.begin(), values.end());
+                auto its = collect_iterators(l);
+                std::mt19937 r(7);
+                timer t;
+                t.begin();
+                for (size_t i = 0; i < n; ++i)
+                    l.insert(its[r() % its.size()], values[i]);
+                t.end();
+                return t.elapsed_ns; }));
+
+        if (suite_traits<List>::stable_iterators && wanted("random_erase"))
+            report("random_erase", median_ns<List>(n, [&]()
+                                             {
+                List l(values.begin(), values.end());
+                auto its = collect_iterators(l);
+                std::shuffle(its.begin(), its.end(), std::mt19937(7));
+                timer t;
+                t.begin();
+                for (size_t i = 0; i < n; ++i)
+                    l.erase(its[i]);
+                t.end();
+                return t.elapsed_ns; }));
+
+        if (wanted("splice"))
+            report("splice", median_ns<List>(n, [&]()
+                                       {
+                /* 把 a 中的元素逐个移到 b 中，再整体接回 a */
+                List a(values.begin(), values.end());
+                List b;
+                timer t;
+                t.begin();
+                for (size_t i = 0; i < n; ++i)
+                    b.splice(b.end(), a, a.begin());
+                a.splice(a.end(), b);
+                t.end();
+                return t.elapsed_ns; }));
+
+        if (suite_traits<List>::has_sort && wanted("sort"))
+            report("sort", median_ns<List>(n, [&]()
+                                     {
+                List l(values.begin(), values.end());
+                timer t;
+                t.begin();
+                sort_if_supported(l);
+                t.end();
+                return t.elapsed_ns; }));
+
+        if (wanted("copy"))
+        {
+            List src(values.begin(), values.end());
+            report("copy", median_ns<List>(n, [&]()
+                                     {
+                timer t;
+                t.begin();
+                List l(src);
+                t.end();
+                sink = static_cast<long long>(l.size());
+                return t.elapsed_ns; }));
+        }
+
+        if (wanted("move"))
+        {
+            List src(values.begin(), values.end());
+            report("move", median_ns<List>(n, [&]()
+                                     {
+                timer t;
+                t.begin();
+                List l(std::move(src));
+                t.end();
+                src = std::move(l);
+                return t.elapsed_ns; }));
+        }
+
+        if (wanted("destroy"))
+            report("destroy", median_ns<List>(n, [&]()
+                                        {
+                List *l = new List(values.begin(), values.end());
+                timer t;
+                t.begin();
+                delete l;
+                t.end();
+                return t.elapsed_ns; }));
+    }
+
+    template <class T>
+    void run_type(const options &opt, const char *type, size_t n)
+    {
+        run_suite<std::list<T>, T>(opt, "std::list", "std::allocator", type, n);
+        run_suite<cheamstl::list<T, cheamstl::allocator<T>>, T>(opt, "cheamstl::list", "allocator", type, n);
+        run_suite<cheamstl::list<T, cheamstl::pool_allocator<T>>, T>(opt, "cheamstl::list", "pool_allocator", type, n);
+        run_suite<cheamstl::list<T, cheamstl::thread_cache_allocator<T>>, T>(opt, "cheamstl::list", "thread_cache_allocator",
+                                                                            type, n);
+        run_suite<cheamstl::list<T, cheamstl::huge_page_allocator<T>>, T>(opt, "cheamstl::list", "huge_page_allocator",
+                                                                         type, n);
+        run_suite<cheamstl::pmr::list<T>, T>(opt, "cheamstl::list", "pmr::polymorphic_allocator(monotonic)", type, n);
+        run_suite<cheamstl::compact_list<T>, T>(opt, "cheamstl::compact_list", "uint32_t_index", type, n);
+        run_suite<cheamstl::unrolled_list<T>, T>(opt, "cheamstl::unrolled_list", "pool_allocator", type, n);
+    }
+
+    /* 读入之前保存的 CSV，逐项与本次结果比较 */
+    int compare_with(const options &opt)
+    {
+        std::ifstream in(opt.compare);
+        if (!in)
+        {
+            std::fprintf(stderr, "cannot open %s\n", opt.compare.c_str());
+            return 2;
+        }
+        std::map<std::string, double> old;
+        std::string line;
+        while (std::getline(in, line))
+        {
+            size_t pos = line.rfind(',');
+            if (pos == std::string::npos || line.compare(0, 10, "container,") == 0)
+                continue;
+            old[line.substr(0, pos)] = std::atof(line.c_str() + pos + 1);
+        }
+
+        int regressions = 0;
+        for (const auto &r : results)
+        {
+            std::ostringstream key;
+            key << r.container << ',' << r.allocator << ',' << r.type << ',' << r.op << ',' << r.n;
+            auto it = old.find(key.str());
+            if (it == old.end() || it->second <= 0)
+                continue;
+            double ratio = r.ns_per_elem / it->second;
+            if (ratio > 1.0 + opt.threshold)
+            {
+                ++regressions;
+                std::fprintf(stderr, "REGRESSION %s: %.3f -> %.3f ns/elem (x%.2f)\n", key.str().c_str(), it->second,
+                             r.ns_per_elem, ratio);
+            }
+        }
+        std::fprintf(stderr, "%d regression(s) over %.0f%%\n", regressions, opt.threshold * 100);
+        return regressions ? 1 : 0;
+    }
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    options opt;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--max") == 0 && i + 1 < argc)
+            opt.max_n = std::strtoull(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+            opt.filter = argv[++i];
+        else if (std::strcmp(argv[i], "--compare") == 0 && i + 1 < argc)
+            opt.compare = argv[++i];
+        else if (std::strcmp(argv[i], "--threshold") == 0 && i + 1 < argc)
+            opt.threshold = std::atof(argv[++i]);
+        else
+        {
+            std::fprintf(stderr, "usage: %s [--max N] [--filter OP] [--compare FILE] [--threshold R]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::printf("container,allocator,type,op,n,ns_per_elem\n");
+    const size_t sizes[] = {10, 1000, 100000, 10000000};
+    size_t largest = 0;
+    for (size_t n : sizes)
+    {
+        if (n <= opt.max_n)
+            largest = n;
+    }
+    options memory_opt = opt;
+    memory_opt.memory_pass = true;
+    run_type<small_t>(memory_opt, "small_t", largest);
+    run_type<large_t>(memory_opt, "large_t", largest);
+
+    for (size_t n : sizes)
+    {
+        if (n > opt.max_n)
+            continue;
+        run_type<small_t>(opt, "small_t", n);
+        run_type<large_t>(opt, "large_t", n);
+    }
+
+    cheamstl::huge_page_chunk_source::backing_report r = cheamstl::huge_page_chunk_source::report();
+    const char *names[] = {"normal pages", "transparent huge pages (madvise)", "explicit huge pages (MAP_HUGETLB)"};
+    std::fprintf(stderr, "huge_page_allocator backing: %s; explicit %zu MB, transparent %zu MB, normal %zu MB, "
+                         "NUMA-bound %zu MB (last node %d)\n",
+                 names[static_cast<int>(r.backing())], r.explicit_huge_bytes >> 20, r.transparent_huge_bytes >> 20,
+                 r.normal_bytes >> 20, r.numa_bound_bytes >> 20, r.last_numa_node);
+
+    if (!opt.compare.empty())
+        return compare_with(opt);
+    return 0;
+}
@@ -0,0 +1,160 @@
+/* lru_cache 的性能基准：与 std::list + std::unordered_map 的常见写法比较
+ *
+ * 编译（Linux）：g++ -O2 -std=c++11 -pthread Test/lru_benchmark.cpp -o lru_benchmark
+ * 运行：
+ *   ./lru_benchmark                    默认每个用例 4000000 次访问
+ *   ./lru_benchmark --ops 1000000      修改访问次数
+ *
+ * 每次访问先 get，未命中再 put（缓存满时淘汰最久未使用的条目）。
+ * 键在 [0, keys) 中均匀随机，keys / capacity 越大命中率越低。
+ * 输出格式：cache,capacity,keys,hit_rate,mops_per_sec,allocs_per_op
+ * allocs_per_op 是缓存预热之后，计时区间内平均每次访问调用 operator new 的次数 */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <list>
+#include <new>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "../CheamSTL/lru_cache.h"
+
+namespace
+{
+    size_t new_calls = 0;
+}
+
+void *operator new(size_t n)
+{
+    ++new_calls;
+    if (void *p = std::malloc(n ? n : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+namespace
+{
+
+    volatile long long sink;
+
+    /* 对照组：命中时 erase + push_front，淘汰时从 map 中删除再插入 */
+    class naive_lru
+    {
+        typedef std::list<std::pair<long, long>> list_type;
+        list_type entries_;
+        std::unordered_map<long, list_type::iterator> index_;
+        size_t capacity_;
+
+    public:
+        explicit naive_lru(size_t capacity) : capacity_(capacity) { index_.reserve(capacity * 2); }
+
+        long *get(long key)
+        {
+            auto it = index_.find(key);
+            if (it == index_.end())
+                return nullptr;
+            std::pair<long, long> e = *it->second;
+            entries_.erase(it->second);
+            entries_.push_front(e);
+            it->second = entries_.begin();
+            return &entries_.front().second;
+        }
+
+        void put(long key, long value)
+        {
+            if (entries_.size() == capacity_)
+            {
+                index_.erase(entries_.back().first);
+                entries_.pop_back();
+            }
+            entries_.emplace_front(key, value);
+            index_[key] = entries_.begin();
+        }
+    };
+
+    class cheamstl_lru
+    {
+        cheamstl::lru_cache<long, long> cache_;
+
+    public:
+        explicit cheamstl_lru(size_t capacity) : cache_(capacity) {}
+        long *get(long key) { return cache_.get(key); }
+        void put(long key, long value) { cache_.put(key, value); }
+    };
+
+    template <class Cache>
+    void run(const char *name, size_t capacity, size_t keys, size_t ops)
+    {
+        std::mt19937_64 rng(capacity * 31 + keys);
+        std::vector<long> trace(ops);
+        for (auto &k : trace)
+            k = static_cast<long>(rng() % keys);
+
+        Cache cache(capacity);
+        /* 预热：先把缓存填满 */
+        for (size_t i = 0; i < capacity * 4; ++i)
+        {
+            long k = static_cast<long>(rng() % keys);
+            if (cache.get(k) == nullptr)
+                cache.put(k, k);
+        }
+
+        size_t hits = 0;
+        size_t before = new_calls;
+        auto start = std::chrono::steady_clock::now();
+        long long sum = 0;
+        for (long k : trace)
+        {
+            if (long *v = cache.get(k))
+            {
+                ++hits;
+                sum += *v;
+            }
+            else
+            {
+                cache.put(k, k);
+            }
+        }
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        size_t allocs = new_calls - before;
+        sink = sum;
+        std::printf("%s,%zu,%zu,%.3f,%.2f,%.3f\n", name, capacity, keys, static_cast<double>(hits) / ops,
+                    ops / sec / 1e6, static_cast<double>(allocs) / ops);
+        std::fflush(stdout);
+    }
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    size_t ops = 4000000;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--ops") == 0 && i + 1 < argc)
+            ops = std::strtoull(argv[++i], nullptr, 10);
+        else
+        {
+            std::fprintf(stderr, "usage: %s [--ops N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::printf("cache,capacity,keys,hit_rate,mops_per_sec,allocs_per_op\n");
+    const size_t capacities[] = {1000, 100000};
+    const size_t ratios[] = {1, 2, 10}; // keys = capacity * ratio + 1：命中率约 100%、50%、10%
+    for (size_t cap : capacities)
+    {
+        for (size_t r : ratios)
+        {
+            size_t keys = cap * r + (r == 1 ? 0 : 1);
+            run<naive_lru>("std::list+unordered_map", cap, keys, ops);
+            run<cheamstl_lru>("cheamstl::lru_cache", cap, keys, ops);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,122 @@
+/* 并行算法的性能基准：在一个大的 cheamstl::list 上比较 execution::seq 与 execution::par
+ *
+ * 编译（Linux）：g++ -O2 -std=c++11 -pthread Test/parallel_benchmark.cpp -o parallel_benchmark
+ * 运行：
+ *   ./parallel_benchmark               默认 4000000 个元素，每个元素做 64 轮计算
+ *   ./parallel_benchmark --n 1000000   修改元素个数
+ *   ./parallel_benchmark --work 8      修改每个元素的计算量，越小越接近纯访存
+ *
+ * 输出格式：algorithm,n,work,threads,seq_ms,par_ms,speedup */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "../CheamSTL/algorithm.h"
+#include "../CheamSTL/list.h"
+
+namespace
+{
+
+    volatile double sink;
+
+    /* 模拟每个元素上的计算量较大的处理 */
+    inline double heavy(double x, int work)
+    {
+        for (int i = 0; i < work; ++i)
+            x = std::sqrt(x * x + 1.0) * 0.5 + std::sin(x) * 0.25;
+        return x;
+    }
+
+    template <class F>
+    double median_ms(F f)
+    {
+        std::vector<double> samples;
+        for (int i = 0; i < 5; ++i)
+        {
+            auto start = std::chrono::steady_clock::now();
+            f();
+            samples.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        std::sort(samples.begin(), samples.end());
+        return samples[samples.size() / 2];
+    }
+
+    template <class Seq, class Par>
+    void report(const char *name, size_t n, int work, Seq seq, Par par)
+    {
+        double s = median_ms(seq);
+        double p = median_ms(par);
+        std::printf("%s,%zu,%d,%zu,%.3f,%.3f,%.2f\n", name, n, work, cheamstl::work_stealing_pool::instance().size(),
+                    s, p, s / p);
+        std::fflush(stdout);
+    }
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    size_t n = 4000000;
+    int work = 64;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--n") == 0 && i + 1 < argc)
+            n = std::strtoull(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--work") == 0 && i + 1 < argc)
+            work = std::atoi(argv[++i]);
+        else
+        {
+            std::fprintf(stderr, "usage: %s [--n N] [--work W]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    cheamstl::list<double> l;
+    for (size_t i = 0; i < n; ++i)
+        l.push_back(static_cast<double>(i % 1000) * 0.001);
+    cheamstl::list<double> out(n, 0.0);
+
+    std::printf("algorithm,n,work,threads,seq_ms,par_ms,speedup\n");
+
+    report(
+        "for_each", n, work,
+        [&]()
+        { cheamstl::for_each(cheamstl::execution::seq, l.begin(), l.end(), [work](double &x)
+                             { x = heavy(x, work) * 1e-3; }); },
+        [&]()
+        { cheamstl::for_each(cheamstl::execution::par, l, [work](double &x)
+                             { x = heavy(x, work) * 1e-3; }); });
+
+    report(
+        "transform", n, work,
+        [&]()
+        { cheamstl::transform(cheamstl::execution::seq, l.begin(), l.end(), out.begin(), [work](double x)
+                              { return heavy(x, work); }); },
+        [&]()
+        { cheamstl::transform(cheamstl::execution::par, l, out.begin(), [work](double x)
+                              { return heavy(x, work); }); });
+
+    report(
+        "count_if", n, work,
+        [&]()
+        { sink = static_cast<double>(cheamstl::count_if(cheamstl::execution::seq, l.begin(), l.end(), [work](double x)
+                                                        { return heavy(x, work) > 0.5; })); },
+        [&]()
+        { sink = static_cast<double>(cheamstl::count_if(cheamstl::execution::par, l, [work](double x)
+                                                        { return heavy(x, work) > 0.5; })); });
+
+    /* reduce 的 op 必须满足结合律，这里只做求和，是一个受访存限制的轻量用例，作为对照 */
+    auto plus = [](double acc, double x)
+    { return acc + x; };
+    report(
+        "reduce", n, 0,
+        [&]()
+        { sink = cheamstl::reduce(cheamstl::execution::seq, out.begin(), out.end(), 0.0, plus); },
+        [&]()
+        { sink = cheamstl::reduce(cheamstl::execution::par, out, 0.0, plus); });
+    return 0;
+}
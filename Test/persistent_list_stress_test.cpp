@@ -0,0 +1,155 @@
+/* persistent_list_cell 的并发测试，配合 ThreadSanitizer 使用
+ *
+ * 编译（Linux）：g++ -O1 -g -std=c++11 -pthread -fsanitize=thread Test/persistent_list_stress_test.cpp -o persistent_list_stress_test
+ * 运行：
+ *   ./persistent_list_stress_test                 每个写者默认发布 5000 个版本
+ *   ./persistent_list_stress_test --updates 2000  修改每个写者发布的版本数
+ *
+ * 4 个读者不停地 load 并完整遍历快照，2 个写者用 update 在头部追加比当前头部大 1 的元素，
+ * 另外每隔一段时间用 store 换上一个与当前内容相同、但节点全新的版本，让旧版本的节点整批被回收。
+ * 检查：每个快照都是从 size() - 1 递减到 0 的连续序列，读者看到的版本不会倒退，最终版本包含全部更新。
+ * 全部通过时输出 "all checks passed" 并返回 0；数据竞争和释放后访问由 ThreadSanitizer 报告。
+ * GCC 会提示 ThreadSanitizer 不支持 atomic_thread_fence，原因见 queue_stress_test.cpp */
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../CheamSTL/persistent_list.h"
+
+namespace
+{
+
+    int failures = 0;
+
+#define CHECK(expr)                                                              \
+    do                                                                           \
+    {                                                                            \
+        if (!(expr))                                                             \
+        {                                                                        \
+            std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #expr); \
+            ++failures;                                                          \
+        }                                                                        \
+    } while (0)
+
+    /* 元素带一个堆上的字符串，节点被提前回收时读者会读到已释放的内存 */
+    struct item
+    {
+        size_t seq;
+        std::string tag;
+
+        explicit item(size_t s) : seq(s), tag(make_tag(s)) {}
+
+        static std::string make_tag(size_t s) { return "persistent-item-" + std::to_string(s); }
+    };
+
+    typedef cheamstl::persistent_list<item> plist;
+
+    /* 快照是否为 size()-1, size()-2, ..., 0 */
+    bool well_formed(const plist &l)
+    {
+        size_t expect = l.size();
+        for (const item &x : l)
+        {
+            if (expect == 0 || x.seq != expect - 1 || x.tag != item::make_tag(x.seq))
+                return false;
+            --expect;
+        }
+        return expect == 0;
+    }
+
+    /* 与 cur 内容相同，但所有节点都是新建的 */
+    plist rebuilt(const plist &cur)
+    {
+        std::vector<size_t> seqs;
+        for (const item &x : cur)
+            seqs.push_back(x.seq);
+        plist l;
+        for (auto it = seqs.rbegin(); it != seqs.rend(); ++it)
+            l = l.push_front(item(*it));
+        return l;
+    }
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    size_t updates = 5000;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--updates") == 0 && i + 1 < argc)
+            updates = std::strtoull(argv[++i], nullptr, 10);
+        else
+        {
+            std::fprintf(stderr, "usage: %s [--updates N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    const size_t writers = 2, readers = 4;
+    cheamstl::persistent_list_cell<item> cell;
+    std::atomic<bool> stop(false);
+    std::atomic<size_t> bad_snapshots(0), regressions(0), loads(0);
+
+    std::vector<std::thread> threads;
+    for (size_t r = 0; r < readers; ++r)
+    {
+        threads.emplace_back([&]()
+                             {
+            size_t last = 0;
+            while (!stop.load(std::memory_order_acquire))
+            {
+                plist snap = cell.load();
+                if (!well_formed(snap))
+                    bad_snapshots.fetch_add(1, std::memory_order_relaxed);
+                if (snap.size() < last)
+                    regressions.fetch_add(1, std::memory_order_relaxed);
+                last = snap.size();
+                loads.fetch_add(1, std::memory_order_relaxed);
+            } });
+    }
+    std::vector<std::thread> writing;
+    for (size_t w = 0; w < writers; ++w)
+    {
+        writing.emplace_back([&, w]()
+                             {
+            for (size_t i = 0; i < updates; ++i)
+            {
+                cell.update([](const plist &cur)
+                            { return cur.push_front(item(cur.size())); });
+                /* 偶尔整体换成新节点：用 update 保证不会丢掉其他写者的更新 */
+                if (w == 0 && i % 500 == 499)
+                    cell.update([](const plist &cur)
+                                { return rebuilt(cur); });
+            } });
+    }
+    for (auto &t : writing)
+        t.join();
+    stop.store(true, std::memory_order_release);
+    for (auto &t : threads)
+        t.join();
+
+    plist last = cell.load();
+    /* 用 store 发布一个空版本，旧版本在没有读者之后整体回收 */
+    cell.store(plist());
+    std::printf("persistent_list_cell: %zu readers, %zu writers, %zu updates each: loads %zu, final size %zu, "
+                "bad snapshots %zu, regressions %zu\n",
+                readers, writers, updates, loads.load(), last.size(), bad_snapshots.load(), regressions.load());
+    CHECK(last.size() == writers * updates);
+    CHECK(well_formed(last));
+    CHECK(bad_snapshots.load() == 0);
+    CHECK(regressions.load() == 0);
+    CHECK(cell.load().empty());
+
+    if (failures != 0)
+    {
+        std::printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
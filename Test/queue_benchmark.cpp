@@ -0,0 +1,140 @@
+/* 队列吞吐量随生产者个数的变化：mpsc_queue、concurrent_queue 与“cheamstl::list + std::mutex”比较
+ *
+ * 编译（Linux）：g++ -O2 -std=c++11 -pthread Test/queue_benchmark.cpp -o queue_benchmark
+ * 运行：
+ *   ./queue_benchmark                   每个生产者默认入队 1000000 个元素
+ *   ./queue_benchmark --items 200000    修改每个生产者的元素个数
+ *   ./queue_benchmark --max-producers 16
+ *
+ * 生产者个数从 1 开始每次翻倍直到 --max-producers（默认 8）；mpsc_queue 只有 1 个消费者，
+ * 另外两种队列再各跑一组 2 个消费者的。计时从所有线程同时开始到最后一个元素出队为止。
+ * 输出格式：queue,producers,consumers,items,mops_per_sec
+ * 生产者和消费者的线程数之和超过 CPU 核数时，数字反映的是调度而不是队列本身的扩展性 */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../CheamSTL/concurrent_queue.h"
+#include "../CheamSTL/list.h"
+
+namespace
+{
+
+    /* 对照组：用互斥锁保护的 list，也就是这些队列要替代的写法 */
+    class locked_list
+    {
+        cheamstl::list<long> items_;
+        std::mutex mtx_;
+
+    public:
+        void push(long v)
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            items_.push_back(v);
+        }
+
+        bool try_pop(long &out)
+        {
+            std::lock_guard<std::mutex> lock(mtx_);
+            if (items_.empty())
+                return false;
+            out = items_.front();
+            items_.pop_front();
+            return true;
+        }
+    };
+
+    volatile long sink;
+
+    template <class Queue>
+    void run(const char *name, size_t producers, size_t consumers, size_t items)
+    {
+        Queue q;
+        const size_t total = producers * items;
+        std::atomic<size_t> popped(0);
+        std::atomic<size_t> ready(0);
+        std::atomic<bool> go(false);
+
+        std::vector<std::thread> threads;
+        for (size_t p = 0; p < producers; ++p)
+        {
+            threads.emplace_back([&]()
+                                 {
+                ready.fetch_add(1);
+                while (!go.load(std::memory_order_acquire))
+                    std::this_thread::yield();
+                for (size_t i = 0; i < items; ++i)
+                    q.push(static_cast<long>(i)); });
+        }
+        for (size_t c = 0; c < consumers; ++c)
+        {
+            threads.emplace_back([&]()
+                                 {
+                ready.fetch_add(1);
+                while (!go.load(std::memory_order_acquire))
+                    std::this_thread::yield();
+                long v, sum = 0;
+                while (popped.load(std::memory_order_relaxed) < total)
+                {
+                    if (q.try_pop(v))
+                    {
+                        sum += v;
+                        popped.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    else
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+                sink = sum; });
+        }
+        while (ready.load() != producers + consumers)
+            std::this_thread::yield();
+
+        auto start = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for (auto &t : threads)
+            t.join();
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::printf("%s,%zu,%zu,%zu,%.2f\n", name, producers, consumers, total, total / sec / 1e6);
+        std::fflush(stdout);
+    }
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    size_t items = 1000000;
+    size_t max_producers = 8;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--items") == 0 && i + 1 < argc)
+            items = std::strtoull(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--max-producers") == 0 && i + 1 < argc)
+            max_producers = std::strtoull(argv[++i], nullptr, 10);
+        else
+        {
+            std::fprintf(stderr, "usage: %s [--items N] [--max-producers P]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::fprintf(stderr, "hardware threads: %u\n", std::thread::hardware_concurrency());
+    std::printf("queue,producers,consumers,items,mops_per_sec\n");
+    for (size_t p = 1; p <= max_producers; p *= 2)
+    {
+        run<locked_list>("list+mutex", p, 1, items);
+        run<cheamstl::mpsc_queue<long>>("mpsc_queue", p, 1, items);
+        run<cheamstl::concurrent_queue<long>>("concurrent_queue", p, 1, items);
+        run<locked_list>("list+mutex", p, 2, items);
+        run<cheamstl::concurrent_queue<long>>("concurrent_queue", p, 2, items);
+    }
+    return 0;
+}
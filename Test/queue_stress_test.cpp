@@ -0,0 +1,177 @@
+/* mpsc_queue / concurrent_queue 的压力测试，配合 ThreadSanitizer 使用
+ *
+ * 编译（Linux）：g++ -O1 -g -std=c++11 -pthread -fsanitize=thread Test/queue_stress_test.cpp -o queue_stress_test
+ * 运行：
+ *   ./queue_stress_test                 每个生产者默认入队 100000 个元素
+ *   ./queue_stress_test --items 20000   修改每个生产者的元素个数
+ *
+ * concurrent_queue 用 4 个生产者 + 3 个消费者，mpsc_queue 用 4 个生产者 + 1 个消费者（只允许一个消费者），
+ * 节点分别来自 allocator 和 thread_cache_allocator。元素带一个堆上的字符串，构造、移动和析构都会被检查到。
+ * 检查：每个元素恰好出队一次、内容完整，并且每个消费者看到的同一生产者的元素保持入队顺序。
+ * 全部通过时输出 "all checks passed" 并返回 0；数据竞争由 ThreadSanitizer 报告。
+ * GCC 会提示 ThreadSanitizer 不支持 atomic_thread_fence：hazard_domain::scan 开头有一个 seq_cst fence，
+ * ThreadSanitizer 不把它当作同步，只可能多报，不会因此漏报 */
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../CheamSTL/concurrent_queue.h"
+
+namespace
+{
+
+    int failures = 0;
+
+#define CHECK(expr)                                                              \
+    do                                                                           \
+    {                                                                            \
+        if (!(expr))                                                             \
+        {                                                                        \
+            std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #expr); \
+            ++failures;                                                          \
+        }                                                                        \
+    } while (0)
+
+    struct item
+    {
+        unsigned producer;
+        unsigned seq;
+        std::string tag; // 超过短字符串优化的长度，保证在堆上
+
+        item() : producer(0), seq(0) {}
+        item(unsigned p, unsigned s) : producer(p), seq(s), tag(make_tag(p, s)) {}
+
+        static std::string make_tag(unsigned p, unsigned s)
+        {
+            return "producer-" + std::to_string(p) + "-item-" + std::to_string(s);
+        }
+    };
+
+    /* 一个消费者按出队顺序记下的 (producer, seq) */
+    struct consumer_log
+    {
+        std::vector<unsigned> producer;
+        std::vector<unsigned> seq;
+        size_t corrupted = 0;
+    };
+
+    template <class Queue>
+    void pop_until_done(Queue &q, std::atomic<size_t> &popped, size_t total, consumer_log &log)
+    {
+        item it;
+        while (popped.load(std::memory_order_relaxed) < total)
+        {
+            if (!q.try_pop(it))
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            popped.fetch_add(1, std::memory_order_relaxed);
+            if (it.tag != item::make_tag(it.producer, it.seq))
+                ++log.corrupted;
+            log.producer.push_back(it.producer);
+            log.seq.push_back(it.seq);
+        }
+    }
+
+    template <class Queue>
+    void stress(const char *name, size_t producers, size_t consumers, size_t items)
+    {
+        Queue q;
+        std::atomic<size_t> popped(0);
+        const size_t total = producers * items;
+        std::vector<consumer_log> logs(consumers);
+        std::atomic<bool> go(false);
+
+        std::vector<std::thread> threads;
+        for (size_t p = 0; p < producers; ++p)
+        {
+            threads.emplace_back([&, p]()
+                                 {
+                while (!go.load(std::memory_order_acquire))
+                    std::this_thread::yield();
+                for (size_t s = 0; s < items; ++s)
+                    q.emplace(static_cast<unsigned>(p), static_cast<unsigned>(s)); });
+        }
+        for (size_t c = 0; c < consumers; ++c)
+        {
+            threads.emplace_back([&, c]()
+                                 {
+                while (!go.load(std::memory_order_acquire))
+                    std::this_thread::yield();
+                pop_until_done(q, popped, total, logs[c]); });
+        }
+        go.store(true, std::memory_order_release);
+        for (auto &t : threads)
+            t.join();
+
+        std::vector<std::vector<unsigned char>> seen(producers, std::vector<unsigned char>(items, 0));
+        size_t received = 0, duplicates = 0, out_of_order = 0, corrupted = 0;
+        for (const consumer_log &log : logs)
+        {
+            corrupted += log.corrupted;
+            std::vector<long long> last(producers, -1);
+            for (size_t i = 0; i < log.seq.size(); ++i)
+            {
+                unsigned p = log.producer[i], s = log.seq[i];
+                if (p >= producers || s >= items)
+                {
+                    ++corrupted;
+                    continue;
+                }
+                if (seen[p][s]++)
+                    ++duplicates;
+                if (static_cast<long long>(s) <= last[p])
+                    ++out_of_order;
+                last[p] = s;
+                ++received;
+            }
+        }
+
+        std::printf("%s: %zu producers, %zu consumers, %zu items: received %zu, duplicates %zu, "
+                    "out of order %zu, corrupted %zu\n",
+                    name, producers, consumers, total, received, duplicates, out_of_order, corrupted);
+        CHECK(received == total);
+        CHECK(duplicates == 0);
+        CHECK(out_of_order == 0);
+        CHECK(corrupted == 0);
+        item rest;
+        CHECK(!q.try_pop(rest));
+    }
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    size_t items = 100000;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--items") == 0 && i + 1 < argc)
+            items = std::strtoull(argv[++i], nullptr, 10);
+        else
+        {
+            std::fprintf(stderr, "usage: %s [--items N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    stress<cheamstl::concurrent_queue<item>>("concurrent_queue<allocator>", 4, 3, items);
+    stress<cheamstl::concurrent_queue<item, cheamstl::thread_cache_allocator<item>>>(
+        "concurrent_queue<thread_cache_allocator>", 4, 3, items);
+    stress<cheamstl::mpsc_queue<item>>("mpsc_queue<allocator>", 4, 1, items);
+    stress<cheamstl::mpsc_queue<item, cheamstl::thread_cache_allocator<item>>>("mpsc_queue<thread_cache_allocator>",
+                                                                              4, 1, items);
+
+    if (failures != 0)
+    {
+        std::printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}